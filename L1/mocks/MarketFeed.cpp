@@ -1,42 +1,110 @@
 #include <iostream>
 #include <chrono>
-#include <vector>
 #include <cstring>
-#include <sys/socket.h>
-#include <unistd.h>
+#include <string>
 
-struct MarketData {
-    uint64_t timestamp;
-    double price;
-    uint32_t volume;
-};
+#include "feed_receiver.hpp"
+#include "feed_sequencer.hpp"
+#include "multicast_feed.hpp"
+#include "uring_feed_receiver.hpp"
+#include "wire_format.hpp"
 
-// Parsing function (works on raw bytes, no extra allocations)
-inline MarketData parse(const char* buffer) {
-    MarketData data;
-    std::memcpy(&data, buffer, sizeof(MarketData));
-    return data;
+// Parsing function (works on raw bytes, no copy): a bounds check and a pointer cast
+inline const WireMessage* parse(const char* buffer, size_t size) {
+    return decode_message(std::as_bytes(std::span(buffer, size)));
 }
 
-int main() {
-    char buffer[sizeof(MarketData)];
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    // Assume already connected...
+// Receives messages from the sequencer in order. On the multicast feed,
+// recovery requests go to the publisher's side channel; on TCP they are only
+// reported.
+struct FeedHandler {
+    double checksum = 0;
+    MulticastFeedReceiver<WireMessage>* recovery = nullptr;
+
+    void on_sequenced(const WireMessage& message) {
+        // Decision logic here (fast math, no heap allocation)
+        if (message.header.type == MessageType::Trade) {
+            checksum += message.price_as_double() * message.quantity;
+        }
+    }
+
+    void on_replay_request(uint16_t channel, uint64_t first, uint64_t last) {
+        std::cout << "Gap on channel " << channel << ": replay " << first << ".." << last << "\n";
+        if (recovery) recovery->request_replay(channel, first, last);
+    }
+
+    void on_snapshot_request(uint16_t channel, uint64_t from) {
+        std::cout << "Channel " << channel << " too far behind: snapshot from " << from << "\n";
+        if (recovery) recovery->request_snapshot(channel, from);
+    }
+};
+
+// Same loop over either backend: both hand out framed records as spans
+template<typename Feed>
+void consume(Feed& feed, const char* backend, MulticastFeedReceiver<WireMessage>* recovery = nullptr) {
+    const uint64_t target = 1000000;
+    FeedHandler handler{0, recovery};
+    FeedSequencer<FeedHandler> sequencer(handler, 16, {.window = 1024});
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    for (int i = 0; i < 1000000; i++) {
-        read(sock, buffer, sizeof(buffer));
-        MarketData md = parse(buffer);
-        // Decision logic here (fast math, no heap allocation)
+    uint64_t count = 0;
+    uint64_t rejected = 0;
+    while (count < target and not feed.closed()) {
+        // Every record the kernel had queued, framed in place: no per-tick syscall or copy
+        auto records = feed.receive();
+        if (records.empty()) {
+            feed.wait(1);  // Nothing queued: sleep in the kernel rather than spin
+            continue;
+        }
+        for (const WireMessage& message : records) {
+            ++count;
+            if (message.header.version != wire_version) {
+                ++rejected;
+                continue;
+            }
+            if (is_snapshot_reply(message)) {
+                // State messages bypass the sequencer; the end marker resumes it
+                if (message.header.type == MessageType::SnapshotEnd) {
+                    sequencer.on_snapshot(message.header.channel, message.header.sequence);
+                } else {
+                    handler.on_sequenced(message);
+                }
+                continue;
+            }
+            sequencer.on_message(message);
+        }
     }
 
     auto end = std::chrono::high_resolution_clock::now();
     std::cout << "Elapsed: "
               << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
               << " us\n";
+    std::cout << backend << ": " << count << " records, " << feed.syscalls() << " syscalls ("
+              << (feed.syscalls() ? static_cast<double>(count) / feed.syscalls() : 0.0)
+              << " per syscall), " << rejected << " rejected, checksum " << handler.checksum << "\n";
+    std::cout << "Sequencer: " << sequencer.stats().delivered << " delivered, " << sequencer.stats().reordered
+              << " reordered, " << sequencer.stats().duplicates << " duplicates, "
+              << sequencer.stats().replay_requests << " replay requests\n";
+}
 
-    close(sock);
+// Usage: MarketFeed [recv|uring|multicast]
+// multicast joins the default MulticastConfig group, as published by
+// OrderBook/book_feed.
+int main(int argc, char** argv) {
+    std::string backend = argc > 1 ? argv[1] : "recv";
+    if (backend == "multicast") {
+        MulticastFeedReceiver<WireMessage> feed(MulticastConfig{});
+        consume(feed, "multicast", &feed);
+        return 0;
+    }
+    int sock = connect_feed("localhost", 5555);
+    if (backend == "uring") {
+        UringFeedReceiver<WireMessage> feed(sock);
+        consume(feed, "io_uring");
+    } else {
+        FeedReceiver<WireMessage> feed(sock);
+        consume(feed, "recv");
+    }
     return 0;
 }
-
@@ -6,12 +6,19 @@ import time
 HOST = 'localhost'
 PORT = 5555
 
-def generate_market_data():
-    """Generates infinite market data packets"""
+# Wire format version 1, see wire_format.hpp: 24-byte header + 24-byte body
+WIRE_FORMAT = '<BBHIQQQqIB3x'
+WIRE_VERSION = 1
+PRICE_SCALE = 10000
+TRADE = 3
+
+def generate_market_data(sequence):
+    """Generates one Trade message"""
     timestamp = int(time.time() * 1e9)  # nanosecond precision
     price = 100.0 + (time.time() % 10)  # oscillating price
     volume = 100
-    return struct.pack('QdI', timestamp, price, volume)  # 8+8+4 = 20 bytes
+    return struct.pack(WIRE_FORMAT, WIRE_VERSION, TRADE, 0, 1, sequence, timestamp,
+                       0, int(price * PRICE_SCALE), volume, 0)  # 48 bytes
 
 def main():
     with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
@@ -23,9 +30,11 @@ def main():
         with conn:
             print(f"Connected by {addr}")
             try:
+                sequence = 1
                 while True:
-                    data = generate_market_data()
+                    data = generate_market_data(sequence)
                     conn.sendall(data)
+                    sequence += 1
             except (ConnectionResetError, BrokenPipeError):
                 print("Client disconnected")
 
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+// Feed client side of a TCP market data stream of fixed-size records.
+//
+// One recv() pulls in as many bytes as the kernel has queued, up to the free
+// space of a large buffer, instead of one read() per record. Complete records
+// are framed in place and handed out as a span over the buffer; the partial
+// record a short read leaves at the end is moved to the front on the next
+// call, so records never straddle the wrap and need no copy.
+
+inline std::system_error feed_error(const char* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+// Connects to host:port and returns a non-blocking socket with Nagle off and a
+// large kernel receive buffer, so bursts queue in the kernel between polls
+inline int connect_feed(const std::string& host, uint16_t port, int kernel_buffer = 4 << 20) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        throw std::runtime_error("connect_feed: cannot resolve " + host);
+    }
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        throw feed_error("connect_feed: socket");
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kernel_buffer, sizeof(kernel_buffer));
+    int status = ::connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (status < 0) {
+        auto error = feed_error("connect_feed: connect");
+        close(fd);
+        throw error;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Record must be trivially copyable and laid out exactly as on the wire
+template<typename Record>
+class FeedReceiver {
+    static_assert(std::is_trivially_copyable_v<Record>);
+
+public:
+    // Takes ownership of a connected, non-blocking stream socket
+    explicit FeedReceiver(int fd, size_t buffer_records = 64 * 1024)
+        : fd_(fd), buffer_(buffer_records < 2 ? 2 : buffer_records) {
+        // The socket is ours from here on, so it is closed on every failure
+        epoll_ = epoll_create1(0);
+        if (epoll_ < 0) {
+            auto error = feed_error("FeedReceiver: epoll_create1");
+            close(fd_);
+            throw error;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd_;
+        if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd_, &event) < 0) {
+            auto error = feed_error("FeedReceiver: epoll_ctl");
+            close(epoll_);
+            close(fd_);
+            throw error;
+        }
+    }
+
+    FeedReceiver(const FeedReceiver&) = delete;
+    FeedReceiver& operator=(const FeedReceiver&) = delete;
+
+    ~FeedReceiver() {
+        close(epoll_);
+        close(fd_);
+    }
+
+    // Non-blocking: releases the span returned last time, does at most one
+    // recv(), and returns every complete record now buffered, possibly none.
+    // The span stays valid until the next call.
+    std::span<const Record> receive() {
+        release();
+        size_t capacity = buffer_.size() * sizeof(Record);
+        if (!closed_ && filled_ < capacity) {
+            ssize_t received = recv(fd_, bytes() + filled_, capacity - filled_, 0);
+            ++syscalls_;
+            if (received > 0) {
+                filled_ += static_cast<size_t>(received);
+                bytes_received_ += static_cast<uint64_t>(received);
+            } else if (received == 0) {
+                closed_ = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                throw feed_error("FeedReceiver: recv");
+            }
+        }
+        framed_ = filled_ / sizeof(Record);
+        return {buffer_.data(), framed_};
+    }
+
+    // Blocks until the socket is readable, the peer closed, or timeout_ms
+    // passes (-1 = forever); for callers that would rather sleep than spin
+    bool wait(int timeout_ms) {
+        epoll_event event;
+        int ready = epoll_wait(epoll_, &event, 1, timeout_ms);
+        if (ready < 0 && errno != EINTR) throw feed_error("FeedReceiver: epoll_wait");
+        return ready > 0;
+    }
+
+    // Peer closed the stream; records already buffered are still returned
+    bool closed() const { return closed_; }
+    int fd() const { return fd_; }
+    uint64_t syscalls() const { return syscalls_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+
+private:
+    std::byte* bytes() { return reinterpret_cast<std::byte*>(buffer_.data()); }
+
+    // Drops the records handed out last time and moves the partial tail, always
+    // shorter than one record, to the front
+    void release() {
+        size_t consumed = framed_ * sizeof(Record);
+        if (consumed == 0) return;
+        size_t tail = filled_ - consumed;
+        if (tail) std::memmove(bytes(), bytes() + consumed, tail);
+        filled_ = tail;
+        framed_ = 0;
+    }
+
+    int fd_;
+    int epoll_ = -1;
+    std::vector<Record> buffer_;  // Storage in whole records, so framed records are aligned
+    size_t filled_ = 0;           // Bytes received and not yet released
+    size_t framed_ = 0;           // Records handed out by the last receive()
+    bool closed_ = false;
+    uint64_t syscalls_ = 0;
+    uint64_t bytes_received_ = 0;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "wire_format.hpp"
+
+// Per-channel sequencing stage between the receive loop and the book.
+//
+// In-order messages go straight to the handler without a copy. A message
+// ahead of the next expected sequence is parked in a bounded reorder window;
+// if the hole is not filled by reordering within reorder_ns (exchange time),
+// the handler is asked for a replay of the missing range, and the request is
+// repeated every retry_ns until the hole closes. Replayed messages are fed
+// back through on_message() like live ones; duplicates are dropped.
+//
+// A message too far ahead for the window means the book cannot be caught up
+// by replay in bounded memory. The window then slides forward, keeping the
+// newest messages, and the handler is asked for a snapshot; on_snapshot()
+// resumes from the snapshot's sequence. Nothing here ever blocks, so a
+// recovery in progress does not stall the live path or other channels.
+//
+// Handler must provide:
+//   void on_sequenced(const WireMessage&);                             // In order, exactly once
+//   void on_replay_request(uint16_t channel, uint64_t first, uint64_t last);
+//   void on_snapshot_request(uint16_t channel, uint64_t from);        // Needs state at >= from - 1
+template<typename Handler>
+class FeedSequencer {
+public:
+    struct Config {
+        size_t window = 4096;                 // Messages parked per channel; rounded up to a power of two
+        uint64_t reorder_ns = 200'000;        // Grace for reordering before asking for a replay
+        uint64_t retry_ns = 20'000'000;       // Replay re-request interval
+    };
+
+    struct Stats {
+        uint64_t delivered = 0;
+        uint64_t duplicates = 0;
+        uint64_t reordered = 0;               // Parked in the window, later delivered or dropped
+        uint64_t replay_requests = 0;
+        uint64_t snapshot_requests = 0;
+        uint64_t dropped = 0;                 // Overtaken while a snapshot was needed
+    };
+
+    FeedSequencer(Handler& handler, uint16_t channels, Config config)
+        : handler_(handler), config_(config) {
+        size_t window = 2;
+        while (window < config.window) window <<= 1;
+        config_.window = window;
+        channels_.resize(channels);
+        for (Channel& channel : channels_) channel.slots.resize(window);
+    }
+
+    FeedSequencer(Handler& handler, uint16_t channels) : FeedSequencer(handler, channels, Config{}) {}
+
+    void on_message(const WireMessage& message) {
+        uint16_t id = message.header.channel;
+        if (id >= channels_.size()) {
+            throw std::runtime_error("FeedSequencer: unknown channel " + std::to_string(id));
+        }
+        Channel& channel = channels_[id];
+        uint64_t sequence = message.header.sequence;
+        uint64_t now = message.header.timestamp_ns;
+
+        if (message.header.type == MessageType::Heartbeat) {
+            // Carries the last sequence sent, so a lost tail shows up on an idle channel
+            if (sequence >= channel.expected) note_hole(id, channel, sequence, now);
+            return;
+        }
+        if (sequence == channel.expected && channel.parked == 0 && !channel.stale) {
+            // Fast path: in order, nothing parked
+            deliver(channel, message);
+            return;
+        }
+        if (sequence < channel.expected) {
+            ++stats_.duplicates;
+            return;
+        }
+        if (sequence - channel.expected >= config_.window) {
+            slide(id, channel, sequence - config_.window + 1);
+        }
+
+        WireMessage& slot = channel.slots[sequence & (config_.window - 1)];
+        if (slot.header.sequence == sequence) {
+            ++stats_.duplicates;
+            return;
+        }
+        slot = message;
+        ++channel.parked;
+        ++stats_.reordered;
+        if (sequence > channel.highest) channel.highest = sequence;
+        drain(channel);
+        if (channel.parked) note_hole(id, channel, channel.highest, now);
+    }
+
+    // The book was rebuilt from a snapshot taken at `sequence`; continue after it
+    void on_snapshot(uint16_t id, uint64_t sequence) {
+        Channel& channel = channels_.at(id);
+        if (sequence + 1 < channel.expected) {
+            // Older than what the window already dropped: it cannot be caught up, ask again
+            ++stats_.snapshot_requests;
+            handler_.on_snapshot_request(id, channel.expected);
+            return;
+        }
+        discard_below(channel, sequence + 1);
+        channel.expected = sequence + 1;
+        channel.stale = false;
+        channel.hole = false;
+        channel.requested = false;
+        drain(channel);
+    }
+
+    uint64_t expected(uint16_t id) const { return channels_.at(id).expected; }
+    bool has_hole(uint16_t id) const { return channels_.at(id).parked != 0 || channels_.at(id).stale; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Channel {
+        uint64_t expected = 1;        // Next sequence to deliver
+        uint64_t highest = 0;         // Highest sequence seen ahead of a hole
+        size_t parked = 0;
+        bool hole = false;            // Something below `highest` is missing
+        bool requested = false;       // A replay of the hole was requested
+        bool stale = false;           // Snapshot requested and not yet applied
+        uint64_t hole_since_ns = 0;
+        uint64_t requested_ns = 0;    // Last replay request
+        std::vector<WireMessage> slots;  // Indexed by sequence; header.sequence says who is there
+    };
+
+    void deliver(Channel& channel, const WireMessage& message) {
+        ++channel.expected;
+        ++stats_.delivered;
+        close_filled_hole(channel);  // Replays usually arrive in order, through the fast path
+        handler_.on_sequenced(message);
+    }
+
+    // Clears the hole once everything up to `highest` is delivered, so the next
+    // hole gets its own reorder grace and request
+    void close_filled_hole(Channel& channel) {
+        if (channel.hole && channel.parked == 0 && channel.highest < channel.expected) {
+            channel.hole = false;
+            channel.requested = false;
+        }
+    }
+
+    // Delivers every parked message that is now in order; nothing while waiting for a snapshot
+    void drain(Channel& channel) {
+        while (channel.parked && !channel.stale) {
+            WireMessage& slot = channel.slots[channel.expected & (config_.window - 1)];
+            if (slot.header.sequence != channel.expected) break;
+            --channel.parked;
+            deliver(channel, slot);
+            slot.header.sequence = 0;
+        }
+        close_filled_hole(channel);
+    }
+
+    void note_hole(uint16_t id, Channel& channel, uint64_t last, uint64_t now) {
+        if (channel.stale) return;  // A snapshot supersedes replays
+        if (last > channel.highest) channel.highest = last;
+        if (!channel.hole) {
+            channel.hole = true;
+            channel.hole_since_ns = now;
+        }
+        // Exchange time can step back across channels or replays; only count forward progress
+        bool first = !channel.requested && now >= channel.hole_since_ns + config_.reorder_ns;
+        bool retry = channel.requested && now >= channel.requested_ns + config_.retry_ns;
+        if (first || retry) {
+            channel.requested = true;
+            channel.requested_ns = now;
+            ++stats_.replay_requests;
+            handler_.on_replay_request(id, channel.expected, channel.highest);
+        }
+    }
+
+    // Gives up on everything below `first`: the window moves up to keep the newest messages
+    void slide(uint16_t id, Channel& channel, uint64_t first) {
+        discard_below(channel, first);
+        channel.expected = first;
+        if (!channel.stale) {
+            channel.stale = true;
+            ++stats_.snapshot_requests;
+            handler_.on_snapshot_request(id, first);
+        }
+    }
+
+    void discard_below(Channel& channel, uint64_t first) {
+        uint64_t end = std::min(first, channel.expected + config_.window);
+        for (uint64_t sequence = channel.expected; sequence < end && channel.parked; ++sequence) {
+            WireMessage& slot = channel.slots[sequence & (config_.window - 1)];
+            if (slot.header.sequence == sequence) {
+                slot.header.sequence = 0;
+                --channel.parked;
+                ++stats_.dropped;
+            }
+        }
+    }
+
+    Handler& handler_;
+    Config config_;
+    std::vector<Channel> channels_;
+    Stats stats_;
+};
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "multicast_feed.hpp"
+#include "wire_format.hpp"
+
+// Native replacement for dummy_market_server.py: a load generator that
+// speaks wire_format.hpp at configurable rates, so the C++ client can be
+// driven at (and past) real peak-open rates.
+//
+// Messages are a configurable mix of adds, cancels and trades over many
+// instruments; cancels and trades only name orders that are live. A steady
+// base rate is overlaid with bursts arriving as a Poisson process, and
+// messages go out in batches of up to --batch per send(), so the generator
+// is seldom the bottleneck. Sequence numbers are per channel, with instrument
+// i on channel i % channels, and --pcap writes every batch to a capture file
+// as UDP datagrams of at most records_per_datagram (30) records, as a
+// multicast feed on a 1500-byte MTU would carry it.
+//
+// Usage: market_sim [--port=5555] [--rate=1000000] [--count=0] [--instruments=100]
+//                   [--channels=1] [--mix=50:35:15] [--burst-rate=0] [--burst-size=5000]
+//                   [--batch=64] [--seed=1] [--pcap=file]
+// --rate=0 sends as fast as the socket drains; --count=0 runs until the client leaves.
+
+namespace {
+
+struct SimConfig {
+    uint16_t port = 5555;
+    double rate = 1000000;        // Base messages per second
+    uint64_t count = 0;
+    uint32_t instruments = 100;
+    uint16_t channels = 1;
+    unsigned add_weight = 50, cancel_weight = 35, trade_weight = 15;
+    double burst_rate = 0;        // Bursts per second, Poisson
+    double burst_size = 5000;     // Mean messages per burst, Poisson
+    size_t batch = 64;
+    uint64_t seed = 1;
+    std::string pcap;
+};
+
+SimConfig parse_args(int argc, char** argv) {
+    SimConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || equals == std::string::npos) {
+            throw std::runtime_error("expected --name=value, got " + arg);
+        }
+        std::string name = arg.substr(2, equals - 2), value = arg.substr(equals + 1);
+        if (name == "port") config.port = static_cast<uint16_t>(std::stoul(value));
+        else if (name == "rate") config.rate = std::stod(value);
+        else if (name == "count") config.count = std::stoull(value);
+        else if (name == "instruments") config.instruments = static_cast<uint32_t>(std::stoul(value));
+        else if (name == "channels") config.channels = static_cast<uint16_t>(std::stoul(value));
+        else if (name == "burst-rate") config.burst_rate = std::stod(value);
+        else if (name == "burst-size") config.burst_size = std::stod(value);
+        else if (name == "batch") config.batch = std::stoul(value);
+        else if (name == "seed") config.seed = std::stoull(value);
+        else if (name == "pcap") config.pcap = value;
+        else if (name == "mix") {
+            if (std::sscanf(value.c_str(), "%u:%u:%u", &config.add_weight, &config.cancel_weight, &config.trade_weight) != 3) {
+                throw std::runtime_error("--mix wants add:cancel:trade weights");
+            }
+        } else {
+            throw std::runtime_error("unknown option --" + name);
+        }
+    }
+    if (config.instruments == 0 || config.channels == 0 || config.batch == 0) {
+        throw std::runtime_error("instruments, channels and batch must be positive");
+    }
+    if (config.add_weight + config.cancel_weight + config.trade_weight == 0) {
+        throw std::runtime_error("--mix weights are all zero");
+    }
+    return config;
+}
+
+uint64_t wall_clock_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Order flow with a random-walk mid per instrument; cancels and trades pick a
+// live order of the instrument, and fall back to an add when it has none
+class MessageGenerator {
+public:
+    explicit MessageGenerator(const SimConfig& config)
+        : config_(config), rng_(config.seed), books_(config.instruments), sequences_(config.channels, 0),
+          kind_({static_cast<double>(config.add_weight), static_cast<double>(config.cancel_weight),
+                 static_cast<double>(config.trade_weight)}),
+          instrument_(0, config.instruments - 1) {
+        for (Book& book : books_) book.mid = 100 * wire_price_scale;
+    }
+
+    void next(WireMessage& message, uint64_t timestamp_ns) {
+        uint32_t instrument = instrument_(rng_);
+        Book& book = books_[instrument];
+        int kind = kind_(rng_);
+        if (book.live.empty()) kind = 0;
+
+        message = WireMessage{};
+        message.header.version = wire_version;
+        message.header.instrument = instrument;
+        message.header.channel = static_cast<uint16_t>(instrument % config_.channels);
+        message.header.sequence = ++sequences_[message.header.channel];
+        message.header.timestamp_ns = timestamp_ns;
+
+        if (kind == 0) {
+            book.mid += static_cast<int64_t>(rng_() % 3) - 1;
+            bool buy = rng_() & 1;
+            int64_t offset = 1 + static_cast<int64_t>(rng_() % 20);
+            LiveOrder order{++next_order_id_, buy ? book.mid - offset : book.mid + offset,
+                            static_cast<uint32_t>(1 + rng_() % 10) * 100, buy};
+            book.live.push_back(order);
+            fill(message, MessageType::AddOrder, order, order.quantity);
+            return;
+        }
+
+        size_t index = rng_() % book.live.size();
+        LiveOrder& order = book.live[index];
+        if (kind == 2 && order.quantity > 100) {
+            // Partial fill; the aggressor is on the other side
+            order.quantity -= 100;
+            fill(message, MessageType::Trade, order, 100);
+            message.side = order.buy ? WireSide::Sell : WireSide::Buy;
+            return;
+        }
+        fill(message, kind == 1 ? MessageType::CancelOrder : MessageType::Trade, order, order.quantity);
+        if (kind == 2) message.side = order.buy ? WireSide::Sell : WireSide::Buy;
+        book.live[index] = book.live.back();
+        book.live.pop_back();
+    }
+
+    // Last sequence sent on a channel, for heartbeats
+    uint64_t sequence(uint16_t channel) const { return sequences_[channel]; }
+
+private:
+    struct LiveOrder {
+        uint64_t id;
+        int64_t price;
+        uint32_t quantity;
+        bool buy;
+    };
+
+    struct Book {
+        int64_t mid = 0;
+        std::vector<LiveOrder> live;
+    };
+
+    static void fill(WireMessage& message, MessageType type, const LiveOrder& order, uint32_t quantity) {
+        message.header.type = type;
+        message.order_id = order.id;
+        message.price = order.price;
+        message.quantity = quantity;
+        message.side = order.buy ? WireSide::Buy : WireSide::Sell;
+    }
+
+    const SimConfig& config_;
+    std::mt19937_64 rng_;
+    std::vector<Book> books_;
+    std::vector<uint64_t> sequences_;
+    std::discrete_distribution<int> kind_;  // 0 add, 1 cancel, 2 trade
+    std::uniform_int_distribution<uint32_t> instrument_;
+    uint64_t next_order_id_ = 0;
+};
+
+// Classic pcap, Ethernet link type; each batch becomes IPv4/UDP datagrams
+// from 10.0.0.1:30001 to the multicast group 239.1.1.1:30001, split to fit
+// the MTU as multicast_feed.hpp would send them
+class PcapWriter {
+public:
+    explicit PcapWriter(const std::string& path) : file_(std::fopen(path.c_str(), "wb")) {
+        if (!file_) throw std::runtime_error("cannot open " + path);
+        struct {
+            uint32_t magic = 0xa1b23c4d;  // Nanosecond timestamps
+            uint16_t major = 2, minor = 4;
+            int32_t zone = 0;
+            uint32_t sigfigs = 0, snaplen = 65535, link_type = 1;
+        } header;
+        std::fwrite(&header, sizeof(header), 1, file_);
+    }
+
+    PcapWriter(const PcapWriter&) = delete;
+    PcapWriter& operator=(const PcapWriter&) = delete;
+
+    ~PcapWriter() { std::fclose(file_); }
+
+    void write(const WireMessage* records, size_t count, uint64_t timestamp_ns) {
+        constexpr size_t per_datagram = records_per_datagram<WireMessage>;
+        for (size_t i = 0; i < count; i += per_datagram) {
+            write_datagram(records + i, std::min(per_datagram, count - i) * sizeof(WireMessage), timestamp_ns);
+        }
+    }
+
+private:
+    void write_datagram(const void* payload, size_t size, uint64_t timestamp_ns) {
+        uint8_t frame[14 + 20 + 8] = {
+            0x01, 0x00, 0x5e, 0x01, 0x01, 0x01,  // Multicast MAC for 239.1.1.1
+            0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+            0x08, 0x00,                          // IPv4
+        };
+        uint8_t* ip = frame + 14;
+        uint16_t ip_length = static_cast<uint16_t>(20 + 8 + size);
+        ip[0] = 0x45;
+        put16(ip + 2, ip_length);
+        put16(ip + 4, ++ip_id_);
+        ip[8] = 64;   // TTL
+        ip[9] = 17;   // UDP
+        const uint8_t source[4] = {10, 0, 0, 1}, group[4] = {239, 1, 1, 1};
+        std::memcpy(ip + 12, source, 4);
+        std::memcpy(ip + 16, group, 4);
+        put16(ip + 10, ip_checksum(ip));
+        uint8_t* udp = ip + 20;
+        put16(udp, 30001);
+        put16(udp + 2, 30001);
+        put16(udp + 4, static_cast<uint16_t>(8 + size));  // Checksum 0: not computed
+
+        uint32_t record[4] = {static_cast<uint32_t>(timestamp_ns / 1000000000ull),
+                              static_cast<uint32_t>(timestamp_ns % 1000000000ull),
+                              static_cast<uint32_t>(sizeof(frame) + size), static_cast<uint32_t>(sizeof(frame) + size)};
+        std::fwrite(record, sizeof(record), 1, file_);
+        std::fwrite(frame, sizeof(frame), 1, file_);
+        std::fwrite(payload, size, 1, file_);
+    }
+
+    static void put16(uint8_t* at, uint16_t value) {
+        at[0] = static_cast<uint8_t>(value >> 8);
+        at[1] = static_cast<uint8_t>(value);
+    }
+
+    static uint16_t ip_checksum(const uint8_t* header) {
+        uint32_t sum = 0;
+        for (int i = 0; i < 20; i += 2) sum += static_cast<uint32_t>(header[i] << 8 | header[i + 1]);
+        while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+        return static_cast<uint16_t>(~sum);
+    }
+
+    std::FILE* file_;
+    uint16_t ip_id_ = 0;
+};
+
+int accept_client(uint16_t port) {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(server, 1) < 0) {
+        throw std::runtime_error("cannot listen on port " + std::to_string(port));
+    }
+    std::cout << "Market simulator on localhost:" << port << "\n";
+    int client = accept(server, nullptr, nullptr);
+    close(server);
+    if (client < 0) throw std::runtime_error("accept failed");
+    int buffer = 4 << 20;
+    setsockopt(client, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+    return client;
+}
+
+// Sends all of `size` bytes; false once the client has gone
+bool send_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    try {
+        config = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    MessageGenerator generator(config);
+    std::unique_ptr<PcapWriter> pcap;
+    if (!config.pcap.empty()) pcap = std::make_unique<PcapWriter>(config.pcap);
+    int client = accept_client(config.port);
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937_64 burst_rng(config.seed ^ 0x5bd1e995);
+    std::exponential_distribution<double> burst_gap(config.burst_rate > 0 ? config.burst_rate : 1);
+    std::poisson_distribution<uint64_t> burst_messages(config.burst_size > 0 ? config.burst_size : 1);
+
+    std::vector<WireMessage> batch(config.batch);
+    auto start = Clock::now();
+    auto last_send = start;
+    auto next_report = start + std::chrono::seconds(1);
+    double next_burst = config.burst_rate > 0 ? burst_gap(burst_rng) : -1;  // Seconds since start
+    uint64_t burst_extra = 0, sent = 0, sent_at_report = 0, bursts = 0;
+    bool connected = true;
+
+    while (connected) {
+        auto now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        while (next_burst >= 0 && elapsed >= next_burst) {
+            burst_extra += burst_messages(burst_rng);
+            next_burst += burst_gap(burst_rng);
+            ++bursts;
+        }
+
+        // Messages owed by now: the base rate plus every burst so far
+        uint64_t due = config.rate > 0 ? static_cast<uint64_t>(elapsed * config.rate) + burst_extra : sent + config.batch;
+        if (config.count) due = std::min(due, config.count);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(due - std::min(due, sent), config.batch));
+
+        uint64_t timestamp = wall_clock_ns();
+        if (n == 0) {
+            if (config.count && sent >= config.count) break;
+            if (now - last_send > std::chrono::milliseconds(100)) {
+                // Idle: a heartbeat per channel carries the last sequence sent
+                for (uint16_t channel = 0; channel < config.channels && connected; ++channel) {
+                    WireMessage heartbeat{};
+                    heartbeat.header = {wire_version, MessageType::Heartbeat, channel, 0, generator.sequence(channel), timestamp};
+                    connected = send_all(client, &heartbeat, sizeof(heartbeat));
+                }
+                last_send = now;
+            }
+            // Let a client on the same core run; messages owed meanwhile go out as one batch
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+            continue;
+        }
+
+        for (size_t i = 0; i < n; ++i) generator.next(batch[i], timestamp);
+        if (!send_all(client, batch.data(), n * sizeof(WireMessage))) break;
+        if (pcap) pcap->write(batch.data(), n, timestamp);
+        sent += n;
+        last_send = now;
+
+        if (now >= next_report) {
+            std::cout << "Sent " << sent << " messages (" << sent - sent_at_report << "/s, " << bursts << " bursts)\n";
+            sent_at_report = sent;
+            next_report += std::chrono::seconds(1);
+        }
+    }
+    close(client);
+    std::cout << "Done: " << sent << " messages in "
+              << std::chrono::duration<double>(Clock::now() - start).count() << " s\n";
+    return 0;
+}
@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#include "feed_receiver.hpp"
+#include "wire_format.hpp"
+
+// UDP multicast transport for the feed, so any number of hosts can subscribe
+// to one stream instead of each holding a TCP connection to the server.
+//
+// A datagram is a run of whole wire_format.hpp messages, at most one MTU:
+// 30 WireMessages in 1440 bytes. They carry their own per-channel sequence
+// numbers, so datagrams need no header, and FeedSequencer finds losses and
+// reordering exactly as on TCP. The publisher queues messages into a batch
+// of datagrams and hands the batch to the kernel with one sendmmsg(); the
+// receiver takes every queued datagram with one recvmmsg() and hands them
+// out as one span of records, with the same receive()/wait() interface as
+// FeedReceiver, so MarketFeed's loop runs over it unchanged.
+//
+// Recovery is a unicast side channel. A receiver sends a RecoveryRequest to
+// the publisher's recovery port; the reply goes back to the socket it came
+// from, mixed in with the live datagrams:
+//
+//   Replay    the original messages, if the publisher's history still holds
+//             them; the sequencer drops any it already has
+//   Snapshot  the channel's state as messages with sequence 0 (BookClear,
+//             then LevelUpdates), then a SnapshotEnd whose sequence is the
+//             last message the state includes; is_snapshot_reply() picks
+//             these out ahead of the sequencer, and SnapshotEnd is the cue
+//             for FeedSequencer::on_snapshot()
+//
+// A replay that reaches past the history is answered with a snapshot. With
+// several receivers on one host sharing the port, unicast replies reach only
+// one of them; give each its own port and group in that case.
+
+constexpr size_t feed_datagram_bytes = 1472;  // 1500-byte Ethernet MTU less IPv4 and UDP headers
+
+template<typename Record>
+constexpr size_t records_per_datagram = feed_datagram_bytes / sizeof(Record);
+
+static_assert(records_per_datagram<WireMessage> == 30);
+
+struct MulticastConfig {
+    std::string group = "239.255.0.1";          // A unicast address also works, for one receiver
+    uint16_t port = 5556;
+    std::string interface = "0.0.0.0";          // Local address of the NIC to send and join on
+    int ttl = 1;                                // Router hops the feed may cross
+    bool loopback = true;                       // Deliver to receivers on the publishing host
+    std::string recovery_host = "127.0.0.1";    // Where receivers send recovery requests
+    uint16_t recovery_port = 5557;
+    int kernel_buffer = 4 << 20;
+};
+
+enum class RecoveryKind : uint8_t { Replay = 0, Snapshot = 1 };
+
+#pragma pack(push, 1)
+struct RecoveryRequest {
+    uint8_t version;        // wire_version
+    RecoveryKind kind;
+    uint16_t channel;
+    uint32_t reserved;
+    uint64_t first;         // Replay: first missing sequence; Snapshot: the receiver's next expected
+    uint64_t last;          // Replay: last missing sequence
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RecoveryRequest) == 24);
+
+// Part of a snapshot reply rather than a sequenced message
+inline bool is_snapshot_reply(const WireMessage& message) {
+    return message.header.type == MessageType::SnapshotEnd ||
+           (message.header.sequence == snapshot_sequence && message.header.type != MessageType::Heartbeat);
+}
+
+inline sockaddr_in feed_address(const std::string& host, uint16_t port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw std::runtime_error("feed_address: not an IPv4 address: " + host);
+    }
+    return address;
+}
+
+inline bool is_multicast(const sockaddr_in& address) { return IN_MULTICAST(ntohl(address.sin_addr.s_addr)); }
+
+// Wall-clock time, as the exchange stamps messages
+inline uint64_t feed_clock_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline int open_udp_socket(int buffer_option, int kernel_buffer) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) throw feed_error("open_udp_socket: socket");
+    setsockopt(fd, SOL_SOCKET, buffer_option, &kernel_buffer, sizeof(kernel_buffer));
+    return fd;
+}
+
+inline void bind_udp_socket(int fd, const sockaddr_in& address, const char* what) {
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        auto error = feed_error(what);
+        close(fd);
+        throw error;
+    }
+}
+
+// Outgoing messages packed into datagrams, sent together with sendmmsg()
+class DatagramBatch {
+public:
+    static constexpr size_t per_datagram = records_per_datagram<WireMessage>;
+
+    explicit DatagramBatch(size_t max_datagrams)
+        : messages_((max_datagrams ? max_datagrams : 1) * per_datagram),
+          iovecs_(messages_.size() / per_datagram), headers_(iovecs_.size()) {}
+
+    bool full() const { return count_ == messages_.size(); }
+    bool empty() const { return count_ == 0; }
+    void append(const WireMessage& message) { messages_[count_++] = message; }
+
+    // Sends every queued message, to `destination` or along the connected
+    // socket if null. Returns the number of sendmmsg() calls.
+    size_t send(int fd, const sockaddr_in* destination, uint64_t& datagrams) {
+        size_t count = (count_ + per_datagram - 1) / per_datagram;
+        for (size_t i = 0; i < count; ++i) {
+            size_t first = i * per_datagram;
+            size_t records = std::min(per_datagram, count_ - first);
+            iovecs_[i] = iovec{&messages_[first], records * sizeof(WireMessage)};
+            headers_[i] = mmsghdr{};
+            headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+            headers_[i].msg_hdr.msg_iovlen = 1;
+            headers_[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(destination);
+            headers_[i].msg_hdr.msg_namelen = destination ? sizeof(sockaddr_in) : 0;
+        }
+        size_t calls = 0;
+        for (size_t sent = 0; sent < count;) {
+            int result = sendmmsg(fd, headers_.data() + sent, static_cast<unsigned>(count - sent), 0);
+            ++calls;
+            if (result < 0) {
+                // A unicast peer that was not listening reports it on the next send, once
+                if (errno == EINTR || errno == ECONNREFUSED) continue;
+                count_ = 0;
+                throw feed_error("DatagramBatch: sendmmsg");
+            }
+            sent += static_cast<size_t>(result);
+        }
+        datagrams += count;
+        count_ = 0;
+        return calls;
+    }
+
+private:
+    std::vector<WireMessage> messages_;
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> headers_;
+    size_t count_ = 0;
+};
+
+// Sequences, batches and multicasts messages; keeps the last `history`
+// messages of each channel to answer replays
+class MulticastPublisher {
+public:
+    struct Stats {
+        uint64_t messages = 0;
+        uint64_t datagrams = 0;
+        uint64_t syscalls = 0;
+        uint64_t replays = 0;          // Replay requests answered from history
+        uint64_t snapshots = 0;        // Snapshot replies, asked for or in place of a replay
+        uint64_t bad_requests = 0;
+    };
+
+    MulticastPublisher(const MulticastConfig& config, uint16_t channels, size_t history = 65536,
+                       size_t batch_datagrams = 64)
+        : batch_(batch_datagrams), recovery_batch_(batch_datagrams) {
+        size_t slots = 2;
+        while (slots < history) slots <<= 1;
+        history_mask_ = slots - 1;
+        channels_.resize(channels);
+        for (Channel& channel : channels_) channel.history.resize(slots);
+
+        sockaddr_in group = feed_address(config.group, config.port);
+        fd_ = open_udp_socket(SO_SNDBUF, config.kernel_buffer);
+        if (is_multicast(group)) {
+            in_addr interface{};
+            inet_pton(AF_INET, config.interface.c_str(), &interface);
+            unsigned char ttl = static_cast<unsigned char>(config.ttl);
+            unsigned char loop = config.loopback ? 1 : 0;
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+            setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        }
+        if (::connect(fd_, reinterpret_cast<const sockaddr*>(&group), sizeof(group)) < 0) {
+            auto error = feed_error("MulticastPublisher: connect");
+            close(fd_);
+            throw error;
+        }
+        recovery_fd_ = open_udp_socket(SO_SNDBUF, config.kernel_buffer);
+        try {
+            bind_udp_socket(recovery_fd_, feed_address("0.0.0.0", config.recovery_port),
+                            "MulticastPublisher: bind recovery port");
+        } catch (...) {
+            close(fd_);
+            throw;
+        }
+    }
+
+    MulticastPublisher(const MulticastPublisher&) = delete;
+    MulticastPublisher& operator=(const MulticastPublisher&) = delete;
+
+    ~MulticastPublisher() {
+        close(recovery_fd_);
+        close(fd_);
+    }
+
+    // Stamps the version, the channel's next sequence and, if unset, the
+    // time, and queues the message; a full batch goes out at once. Returns
+    // the sequence.
+    uint64_t publish(WireMessage message) {
+        Channel& channel = channels_.at(message.header.channel);
+        message.header.version = wire_version;
+        message.header.sequence = ++channel.last;
+        if (message.header.timestamp_ns == 0) message.header.timestamp_ns = feed_clock_ns();
+        channel.history[channel.last & history_mask_] = message;
+        ++stats_.messages;
+        batch_.append(message);
+        if (batch_.full()) flush();
+        return channel.last;
+    }
+
+    // Sends everything queued
+    void flush() {
+        if (!batch_.empty()) stats_.syscalls += batch_.send(fd_, nullptr, stats_.datagrams);
+    }
+
+    // Flushes, then sends each channel's last sequence, so receivers notice a
+    // lost tail while the channel is quiet. Channels with nothing published
+    // stay silent: sequence 0 would read as a snapshot reply.
+    void heartbeat(uint64_t now_ns = 0) {
+        flush();
+        if (now_ns == 0) now_ns = feed_clock_ns();
+        for (size_t id = 0; id < channels_.size(); ++id) {
+            if (channels_[id].last == 0) continue;
+            WireMessage message{};
+            message.header = MessageHeader{wire_version, MessageType::Heartbeat, static_cast<uint16_t>(id), 0,
+                                           channels_[id].last, now_ns};
+            batch_.append(message);
+            if (batch_.full()) flush();
+        }
+        flush();
+    }
+
+    // Answers every recovery request already queued, without blocking.
+    // snapshot(channel, emit) must call emit(message) with the state of every
+    // instrument on `channel` as of the last message published there, so
+    // call it after publishing everything the books have produced. Returns
+    // the number of requests answered.
+    template<typename SnapshotFn>
+    size_t serve_recovery(SnapshotFn&& snapshot) {
+        size_t served = 0;
+        while (true) {
+            RecoveryRequest request;
+            sockaddr_in from{};
+            socklen_t from_length = sizeof(from);
+            ssize_t received = recvfrom(recovery_fd_, &request, sizeof(request), MSG_DONTWAIT,
+                                        reinterpret_cast<sockaddr*>(&from), &from_length);
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return served;
+                throw feed_error("MulticastPublisher: recvfrom");
+            }
+            if (static_cast<size_t>(received) != sizeof(request) || request.version != wire_version ||
+                request.channel >= channels_.size()) {
+                ++stats_.bad_requests;
+                continue;
+            }
+            ++served;
+            if (request.kind == RecoveryKind::Replay && can_replay(request)) {
+                replay(request, from);
+            } else {
+                send_snapshot(request.channel, from, snapshot);
+            }
+        }
+    }
+
+    uint64_t last_sequence(uint16_t channel) const { return channels_.at(channel).last; }
+    int fd() const { return fd_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Channel {
+        uint64_t last = 0;                  // Sequence of the last message published
+        std::vector<WireMessage> history;   // Indexed by sequence
+    };
+
+    bool can_replay(const RecoveryRequest& request) const {
+        const Channel& channel = channels_[request.channel];
+        uint64_t oldest = channel.last > history_mask_ + 1 ? channel.last - history_mask_ : 1;
+        return request.first >= oldest && request.first <= request.last && request.last <= channel.last;
+    }
+
+    void replay(const RecoveryRequest& request, const sockaddr_in& to) {
+        const Channel& channel = channels_[request.channel];
+        for (uint64_t sequence = request.first; sequence <= request.last; ++sequence) {
+            recovery_batch_.append(channel.history[sequence & history_mask_]);
+            if (recovery_batch_.full()) stats_.syscalls += recovery_batch_.send(recovery_fd_, &to, stats_.datagrams);
+        }
+        stats_.syscalls += recovery_batch_.send(recovery_fd_, &to, stats_.datagrams);
+        ++stats_.replays;
+    }
+
+    template<typename SnapshotFn>
+    void send_snapshot(uint16_t id, const sockaddr_in& to, SnapshotFn& snapshot) {
+        uint64_t now = feed_clock_ns();
+        auto emit = [&](WireMessage message) {
+            message.header.version = wire_version;
+            message.header.channel = id;
+            message.header.sequence = snapshot_sequence;
+            message.header.timestamp_ns = now;
+            recovery_batch_.append(message);
+            if (recovery_batch_.full()) stats_.syscalls += recovery_batch_.send(recovery_fd_, &to, stats_.datagrams);
+        };
+        snapshot(id, emit);
+        WireMessage end{};
+        end.header = MessageHeader{wire_version, MessageType::SnapshotEnd, id, 0, channels_[id].last, now};
+        recovery_batch_.append(end);
+        stats_.syscalls += recovery_batch_.send(recovery_fd_, &to, stats_.datagrams);
+        ++stats_.snapshots;
+    }
+
+    int fd_ = -1;
+    int recovery_fd_ = -1;
+    std::vector<Channel> channels_;
+    uint64_t history_mask_ = 0;
+    DatagramBatch batch_;
+    DatagramBatch recovery_batch_;
+    Stats stats_;
+};
+
+// Receives a multicast feed with recvmmsg(); a drop-in for FeedReceiver.
+// Record must be trivially copyable and laid out exactly as on the wire.
+template<typename Record>
+class MulticastFeedReceiver {
+    static_assert(std::is_trivially_copyable_v<Record>);
+
+public:
+    static constexpr size_t per_datagram = records_per_datagram<Record>;
+
+    explicit MulticastFeedReceiver(const MulticastConfig& config, size_t batch_datagrams = 64)
+        : buffer_((batch_datagrams ? batch_datagrams : 1) * per_datagram),
+          iovecs_(buffer_.size() / per_datagram), headers_(iovecs_.size()),
+          recovery_(feed_address(config.recovery_host, config.recovery_port)) {
+        sockaddr_in group = feed_address(config.group, config.port);
+        fd_ = open_udp_socket(SO_RCVBUF, config.kernel_buffer);
+        bind_udp_socket(fd_, feed_address("0.0.0.0", config.port), "MulticastFeedReceiver: bind");
+        if (is_multicast(group)) {
+            ip_mreq membership{};
+            membership.imr_multiaddr = group.sin_addr;
+            inet_pton(AF_INET, config.interface.c_str(), &membership.imr_interface);
+            if (setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+                auto error = feed_error("MulticastFeedReceiver: join group");
+                close(fd_);
+                throw error;
+            }
+        }
+        epoll_ = epoll_create1(0);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd_;
+        if (epoll_ < 0 || epoll_ctl(epoll_, EPOLL_CTL_ADD, fd_, &event) < 0) {
+            auto error = feed_error("MulticastFeedReceiver: epoll");
+            if (epoll_ >= 0) close(epoll_);
+            close(fd_);
+            throw error;
+        }
+        // Each datagram lands in its own stretch of whole records
+        for (size_t i = 0; i < iovecs_.size(); ++i) {
+            iovecs_[i] = iovec{&buffer_[i * per_datagram], per_datagram * sizeof(Record)};
+        }
+    }
+
+    MulticastFeedReceiver(const MulticastFeedReceiver&) = delete;
+    MulticastFeedReceiver& operator=(const MulticastFeedReceiver&) = delete;
+
+    ~MulticastFeedReceiver() {
+        close(epoll_);
+        close(fd_);
+    }
+
+    // Non-blocking: one recvmmsg() for every datagram queued, up to the
+    // batch. Records of short datagrams are moved down over the gap they
+    // leave, so the result is one span; it stays valid until the next call.
+    std::span<const Record> receive() {
+        for (size_t i = 0; i < headers_.size(); ++i) {
+            headers_[i] = mmsghdr{};
+            headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+            headers_[i].msg_hdr.msg_iovlen = 1;
+        }
+        int received = recvmmsg(fd_, headers_.data(), static_cast<unsigned>(headers_.size()), MSG_DONTWAIT, nullptr);
+        ++syscalls_;
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return {};
+            throw feed_error("MulticastFeedReceiver: recvmmsg");
+        }
+        size_t framed = 0;
+        for (int i = 0; i < received; ++i) {
+            size_t length = headers_[i].msg_len;
+            size_t records = length / sizeof(Record);
+            bytes_received_ += length;
+            if ((headers_[i].msg_hdr.msg_flags & MSG_TRUNC) || length % sizeof(Record) != 0) ++malformed_;
+            Record* first = &buffer_[static_cast<size_t>(i) * per_datagram];
+            if (records && first != &buffer_[framed]) {
+                std::memmove(static_cast<void*>(&buffer_[framed]), first, records * sizeof(Record));
+            }
+            framed += records;
+        }
+        datagrams_ += static_cast<uint64_t>(received);
+        return {buffer_.data(), framed};
+    }
+
+    // Blocks until a datagram is queued or timeout_ms passes (-1 = forever)
+    bool wait(int timeout_ms) {
+        epoll_event event;
+        int ready = epoll_wait(epoll_, &event, 1, timeout_ms);
+        if (ready < 0 && errno != EINTR) throw feed_error("MulticastFeedReceiver: epoll_wait");
+        return ready > 0;
+    }
+
+    // Asks the publisher to resend [first, last]; the reply arrives through receive()
+    void request_replay(uint16_t channel, uint64_t first, uint64_t last) {
+        send_request(RecoveryRequest{wire_version, RecoveryKind::Replay, channel, 0, first, last});
+    }
+
+    // Asks for the channel's state; the reply ends with a SnapshotEnd
+    void request_snapshot(uint16_t channel, uint64_t from) {
+        send_request(RecoveryRequest{wire_version, RecoveryKind::Snapshot, channel, 0, from, 0});
+    }
+
+    // A datagram feed has no end of stream
+    bool closed() const { return false; }
+    int fd() const { return fd_; }
+    uint64_t syscalls() const { return syscalls_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+    uint64_t datagrams() const { return datagrams_; }
+    uint64_t malformed() const { return malformed_; }  // Truncated, or not a whole number of records
+
+private:
+    void send_request(const RecoveryRequest& request) {
+        ssize_t sent = sendto(fd_, &request, sizeof(request), 0, reinterpret_cast<const sockaddr*>(&recovery_),
+                              sizeof(recovery_));
+        if (sent < 0) throw feed_error("MulticastFeedReceiver: sendto");
+    }
+
+    int fd_ = -1;
+    int epoll_ = -1;
+    std::vector<Record> buffer_;  // Storage in whole records, so framed records are aligned
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> headers_;
+    sockaddr_in recovery_;
+    uint64_t syscalls_ = 0;
+    uint64_t bytes_received_ = 0;
+    uint64_t datagrams_ = 0;
+    uint64_t malformed_ = 0;
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <span>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+
+// io_uring backend for the same framed-record interface as FeedReceiver.
+//
+// One multishot recv stays armed on the socket. The kernel picks one of a
+// group of pre-allocated, mlock()ed buffers, fills it and posts a completion;
+// receive() reaps completions from shared memory and frames records in place,
+// with no syscall per read. Framed buffers are handed back to the kernel in
+// batches of half the group (one io_uring_enter per batch), and a syscall is
+// otherwise needed only to re-arm the recv, which the kernel ends when it runs
+// out of buffers, or to sleep in wait().
+//
+// Buffers are provided with IORING_OP_PROVIDE_BUFFERS rather than a
+// registered buffer ring (IORING_REGISTER_PBUF_RING): the ring is cheaper to
+// recycle into, but selection from it fails with ENOBUFS on some kernels we
+// run, while provided buffers work on every kernel with multishot recv.
+//
+// Provided buffers are filled at whatever length TCP delivers, so a record
+// may straddle two buffers. That one record is stitched into a private copy
+// and handed out as a span of one; everything else is zero-copy. Records
+// therefore sit at arbitrary offsets and must be packed (alignof 1).
+//
+// Raw syscalls rather than liburing, so the header has no dependencies.
+template<typename Record>
+class UringFeedReceiver {
+    static_assert(std::is_trivially_copyable_v<Record>);
+    static_assert(alignof(Record) == 1, "records are framed at arbitrary offsets; use a packed wire struct");
+
+public:
+    // Takes ownership of a connected stream socket
+    explicit UringFeedReceiver(int fd, uint32_t buffer_count = 64, uint32_t buffer_bytes = 64 * 1024)
+        : fd_(fd), buffer_count_(buffer_count), buffer_bytes_(buffer_bytes) {
+        if (buffer_count < 2 || buffer_count > 32768) {
+            throw std::runtime_error("UringFeedReceiver: buffer_count must be 2 to 32768");
+        }
+        if (buffer_bytes < sizeof(Record)) {
+            throw std::runtime_error("UringFeedReceiver: buffers smaller than one record");
+        }
+        try {
+            setup_ring();
+            setup_buffers();
+            arm();
+        } catch (...) {
+            teardown();
+            throw;
+        }
+    }
+
+    UringFeedReceiver(const UringFeedReceiver&) = delete;
+    UringFeedReceiver& operator=(const UringFeedReceiver&) = delete;
+
+    ~UringFeedReceiver() { teardown(); }
+
+    // Non-blocking: releases the span returned last time and returns the next
+    // complete records, possibly none. The span stays valid until the next call.
+    // Call until empty to drain everything the kernel has delivered.
+    std::span<const Record> receive() {
+        for (;;) {
+            if (current_ == none && !reap()) return {};
+
+            const std::byte* data = buffer(current_);
+            uint32_t available = length_ - offset_;
+
+            if (stitched_) {
+                // Finish the record the previous buffer ended in the middle of
+                uint32_t take = std::min<uint32_t>(sizeof(Record) - stitched_, available);
+                std::memcpy(reinterpret_cast<std::byte*>(&stitch_) + stitched_, data + offset_, take);
+                stitched_ += take;
+                offset_ += take;
+                available -= take;
+                if (stitched_ == sizeof(Record)) {
+                    stitched_ = 0;
+                    return {&stitch_, 1};
+                }
+            }
+            if (available >= sizeof(Record)) {
+                size_t count = available / sizeof(Record);
+                const Record* first = reinterpret_cast<const Record*>(data + offset_);
+                offset_ += static_cast<uint32_t>(count * sizeof(Record));
+                return {first, count};
+            }
+            if (available) {
+                std::memcpy(&stitch_, data + offset_, available);
+                stitched_ = available;
+            }
+            recycle(current_);
+            current_ = none;
+        }
+    }
+
+    // Blocks until a completion is ready or timeout_ms passes (-1 = forever);
+    // recycled buffers still queued are submitted on the way in
+    bool wait(int timeout_ms) {
+        if (completion_ready() || current_ != none) return true;
+        __kernel_timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000LL};
+        io_uring_getevents_arg arg{};
+        arg.ts = timeout_ms < 0 ? 0 : reinterpret_cast<uint64_t>(&ts);
+        ++syscalls_;
+        int result = enter(queued_, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        if (result < 0 && errno != ETIME && errno != EINTR) throw uring_error("UringFeedReceiver: wait");
+        if (result >= 0) queued_ = 0;
+        return completion_ready();
+    }
+
+    // Peer closed the stream; records already delivered are still returned
+    bool closed() const { return closed_; }
+    int fd() const { return fd_; }
+    uint64_t syscalls() const { return syscalls_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+
+private:
+    static constexpr uint32_t none = UINT32_MAX;
+    static constexpr uint16_t group = 0;
+    static constexpr uint64_t recv_tag = 1;
+    static constexpr uint64_t provide_tag = 2;
+
+    static std::system_error uring_error(const char* what, int error = errno) {
+        return std::system_error(error, std::generic_category(), what);
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags, void* arg = nullptr, size_t arg_size = 0) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    void setup_ring() {
+        // Room for a full batch of recycled buffers plus the recv
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, buffer_count_ / 2 + 2, &params));
+        if (ring_fd_ < 0) throw uring_error("UringFeedReceiver: io_uring_setup");
+        unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_EXT_ARG | IORING_FEAT_CQE_SKIP;
+        if ((params.features & needed) != needed) {
+            throw std::runtime_error("UringFeedReceiver: kernel too old");
+        }
+
+        ring_bytes_ = std::max(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+                               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        ring_ = mmap(nullptr, ring_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (ring_ == MAP_FAILED) throw uring_error("UringFeedReceiver: mmap rings");
+        sqe_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqe_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+        if (sqes_ == MAP_FAILED) {
+            sqes_ = nullptr;
+            throw uring_error("UringFeedReceiver: mmap sqes");
+        }
+
+        auto* base = static_cast<std::byte*>(ring_);
+        sq_tail_ = reinterpret_cast<std::atomic<uint32_t>*>(base + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<uint32_t*>(base + params.sq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+        sq_array_ = reinterpret_cast<uint32_t*>(base + params.sq_off.array);
+        cq_head_ = reinterpret_cast<std::atomic<uint32_t>*>(base + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<std::atomic<uint32_t>*>(base + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<uint32_t*>(base + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    }
+
+    // One pinned block, provided to the kernel as buffer ids 0..count-1 in one go
+    void setup_buffers() {
+        buffers_bytes_ = static_cast<size_t>(buffer_count_) * buffer_bytes_;
+        buffers_ = static_cast<std::byte*>(
+            mmap(nullptr, buffers_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+        if (buffers_ == MAP_FAILED) {
+            buffers_ = nullptr;
+            throw uring_error("UringFeedReceiver: mmap buffers");
+        }
+        mlock(buffers_, buffers_bytes_);  // Best effort: may exceed RLIMIT_MEMLOCK
+        provide(0, buffer_count_);
+        flush();
+    }
+
+    void teardown() {
+        if (buffers_) munmap(buffers_, buffers_bytes_);
+        if (sqes_) munmap(sqes_, sqe_bytes_);
+        if (ring_ && ring_ != MAP_FAILED) munmap(ring_, ring_bytes_);
+        if (ring_fd_ >= 0) close(ring_fd_);
+        close(fd_);
+    }
+
+    std::byte* buffer(uint32_t id) const { return buffers_ + static_cast<size_t>(id) * buffer_bytes_; }
+
+    // Queues an SQE; it reaches the kernel with the next flush()
+    io_uring_sqe& queue() {
+        uint32_t tail = sq_tail_->load(std::memory_order_relaxed);
+        uint32_t index = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sq_array_[index] = index;
+        sq_tail_->store(tail + 1, std::memory_order_release);
+        ++queued_;
+        return sqe;
+    }
+
+    void flush() {
+        if (queued_ == 0) return;
+        ++syscalls_;
+        if (enter(queued_, 0, 0) < 0) throw uring_error("UringFeedReceiver: submit");
+        queued_ = 0;
+    }
+
+    // Buffers [first, first + count) go back to the group; completions only on failure
+    void provide(uint32_t first, uint32_t count) {
+        io_uring_sqe& sqe = queue();
+        sqe.opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe.fd = static_cast<int>(count);
+        sqe.addr = reinterpret_cast<uint64_t>(buffer(first));
+        sqe.len = buffer_bytes_;
+        sqe.off = first;
+        sqe.buf_group = group;
+        sqe.flags = IOSQE_CQE_SKIP_SUCCESS;
+        sqe.user_data = provide_tag;
+    }
+
+    // Hands a framed buffer back to the kernel, a batch at a time
+    void recycle(uint32_t id) {
+        provide(id, 1);
+        if (queued_ >= sq_entries_ - 1 || queued_ >= buffer_count_ / 2) flush();
+    }
+
+    // Submits one multishot recv that keeps posting completions until it runs out of buffers
+    void arm() {
+        io_uring_sqe& sqe = queue();
+        sqe.opcode = IORING_OP_RECV;
+        sqe.fd = fd_;
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = group;
+        sqe.user_data = recv_tag;
+        flush();
+        armed_ = true;
+    }
+
+    bool completion_ready() const {
+        return cq_head_->load(std::memory_order_relaxed) != cq_tail_->load(std::memory_order_acquire);
+    }
+
+    // Takes the next completion carrying data into current_; false if none is ready
+    bool reap() {
+        uint32_t head = cq_head_->load(std::memory_order_relaxed);
+        while (head != cq_tail_->load(std::memory_order_acquire)) {
+            io_uring_cqe cqe = cqes_[head & cq_mask_];
+            cq_head_->store(++head, std::memory_order_release);
+            if (cqe.user_data == provide_tag) {
+                throw uring_error("UringFeedReceiver: provide buffers", -cqe.res);
+            }
+            if (!(cqe.flags & IORING_CQE_F_MORE)) armed_ = false;
+
+            if (cqe.res > 0) {
+                current_ = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                offset_ = 0;
+                length_ = static_cast<uint32_t>(cqe.res);
+                bytes_received_ += length_;
+                if (!armed_ && !closed_) arm();
+                return true;
+            }
+            if (cqe.res == 0) {
+                closed_ = true;
+            } else if (cqe.res != -ENOBUFS) {
+                // ENOBUFS only ends the multishot; it is re-armed below once buffers are back
+                throw uring_error("UringFeedReceiver: recv", -cqe.res);
+            }
+        }
+        if (!armed_ && !closed_) {
+            arm();  // Also submits any recycled buffers still queued
+        }
+        return false;
+    }
+
+    int fd_;
+    int ring_fd_ = -1;
+    uint32_t buffer_count_;
+    uint32_t buffer_bytes_;
+
+    void* ring_ = nullptr;
+    size_t ring_bytes_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqe_bytes_ = 0;
+    std::atomic<uint32_t>* sq_tail_ = nullptr;
+    uint32_t sq_mask_ = 0;
+    uint32_t sq_entries_ = 0;
+    uint32_t queued_ = 0;          // SQEs written but not yet submitted
+    uint32_t* sq_array_ = nullptr;
+    std::atomic<uint32_t>* cq_head_ = nullptr;
+    std::atomic<uint32_t>* cq_tail_ = nullptr;
+    uint32_t cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::byte* buffers_ = nullptr;
+    size_t buffers_bytes_ = 0;
+
+    uint32_t current_ = none;  // Buffer being framed, until it is recycled
+    uint32_t offset_ = 0;
+    uint32_t length_ = 0;
+    Record stitch_{};          // The one record split across two buffers
+    uint32_t stitched_ = 0;
+    bool armed_ = false;
+    bool closed_ = false;
+    uint64_t syscalls_ = 0;
+    uint64_t bytes_received_ = 0;
+};
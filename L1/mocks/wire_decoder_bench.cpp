@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "wire_decoder.hpp"
+
+// Checks every decoder kernel against the scalar one and times each over a
+// buffer of wire records. Usage: wire_decoder_bench [messages]
+
+namespace {
+
+std::vector<WireMessage> make_messages(size_t count) {
+    std::vector<WireMessage> messages(count);
+    for (size_t i = 0; i < count; ++i) {
+        WireMessage& m = messages[i];
+        m.header = {wire_version, static_cast<MessageType>(i % 4), 0, static_cast<uint32_t>(i % 97), i + 1, 1000000 + i * 7};
+        m.order_id = i * 13;
+        m.price = 1000000 + static_cast<int64_t>(i % 500) - 250;
+        m.quantity = static_cast<uint32_t>(i % 1000 + 1);
+        m.side = i & 1 ? WireSide::Sell : WireSide::Buy;
+    }
+    return messages;
+}
+
+bool same_columns(const MessageColumns& a, const MessageColumns& b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (a.timestamps[i] != b.timestamps[i] || a.prices[i] != b.prices[i] || a.quantities[i] != b.quantities[i] ||
+            a.instruments[i] != b.instruments[i] || a.types[i] != b.types[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000003;  // Not a multiple of 16: exercises the tails
+    std::vector<WireMessage> messages = make_messages(count);
+    std::cout << "Runtime dispatch picks: " << column_decoder_name() << "\n";
+
+    MessageColumns reference(count);
+    decode_columns_scalar(messages.data(), count, reference, 0);
+
+    struct Kernel { const char* name; ColumnDecoder decode; bool supported; };
+    const Kernel kernels[] = {
+        {"scalar", decode_columns_scalar, true},
+        {"avx2", decode_columns_avx2, __builtin_cpu_supports("avx2") != 0},
+        {"avx512", decode_columns_avx512, __builtin_cpu_supports("avx512f") != 0},
+    };
+
+    bool ok = true;
+    MessageColumns columns(count);
+    for (const Kernel& kernel : kernels) {
+        if (!kernel.supported) {
+            std::cout << kernel.name << ": not supported on this CPU\n";
+            continue;
+        }
+        const int rounds = 20;
+        auto start = std::chrono::steady_clock::now();
+        size_t decoded = 0;
+        for (int r = 0; r < rounds; ++r) decoded = kernel.decode(messages.data(), count, columns, 0);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        bool match = decoded == count && same_columns(reference, columns, count);
+
+        // A record of another version stops decoding exactly there
+        messages[count / 2 + 3].header.version = wire_version + 1;
+        bool stops = kernel.decode(messages.data(), count, columns, 0) == count / 2 + 3;
+        messages[count / 2 + 3].header.version = wire_version;
+
+        ok = ok && match && stops;
+        std::cout << kernel.name << ": " << elapsed / rounds / count << " ns/message"
+                  << (match ? "" : "  MISMATCH") << (stops ? "" : "  VERSION CHECK FAILED") << "\n";
+    }
+
+    std::cout << (ok ? "All decoders agree" : "Decoder mismatch") << "\n";
+    return ok ? 0 : 1;
+}
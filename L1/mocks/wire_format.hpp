@@ -0,0 +1,89 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Feed wire format, version 1. Defined once here; the Python server's
+// struct.pack format string and every decoder must match these asserts.
+//
+// Every message is a fixed 48-byte little-endian record: a 24-byte header,
+// then one body layout shared by all message types, so a stream is framed by
+// size alone and columns (price, quantity, ...) sit at the same offset in
+// every record. Prices are integers in units of 1 / wire_price_scale, so no
+// floating-point rounding happens on the wire.
+//
+// Decoding is a bounds and version check plus a pointer cast: a WireMessage*
+// points straight into the receive buffer, nothing is copied.
+
+static_assert(std::endian::native == std::endian::little, "wire format is little-endian");
+
+constexpr uint8_t wire_version = 1;
+constexpr int64_t wire_price_scale = 10000;  // Price ticks of 0.0001
+
+enum class MessageType : uint8_t {
+    Heartbeat = 0,    // sequence is the last one sent on the channel; consumes none
+    AddOrder = 1,
+    CancelOrder = 2,  // quantity and price unused
+    Trade = 3,        // order_id is the resting order hit, side the aggressor
+    LevelUpdate = 4,  // Market-by-price: quantity is the level's new total, 0 removes it; order_id unused
+    BookClear = 5,    // Every level of the instrument is gone; LevelUpdates rebuild it
+    SnapshotEnd = 6,  // Ends a snapshot reply; sequence is the last message the snapshot includes
+};
+
+// Messages of a snapshot reply (see multicast_feed.hpp) carry sequence 0,
+// which no sequenced message uses, ahead of their SnapshotEnd
+constexpr uint64_t snapshot_sequence = 0;
+
+enum class WireSide : uint8_t { Buy = 0, Sell = 1 };
+
+#pragma pack(push, 1)
+struct MessageHeader {
+    uint8_t version;
+    MessageType type;
+    uint16_t channel;       // Sequence numbers are per channel
+    uint32_t instrument;
+    uint64_t sequence;      // 1 for the first message on a channel
+    uint64_t timestamp_ns;  // Exchange send time
+};
+
+struct WireMessage {
+    MessageHeader header;
+    uint64_t order_id;
+    int64_t price;          // In 1 / wire_price_scale
+    uint32_t quantity;
+    WireSide side;
+    uint8_t reserved[3];    // Zero; room for flags in a later version
+
+    double price_as_double() const { return static_cast<double>(price) / wire_price_scale; }
+};
+#pragma pack(pop)
+
+// Python: struct.pack('<BBHIQQQqIB3x', version, type, channel, instrument,
+//                     sequence, timestamp_ns, order_id, price, quantity, side)
+static_assert(sizeof(MessageHeader) == 24);
+static_assert(offsetof(MessageHeader, type) == 1);
+static_assert(offsetof(MessageHeader, channel) == 2);
+static_assert(offsetof(MessageHeader, instrument) == 4);
+static_assert(offsetof(MessageHeader, sequence) == 8);
+static_assert(offsetof(MessageHeader, timestamp_ns) == 16);
+static_assert(sizeof(WireMessage) == 48);
+static_assert(offsetof(WireMessage, order_id) == 24);
+static_assert(offsetof(WireMessage, price) == 32);
+static_assert(offsetof(WireMessage, quantity) == 40);
+static_assert(offsetof(WireMessage, side) == 44);
+static_assert(alignof(WireMessage) == 1);
+
+// Returns the message at the front of `bytes`, or nullptr if it is truncated
+// or of another version
+inline const WireMessage* decode_message(std::span<const std::byte> bytes) {
+    if (bytes.size() < sizeof(WireMessage)) return nullptr;
+    const auto* message = reinterpret_cast<const WireMessage*>(bytes.data());
+    return message->header.version == wire_version ? message : nullptr;
+}
+
+// Views every complete message in `bytes`; a trailing partial message is left out
+inline std::span<const WireMessage> decode_messages(std::span<const std::byte> bytes) {
+    return {reinterpret_cast<const WireMessage*>(bytes.data()), bytes.size() / sizeof(WireMessage)};
+}
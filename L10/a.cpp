@@ -34,6 +34,7 @@ int logBase2(int val){
     return logBase2(val/2) + 1;
 }
 
+// Classroom version; the container the order book uses is vector.hpp
 template<typename T>
 class Vector {
 public:
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Growable array for buffers whose reallocation we want to control: the
+// production form of the Vector<T> exercise in a.cpp.
+//
+//   Vector<TradeEvent> events;          // Heap only, like std::vector
+//   Vector<Slot, 4> strategies;         // First 4 elements live inside the object
+//
+// Storage is uninitialized and elements are placement-constructed, so
+// reserve() never runs a constructor. Capacity doubles when full, making
+// push_back amortized O(1). Growing relocates the elements: one memcpy when
+// T is trivially copyable, otherwise move-construct and destroy (copy if the
+// move may throw, so a failed growth leaves the vector as it was).
+//
+// With InlineCapacity > 0 the first elements are stored in the object
+// itself and nothing is allocated until that fills up. Moving such a vector
+// therefore relocates its elements rather than stealing a pointer, and
+// pointers into it do not survive the move.
+
+template<typename T, size_t InlineCapacity>
+struct VectorInlineStorage {
+    alignas(T) unsigned char bytes[InlineCapacity * sizeof(T)];
+    T* data() { return reinterpret_cast<T*>(bytes); }
+    const T* data() const { return reinterpret_cast<const T*>(bytes); }
+};
+
+template<typename T>
+struct VectorInlineStorage<T, 0> {
+    T* data() { return nullptr; }
+    const T* data() const { return nullptr; }
+};
+
+template<typename T, size_t InlineCapacity = 0>
+class Vector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    Vector() noexcept : size_(0), capacity_(InlineCapacity) { data_ = inline_.data(); }
+
+    // `count` value-initialized elements
+    explicit Vector(size_t count) : Vector() { resize(count); }
+
+    Vector(size_t count, const T& value) : Vector() { resize(count, value); }
+
+    Vector(std::initializer_list<T> values) : Vector() {
+        reserve(values.size());
+        std::uninitialized_copy(values.begin(), values.end(), data_);
+        size_ = values.size();
+    }
+
+    Vector(const Vector& other) : Vector() {
+        reserve(other.size_);
+        std::uninitialized_copy(other.begin(), other.end(), data_);
+        size_ = other.size_;
+    }
+
+    Vector(Vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : Vector() { take(other); }
+
+    Vector& operator=(const Vector& other) {
+        if (this != &other) {
+            Vector copy(other);
+            clear();
+            release();
+            take(copy);
+        }
+        return *this;
+    }
+
+    Vector& operator=(Vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~Vector() {
+        clear();
+        release();
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    // True while the elements are in the inline buffer
+    bool is_inline() const { return InlineCapacity > 0 && data_ == inline_.data(); }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T& front() { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ < capacity_) {
+            T* slot = ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+            size_++;
+            return *slot;
+        }
+        // The new element is built first: `args` may refer to an element about to move
+        size_t new_capacity = grown_capacity(size_ + 1);
+        T* fresh = allocate(new_capacity);
+        T* slot;
+        try {
+            slot = ::new (static_cast<void*>(fresh + size_)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(fresh, new_capacity);
+            throw;
+        }
+        try {
+            relocate(data_, size_, fresh);
+        } catch (...) {
+            slot->~T();
+            deallocate(fresh, new_capacity);
+            throw;
+        }
+        adopt(fresh, new_capacity);
+        size_++;
+        return *slot;
+    }
+
+    void pop_back() {
+        size_--;
+        data_[size_].~T();
+    }
+
+    void clear() {
+        std::destroy(data_, data_ + size_);
+        size_ = 0;
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity_) grow(new_capacity);
+    }
+
+    void resize(size_t count) {
+        if (count > capacity_) grow(grown_capacity(count));
+        if (count > size_) {
+            std::uninitialized_value_construct(data_ + size_, data_ + count);
+        } else {
+            std::destroy(data_ + count, data_ + size_);
+        }
+        size_ = count;
+    }
+
+    void resize(size_t count, const T& value) {
+        if (count > capacity_) {
+            T copy(value);  // `value` may be an element of this vector
+            grow(grown_capacity(count));
+            std::uninitialized_fill(data_ + size_, data_ + count, copy);
+        } else if (count > size_) {
+            std::uninitialized_fill(data_ + size_, data_ + count, value);
+        } else {
+            std::destroy(data_ + count, data_ + size_);
+        }
+        size_ = count;
+    }
+
+private:
+    static constexpr size_t min_heap_capacity = 4;
+
+    static T* allocate(size_t count) { return std::allocator<T>{}.allocate(count); }
+    static void deallocate(T* p, size_t count) { std::allocator<T>{}.deallocate(p, count); }
+
+    size_t grown_capacity(size_t required) const {
+        return std::max({required, capacity_ * 2, min_heap_capacity});
+    }
+
+    // Moves `count` elements from `from` into uninitialized `to` and ends their
+    // lifetime at `from`. Leaves `from` untouched if construction throws.
+    static void relocate(T* from, size_t count, T* to) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count) std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+        } else {
+            size_t built = 0;
+            try {
+                for (; built < count; ++built) {
+                    ::new (static_cast<void*>(to + built)) T(std::move_if_noexcept(from[built]));
+                }
+            } catch (...) {
+                std::destroy(to, to + built);
+                throw;
+            }
+            std::destroy(from, from + count);
+        }
+    }
+
+    void grow(size_t new_capacity) {
+        T* fresh = allocate(new_capacity);
+        try {
+            relocate(data_, size_, fresh);
+        } catch (...) {
+            deallocate(fresh, new_capacity);
+            throw;
+        }
+        adopt(fresh, new_capacity);
+    }
+
+    // Frees the old heap block, if any, and switches to `fresh`
+    void adopt(T* fresh, size_t new_capacity) {
+        release();
+        data_ = fresh;
+        capacity_ = new_capacity;
+    }
+
+    // Frees the heap block, leaving the (empty) vector on its inline buffer
+    void release() {
+        if (data_ != inline_.data()) deallocate(data_, capacity_);
+        data_ = inline_.data();
+        capacity_ = InlineCapacity;
+    }
+
+    // Takes `other`'s elements into this empty vector, which is left on its
+    // inline buffer; `other` is left empty
+    void take(Vector& other) {
+        if (other.data_ != other.inline_.data()) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            other.data_ = other.inline_.data();
+            other.capacity_ = InlineCapacity;
+            other.size_ = 0;
+            return;
+        }
+        if constexpr (InlineCapacity > 0) {
+            // Inline elements fit inline here too
+            relocate(other.data_, other.size_, data_);
+            size_ = other.size_;
+            other.size_ = 0;
+        }
+    }
+
+    [[no_unique_address]] VectorInlineStorage<T, InlineCapacity> inline_;
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+};
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Thread-caching allocator for small hot-path objects (order nodes, events,
+// messages), instead of a trip through malloc per object.
+//
+// Requests up to size_class_max_size bytes are rounded up to one of a few size
+// classes. Every thread keeps a free list per class, so allocate and free are
+// a pointer pop and push with no locking and no atomics. Lists are refilled
+// from, and trimmed back to, a central pool in whole batches, one lock per
+// batch; the central pool carves fresh batches out of 64 KiB chunks that are
+// kept for the life of the process.
+//
+// Objects may be freed on any thread: a block allocated by the feed thread
+// and released by the matcher joins the matcher's list. Once that list holds
+// two batches, one goes back to the central pool, and the feed thread picks
+// it up on its next refill. In steady state a producer/consumer pair just
+// passes batches around and never reaches the system allocator.
+//
+// Blocks are 16-byte aligned; larger requests go to ::operator new.
+// small_allocate() takes no alignment, so small_new() and SizeClassAllocator
+// reject more strictly aligned types at compile time. small_deallocate() must
+// be given the size that was allocated.
+
+constexpr size_t size_class_max_size = 512;
+constexpr size_t size_class_chunk_size = 64 * 1024;
+
+constexpr std::array<uint32_t, 12> size_class_sizes = {16, 32, 48, 64, 80, 96, 128, 160, 192, 256, 384, 512};
+
+// Class index for every 16-byte step up to size_class_max_size
+constexpr std::array<uint8_t, size_class_max_size / 16 + 1> make_size_class_table() {
+    std::array<uint8_t, size_class_max_size / 16 + 1> table{};
+    size_t cls = 0;
+    for (size_t step = 0; step < table.size(); ++step) {
+        while (size_class_sizes[cls] < step * 16) ++cls;
+        table[step] = static_cast<uint8_t>(cls);
+    }
+    return table;
+}
+
+constexpr auto size_class_table = make_size_class_table();
+
+constexpr size_t size_class_of(size_t size) { return size_class_table[(size + 15) / 16]; }
+
+// Objects moved per refill or trim; bigger for small classes
+constexpr uint32_t size_class_batch(size_t cls) {
+    uint32_t count = 8192 / size_class_sizes[cls];
+    return count < 8 ? 8 : count > 128 ? 128 : count;
+}
+
+struct SizeClassNode {
+    SizeClassNode* next;
+    SizeClassNode* next_batch;  // Central pool only: links the heads of whole batches
+};
+
+static_assert(sizeof(SizeClassNode) <= 16);
+
+struct SizeClassStats {
+    std::atomic<uint64_t> chunks{0};        // 64 KiB chunks taken from the system
+    std::atomic<uint64_t> refills{0};       // Batches handed to thread caches
+    std::atomic<uint64_t> returns{0};       // Batches given back by thread caches
+};
+
+class SizeClassCentralPool {
+public:
+    SizeClassCentralPool() = default;
+    SizeClassCentralPool(const SizeClassCentralPool&) = delete;
+    SizeClassCentralPool& operator=(const SizeClassCentralPool&) = delete;
+
+    ~SizeClassCentralPool() {
+        for (void* chunk : chunks_) ::operator delete(chunk);
+    }
+
+    // A batch of size_class_batch(cls) free blocks, linked through next
+    SizeClassNode* take_batch(size_t cls) {
+        stats_.refills.fetch_add(1, std::memory_order_relaxed);
+        Bin& bin = bins_[cls];
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        if (!bin.batches) carve(cls, bin);
+        SizeClassNode* batch = bin.batches;
+        bin.batches = batch->next_batch;
+        return batch;
+    }
+
+    // Takes back exactly size_class_batch(cls) blocks linked through next
+    void give_batch(size_t cls, SizeClassNode* batch) {
+        stats_.returns.fetch_add(1, std::memory_order_relaxed);
+        Bin& bin = bins_[cls];
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        batch->next_batch = bin.batches;
+        bin.batches = batch;
+    }
+
+    // Leftovers of a thread cache that is going away: fewer than a batch at a time is fine
+    void give_partial(size_t cls, SizeClassNode* head) {
+        Bin& bin = bins_[cls];
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        while (head) {
+            SizeClassNode* next = head->next;
+            head->next = bin.loose;
+            bin.loose = head;
+            head = next;
+            if (++bin.loose_count == size_class_batch(cls)) {
+                bin.loose->next_batch = bin.batches;
+                bin.batches = bin.loose;
+                bin.loose = nullptr;
+                bin.loose_count = 0;
+            }
+        }
+    }
+
+    const SizeClassStats& stats() const { return stats_; }
+
+private:
+    struct Bin {
+        std::mutex mutex;
+        SizeClassNode* batches = nullptr;
+        SizeClassNode* loose = nullptr;
+        uint32_t loose_count = 0;
+    };
+
+    // Splits one chunk into as many whole batches as fit; called with the bin locked
+    void carve(size_t cls, Bin& bin) {
+        size_t size = size_class_sizes[cls];
+        uint32_t batch = size_class_batch(cls);
+        size_t bytes = std::max(size_class_chunk_size, size * batch);
+        char* chunk = static_cast<char*>(::operator new(bytes));
+        {
+            std::lock_guard<std::mutex> lock(chunks_mutex_);
+            chunks_.push_back(chunk);
+        }
+        stats_.chunks.fetch_add(1, std::memory_order_relaxed);
+
+        size_t objects = bytes / size / batch * batch;
+        for (size_t first = 0; first < objects; first += batch) {
+            SizeClassNode* head = nullptr;
+            for (size_t i = first + batch; i-- > first;) {
+                auto* node = reinterpret_cast<SizeClassNode*>(chunk + i * size);
+                node->next = head;
+                head = node;
+            }
+            head->next_batch = bin.batches;
+            bin.batches = head;
+        }
+    }
+
+    std::array<Bin, size_class_sizes.size()> bins_;
+    std::mutex chunks_mutex_;
+    std::vector<void*> chunks_;
+    SizeClassStats stats_;
+};
+
+inline SizeClassCentralPool& size_class_central_pool() {
+    static SizeClassCentralPool pool;
+    return pool;
+}
+
+class SizeClassThreadCache {
+public:
+    SizeClassThreadCache() : central_(size_class_central_pool()) {}
+    SizeClassThreadCache(const SizeClassThreadCache&) = delete;
+    SizeClassThreadCache& operator=(const SizeClassThreadCache&) = delete;
+
+    // A thread's cached blocks outlive it in the central pool
+    ~SizeClassThreadCache() {
+        for (size_t cls = 0; cls < bins_.size(); ++cls) {
+            if (bins_[cls].head) central_.give_partial(cls, bins_[cls].head);
+        }
+    }
+
+    void* allocate(size_t cls) {
+        Bin& bin = bins_[cls];
+        if (!bin.head) {
+            bin.head = central_.take_batch(cls);
+            bin.count = size_class_batch(cls);
+        }
+        SizeClassNode* node = bin.head;
+        bin.head = node->next;
+        bin.count--;
+        return node;
+    }
+
+    void deallocate(void* p, size_t cls) {
+        Bin& bin = bins_[cls];
+        auto* node = static_cast<SizeClassNode*>(p);
+        node->next = bin.head;
+        bin.head = node;
+        if (++bin.count >= 2 * size_class_batch(cls)) {
+            // Keep one batch for reuse here, hand the other to threads that allocate
+            uint32_t batch = size_class_batch(cls);
+            SizeClassNode* last = bin.head;
+            for (uint32_t i = 1; i < batch; ++i) last = last->next;
+            SizeClassNode* released = bin.head;
+            bin.head = last->next;
+            last->next = nullptr;
+            bin.count -= batch;
+            central_.give_batch(cls, released);
+        }
+    }
+
+private:
+    struct Bin {
+        SizeClassNode* head = nullptr;
+        uint32_t count = 0;
+    };
+
+    SizeClassCentralPool& central_;
+    std::array<Bin, size_class_sizes.size()> bins_;
+};
+
+inline SizeClassThreadCache& size_class_thread_cache() {
+    thread_local SizeClassThreadCache cache;
+    return cache;
+}
+
+inline void* small_allocate(size_t size) {
+    if (size > size_class_max_size) return ::operator new(size);
+    return size_class_thread_cache().allocate(size_class_of(size));
+}
+
+inline void small_deallocate(void* p, size_t size) {
+    if (!p) return;
+    if (size > size_class_max_size) {
+        ::operator delete(p, size);
+        return;
+    }
+    size_class_thread_cache().deallocate(p, size_class_of(size));
+}
+
+template<typename T, typename... Args>
+T* small_new(Args&&... args) {
+    static_assert(alignof(T) <= 16, "size-class blocks are 16-byte aligned");
+    void* p = small_allocate(sizeof(T));
+    try {
+        return new (p) T(std::forward<Args>(args)...);
+    } catch (...) {
+        small_deallocate(p, sizeof(T));
+        throw;
+    }
+}
+
+template<typename T>
+void small_delete(T* object) {
+    if (!object) return;
+    object->~T();
+    small_deallocate(object, sizeof(T));
+}
+
+// Stateless deleter for smart pointers to small_new() objects, e.g.
+// UniquePtr<Event, SmallDelete<Event>> in L8/unique_ptr.hpp
+template<typename T>
+struct SmallDelete {
+    void operator()(T* object) const noexcept { small_delete(object); }
+};
+
+inline const SizeClassStats& small_allocator_stats() { return size_class_central_pool().stats(); }
+
+// STL allocator over the same caches, e.g. for std::allocate_shared or node containers
+template<typename T>
+struct SizeClassAllocator {
+    using value_type = T;
+
+    SizeClassAllocator() noexcept = default;
+    template<typename U>
+    SizeClassAllocator(const SizeClassAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        static_assert(alignof(T) <= 16, "size-class blocks are 16-byte aligned");
+        if (count > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(small_allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t count) noexcept { small_deallocate(p, count * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const SizeClassAllocator<U>&) const noexcept { return true; }
+};
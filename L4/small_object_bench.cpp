@@ -0,0 +1,108 @@
+// new/delete against the size-class allocator, on one thread and for objects
+// handed from a producer to a consumer thread through a Fifo4.
+//
+//   g++ -std=c++20 -O2 -pthread small_object_bench.cpp -o small_object_bench
+//   ./small_object_bench [objects]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "size_class_allocator.hpp"
+#include "../SPSC_QUEUES/spsc_q4.cpp"
+
+namespace {
+
+struct Event {
+    uint64_t order_id;
+    double price;
+    uint64_t quantity;
+    uint64_t timestamp_ns;
+    char tag[16];
+};
+
+struct HeapAlloc {
+    static Event* make(uint64_t i) { return new Event{i, 100.0, 1, i, "heap"}; }
+    static void free(Event* event) { delete event; }
+};
+
+struct SizeClassAlloc {
+    static Event* make(uint64_t i) { return small_new<Event>(Event{i, 100.0, 1, i, "pooled"}); }
+    static void free(Event* event) { small_delete(event); }
+};
+
+double ns_per_op(std::chrono::steady_clock::time_point start, uint64_t ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(ops);
+}
+
+// Allocates a window of live objects and frees them, like a book's node churn
+template<typename Alloc>
+double same_thread(uint64_t objects) {
+    constexpr size_t window = 256;
+    Event* live[window] = {};
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < objects; ++i) {
+        Event*& slot = live[i % window];
+        if (slot) Alloc::free(slot);
+        slot = Alloc::make(i);
+    }
+    for (Event* event : live) {
+        if (event) Alloc::free(event);
+    }
+    return ns_per_op(start, objects);
+}
+
+// The producer allocates, the consumer frees: every block crosses threads
+template<typename Alloc>
+double handoff(uint64_t objects) {
+    Fifo4<Event*> queue(1024);
+    std::thread consumer([&] {
+        uint64_t sum = 0;
+        for (uint64_t received = 0; received < objects;) {
+            Event* event;
+            if (queue.pop(event)) {
+                sum += event->order_id;
+                Alloc::free(event);
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        if (sum != objects * (objects - 1) / 2) std::abort();
+    });
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < objects; ++i) {
+        Event* event = Alloc::make(i);
+        while (!queue.push(event)) std::this_thread::yield();
+    }
+    consumer.join();
+    return ns_per_op(start, objects);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    uint64_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+
+    // Warm-up fills the caches, so the timed runs show steady state
+    handoff<SizeClassAlloc>(objects / 10);
+    uint64_t chunks = small_allocator_stats().chunks.load();
+
+    std::cout << std::left << std::setw(24) << "ns per object" << std::right << std::setw(12) << "new/delete"
+              << std::setw(12) << "size-class" << "\n" << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(24) << "same thread" << std::right
+              << std::setw(12) << same_thread<HeapAlloc>(objects)
+              << std::setw(12) << same_thread<SizeClassAlloc>(objects) << "\n";
+    std::cout << std::left << std::setw(24) << "producer -> consumer" << std::right
+              << std::setw(12) << handoff<HeapAlloc>(objects)
+              << std::setw(12) << handoff<SizeClassAlloc>(objects) << "\n";
+
+    const auto& stats = small_allocator_stats();
+    std::cout << "\nchunks from the system after warm-up: " << stats.chunks.load() - chunks
+              << ", batch refills " << stats.refills.load() << ", batch returns " << stats.returns.load() << "\n";
+    return 0;
+}
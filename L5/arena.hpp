@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Bump arena for hot-path memory: the MemoryPool idea from memory_allocator.cpp,
+// minus its first-touch costs.
+//
+// The region is reserved with mmap instead of living inside an object, on
+// explicit 2 MiB huge pages when the system has some reserved, otherwise on
+// normal pages with a transparent huge page hint. It is bound to one NUMA node
+// (by default the node of the constructing thread, which should be the thread
+// that will own it) before any page is touched, then pre-faulted, so neither
+// page faults nor 4 KiB TLB misses show up once trading starts.
+//
+// Allocation is a pointer bump honouring alignment; nothing is freed one by
+// one. mark()/rewind() and Scope release everything allocated after a point,
+// e.g. per message or per batch. Destructors are not run on rewind: use it
+// for trivially destructible data or destroy objects first.
+//
+// An arena belongs to one thread; it does no locking.
+
+struct ArenaOptions {
+    int numa_node = -1;       // -1: the node the constructing thread runs on
+    bool huge_pages = true;   // Try MAP_HUGETLB, then fall back to a THP hint
+    bool prefault = true;     // Touch every page up front
+};
+
+class Arena {
+public:
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    explicit Arena(size_t capacity, ArenaOptions options = {})
+        : base_(nullptr), capacity_(0), offset_(0), huge_pages_(false), numa_node_(-1) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Arena capacity must be non-zero");
+        }
+        if (options.huge_pages) {
+            size_t rounded = round_up(capacity, huge_page_size);
+            void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);  // 2^21: MAP_HUGE_2MB
+            if (p != MAP_FAILED) {
+                base_ = static_cast<char*>(p);
+                capacity_ = rounded;
+                huge_pages_ = true;
+            }
+        }
+        if (!base_) {
+            size_t rounded = round_up(capacity, static_cast<size_t>(::sysconf(_SC_PAGESIZE)));
+            void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) {
+                throw std::system_error(errno, std::generic_category(), "Arena: mmap of " + std::to_string(rounded) + " bytes");
+            }
+            base_ = static_cast<char*>(p);
+            capacity_ = rounded;
+            if (options.huge_pages) ::madvise(base_, capacity_, MADV_HUGEPAGE);
+        }
+
+        // Policy must be set before the first touch, which is what places a page
+        int node = options.numa_node >= 0 ? options.numa_node : current_numa_node();
+        if (node >= 0 && node < 64) {
+            unsigned long mask = 1ul << node;
+            if (::syscall(SYS_mbind, base_, capacity_, MPOL_BIND, &mask, 64, 0) == 0) {
+                numa_node_ = node;
+            }
+        }
+        if (options.prefault) prefault();
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        ::munmap(base_, capacity_);
+    }
+
+    // Null when the arena is exhausted, like MemoryPool::getMemory; alignment is a power of two
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        uintptr_t start = reinterpret_cast<uintptr_t>(base_) + offset_;
+        uintptr_t aligned = (start + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        size_t end = aligned - reinterpret_cast<uintptr_t>(base_) + bytes;
+        if (end > capacity_) return nullptr;
+        offset_ = end;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* p = allocate(sizeof(T), alignof(T));
+        if (!p) throw std::bad_alloc();
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    T* allocate_array(size_t count) {
+        if (count > capacity_ / sizeof(T)) return nullptr;
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Everything allocated after mark() is released by rewind(mark)
+    size_t mark() const { return offset_; }
+    void rewind(size_t mark) { offset_ = mark; }
+    void reset() { offset_ = 0; }
+
+    // Rewinds the arena to where it was when the scope was entered
+    class Scope {
+    public:
+        explicit Scope(Arena& arena) : arena_(arena), mark_(arena.mark()) {}
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() { arena_.rewind(mark_); }
+
+    private:
+        Arena& arena_;
+        size_t mark_;
+    };
+
+    bool owns(const void* p) const {
+        const char* c = static_cast<const char*>(p);
+        return c >= base_ && c < base_ + capacity_;
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return offset_; }
+    size_t remaining() const { return capacity_ - offset_; }
+    bool huge_pages() const { return huge_pages_; }
+    int numa_node() const { return numa_node_; }  // -1 if the binding failed
+
+    static int current_numa_node() {
+        unsigned cpu = 0, node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return -1;
+        return static_cast<int>(node);
+    }
+
+private:
+    static size_t round_up(size_t value, size_t to) { return (value + to - 1) / to * to; }
+
+    void prefault() {
+#ifdef MADV_POPULATE_WRITE
+        if (::madvise(base_, capacity_, MADV_POPULATE_WRITE) == 0) return;
+#endif
+        // Older kernels: one write per page
+        size_t step = huge_pages_ ? huge_page_size : static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        for (size_t i = 0; i < capacity_; i += step) {
+            static_cast<volatile char*>(base_)[i] = 0;
+        }
+    }
+
+    char* base_;
+    size_t capacity_;
+    size_t offset_;
+    bool huge_pages_;
+    int numa_node_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#include "arena.hpp"
+
+// Adapters that let containers draw from an Arena.
+//
+// ArenaAllocator<T> is a plain STL allocator for templates that take an
+// Alloc parameter, such as Fifo1-Fifo4: no virtual call, and the ring lands
+// in the arena's pre-faulted, NUMA-local pages.
+//
+// ArenaResource is the std::pmr::memory_resource form, for OrderBook and any
+// std::pmr container. A bump arena never reuses memory, so for containers
+// with churn (map nodes, rehashed tables) put a pool in front of it:
+//
+//   Arena arena(256 << 20);
+//   ArenaResource upstream(arena);
+//   std::pmr::unsynchronized_pool_resource pool(&upstream);
+//   OrderBook book(NullTradeSink{}, &pool);
+//
+// Freed blocks then cycle through the pool and the arena only supplies fresh
+// chunks. Deallocation is a no-op at the arena level: memory comes back when
+// the arena is rewound or destroyed, which must not happen before every
+// container using it is gone.
+
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t count) {
+        T* p = arena_->allocate_array<T>(count);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+private:
+    Arena* arena_;
+};
+
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(Arena& arena) noexcept : arena_(arena) {}
+
+    Arena& arena() const noexcept { return arena_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = arena_.allocate(bytes, alignment);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    Arena& arena_;
+};
@@ -1,5 +1,7 @@
 #include <iostream>
 #include <cstdint>
+
+#include "arena.hpp"
 using namespace std;
 
 
@@ -12,19 +14,12 @@ using namespace std;
 
 
 
+// The pool used to be a struct holding char buffer[1GiB]: faulted in page by
+// page on first touch, no alignment, no way to give memory back. Arena
+// (arena.hpp) replaces it: mmap'd, huge pages when available, NUMA-local and
+// pre-faulted, aligned allocations, and rewind to release a batch at once.
+
 const uint64_t SIZE = 1024 * 1024 * 1024;
-struct MemoryPool{
-   char buffer[SIZE];
-   uint64_t offset{0};
-   void* getMemory(uint64_t bytesNeeded){
-	if(offset + bytesNeeded > SIZE)
-		return nullptr;
-
-	void* ptrToOffset = reinterpret_cast<void*>(&(buffer[offset]));
-        offset += bytesNeeded;
-	return ptrToOffset;
-   }
-};
 
 struct Box{
   uint64_t size;
@@ -32,10 +27,14 @@ struct Box{
 };
 
 int main(){
-	MemoryPool* mPool = new MemoryPool();	
+	Arena arena(SIZE);
+	cout << "arena: " << arena.capacity() << " bytes, huge pages " << arena.huge_pages()
+	     << ", numa node " << arena.numa_node() << endl;
 	for(int i=0;i<100;i++){
-		Box* box1 = reinterpret_cast<Box*>(mPool->getMemory(sizeof(Box)));
+		Arena::Scope scope(arena);	// Each iteration's boxes are released at the end of it
+		Box* box1 = arena.create<Box>();
         	box1->size = 10;
         	cout << box1->size << endl;
 	}
+	cout << "used after loop: " << arena.used() << endl;
 }
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "unique_ptr.hpp"
+
+// Shared ownership with the count inside the object, for data handed to
+// many readers such as book snapshots:
+//
+//   struct Snapshot : RefCounted<Snapshot> { DepthSnapshot depth; };
+//   IntrusivePtr<Snapshot> shared = make_intrusive<Snapshot>();
+//
+// Unlike std::shared_ptr (see L10/sharedPtrMore.cpp) there is no separate
+// control block to allocate, and the pointer is one word. The count policy
+// is chosen per type:
+//
+//   AtomicRefCount  handles may be copied and dropped on any thread
+//   LocalRefCount   every handle stays on one thread; plain increments
+//
+// Copying a handle is the only operation that touches the count besides
+// dropping one. Moving a handle, or lending it as `const T&` or a raw
+// pointer for the duration of a call, costs no read-modify-write, so a
+// publisher fanning a snapshot out to readers should move or lend where it
+// can and copy only for readers that keep it.
+//
+// The last release calls Deleter on the object, so objects built with
+// small_new() can return to the size-class pools through SmallDelete.
+
+// Atomic count: increments are relaxed, since a new handle can only be made
+// from an existing one; the final decrement synchronises with every earlier
+// release, so the deleting thread sees all writes made through other handles
+struct AtomicRefCount {
+    std::atomic<uint32_t> count{0};
+
+    void add() noexcept { count.fetch_add(1, std::memory_order_relaxed); }
+    // True when this was the last reference
+    bool release() noexcept {
+        if (count.fetch_sub(1, std::memory_order_release) != 1) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+    uint32_t load() const noexcept { return count.load(std::memory_order_relaxed); }
+};
+
+struct LocalRefCount {
+    uint32_t count = 0;
+
+    void add() noexcept { ++count; }
+    bool release() noexcept { return --count == 0; }
+    uint32_t load() const noexcept { return count; }
+};
+
+// Base of a refcounted type; Derived is the most derived class, which the
+// deleter receives
+template<typename Derived, typename CountPolicy = AtomicRefCount, typename Deleter = DefaultDelete<Derived>>
+class RefCounted {
+public:
+    RefCounted() noexcept = default;
+    // A copy of the object is a new object with no references yet
+    RefCounted(const RefCounted&) noexcept {}
+    RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+
+    void add_ref() const noexcept { count_.add(); }
+    void release_ref() const noexcept {
+        if (count_.release()) Deleter{}(const_cast<Derived*>(static_cast<const Derived*>(this)));
+    }
+    uint32_t use_count() const noexcept { return count_.load(); }
+
+protected:
+    ~RefCounted() = default;
+
+private:
+    mutable CountPolicy count_;
+};
+
+template<typename T>
+class IntrusivePtr {
+public:
+    constexpr IntrusivePtr() noexcept : ptr_(nullptr) {}
+    constexpr IntrusivePtr(std::nullptr_t) noexcept : ptr_(nullptr) {}
+
+    // Takes a new reference to `p`, which may already be shared
+    explicit IntrusivePtr(T* p) noexcept : ptr_(p) {
+        if (ptr_) ptr_->add_ref();
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept : ptr_(other.ptr_) {
+        if (ptr_) ptr_->add_ref();
+    }
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept : ptr_(other.ptr_) { other.ptr_ = nullptr; }
+
+    // From a handle to a derived or less const-qualified type
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    IntrusivePtr(const IntrusivePtr<U>& other) noexcept : ptr_(other.get()) {
+        if (ptr_) ptr_->add_ref();
+    }
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    IntrusivePtr(IntrusivePtr<U>&& other) noexcept : ptr_(other.detach()) {}
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        IntrusivePtr(other).swap(*this);
+        return *this;
+    }
+
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        IntrusivePtr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~IntrusivePtr() {
+        if (ptr_) ptr_->release_ref();
+    }
+
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    T* get() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    void reset() noexcept { IntrusivePtr().swap(*this); }
+    // Gives up the reference without releasing it
+    T* detach() noexcept {
+        T* p = ptr_;
+        ptr_ = nullptr;
+        return p;
+    }
+    void swap(IntrusivePtr& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+    bool operator==(const IntrusivePtr& other) const noexcept { return ptr_ == other.ptr_; }
+
+private:
+    T* ptr_;
+};
+
+// For types released with DefaultDelete; pool-backed types construct with
+// their allocator (small_new) and wrap the result
+template<typename T, typename... Args>
+IntrusivePtr<T> make_intrusive(Args&&... args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// The UniquePtr of unqiePtr.cpp with a deleter policy, so objects can go
+// back to the allocator they came from rather than always to delete:
+//
+//   UniquePtr<Event, SmallDelete<Event>> event(small_new<Event>(...));
+//
+// A stateless deleter (an empty struct, like DefaultDelete or SmallDelete in
+// L4/size_class_allocator.hpp) is stored with [[no_unique_address]], so the
+// pointer stays the size of a raw pointer. Stateful deleters work too and
+// cost their own size.
+
+template<typename T>
+struct DefaultDelete {
+    void operator()(T* p) const noexcept {
+        static_assert(sizeof(T) > 0, "cannot delete an incomplete type");
+        delete p;
+    }
+};
+
+template<typename T, typename Deleter = DefaultDelete<T>>
+class UniquePtr {
+public:
+    constexpr UniquePtr() noexcept : ptr_(nullptr) {}
+    constexpr UniquePtr(std::nullptr_t) noexcept : ptr_(nullptr) {}
+    explicit UniquePtr(T* p) noexcept : ptr_(p) {}
+    UniquePtr(T* p, const Deleter& deleter) noexcept : ptr_(p), deleter_(deleter) {}
+
+    UniquePtr(const UniquePtr&) = delete;
+    UniquePtr& operator=(const UniquePtr&) = delete;
+
+    UniquePtr(UniquePtr&& other) noexcept : ptr_(other.release()), deleter_(std::move(other.deleter_)) {}
+
+    // From a UniquePtr of a derived type with a convertible deleter
+    template<typename U, typename E,
+             typename = std::enable_if_t<std::is_convertible_v<U*, T*> && std::is_convertible_v<E, Deleter>>>
+    UniquePtr(UniquePtr<U, E>&& other) noexcept : ptr_(other.release()), deleter_(std::move(other.get_deleter())) {}
+
+    UniquePtr& operator=(UniquePtr&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+            deleter_ = std::move(other.deleter_);
+        }
+        return *this;
+    }
+
+    UniquePtr& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    ~UniquePtr() {
+        if (ptr_) deleter_(ptr_);
+    }
+
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    T* get() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    Deleter& get_deleter() noexcept { return deleter_; }
+    const Deleter& get_deleter() const noexcept { return deleter_; }
+
+    // Gives up ownership without deleting
+    T* release() noexcept {
+        T* p = ptr_;
+        ptr_ = nullptr;
+        return p;
+    }
+
+    // Deletes the current object, if any, and takes `p`
+    void reset(T* p = nullptr) noexcept {
+        T* old = ptr_;
+        ptr_ = p;
+        if (old) deleter_(old);
+    }
+
+private:
+    T* ptr_;
+    [[no_unique_address]] Deleter deleter_;
+};
+
+template<typename T, typename... Args>
+UniquePtr<T> make_unique_ptr(Args&&... args) {
+    return UniquePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+static_assert(sizeof(UniquePtr<int>) == sizeof(int*), "a stateless deleter takes no space");
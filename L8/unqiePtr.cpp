@@ -1,6 +1,6 @@
 #include <iostream>
 
-// A very simple unique_ptr
+// A very simple unique_ptr; unique_ptr.hpp adds deleter policies
 template <typename T>
 class UniquePtr {
     T* ptr;
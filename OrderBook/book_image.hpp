@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "order_book.hpp"
+#include "journal.hpp"
+
+// Book images on disk, for warm restarts.
+//
+// A shard writes an image periodically together with the journal sequence it
+// reflects. On restart the image is mapped and loaded, then only the journal
+// records after that sequence are replayed, instead of every message since
+// the open. Images are written to a temporary file and renamed into place, so
+// a crash mid-write leaves the previous image intact.
+
+template<typename Book>
+void save_book_image(const Book& book, const std::string& path, uint64_t sequence) {
+    std::vector<std::byte> image = book.save_image(sequence);
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open book image " + temp + ": " + std::strerror(errno));
+    }
+    const std::byte* p = image.data();
+    size_t left = image.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot write book image " + temp + ": " + std::strerror(errno));
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    if (::fdatasync(fd) != 0 || ::close(fd) != 0 || std::rename(temp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot commit book image " + path + ": " + std::strerror(errno));
+    }
+}
+
+// Loads an image file into an empty book; returns the journal sequence it reflects
+template<typename Book>
+uint64_t load_book_image(Book& book, const std::string& path) {
+    MappedFile file(path, sizeof(BookImageHeader));
+    return book.load_image(file.bytes());
+}
+
+// Warm restart: the image, then every journal record written after it
+template<typename Book>
+ReplayResult restore_book(Book& book, const std::string& image_path, const std::string& journal_path) {
+    uint64_t sequence = load_book_image(book, image_path);
+    MappedJournal journal(journal_path);
+    return replay_journal(journal.records(), book, sequence);
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <memory_resource>
+
+#include "order_book.hpp"
+#include "thread_runtime.hpp"
+#include "../SPSC_QUEUES/spsc_q4.cpp"
+#include "../SPSC_QUEUES/wait_strategy.cpp"
+#include "../lockFreeWaitFree/workStealingPool.hpp"
+
+// Per-instrument book setup
+struct InstrumentConfig {
+    bool use_ladder;
+    TickLadderConfig ladder;
+    size_t reserve_orders;
+    std::pmr::memory_resource* resource = nullptr;  // Where the book allocates; null for the default heap
+};
+
+// One inbound message routed to the book of `instrument_id`
+struct BookCommand {
+    uint32_t instrument_id;
+    OrderCommand command;
+};
+
+// Owns one book per instrument in a dense array indexed by instrument id.
+// Instruments are sharded round-robin over worker threads; every shard has
+// one Fifo4 per producer, so each queue keeps a single producer and consumer.
+// Books belong to their shard thread while running: only touch them through
+// book() once stop() has returned.
+// Idle workers back off with WaitStrategy (see wait_strategy.cpp); ParkingWait
+// lets quiet shards sleep instead of holding a core. Shard threads run as the
+// "matcher.N" roles of thread_runtime.hpp.
+template<typename TradeSink = NullTradeSink, typename WaitStrategy = SpinYieldWait>
+class BookManager {
+public:
+    using Book = BasicOrderBook<TradeSink>;
+
+    BookManager(const std::vector<InstrumentConfig>& instruments, size_t num_shards, size_t num_producers,
+                size_t queue_capacity, const std::vector<int>& shard_cores = {})
+        : num_instruments_(instruments.size()), running_(false) {
+        if (num_shards == 0 || num_producers == 0) {
+            throw std::runtime_error("BookManager needs at least one shard and one producer");
+        }
+
+        books_ = std::allocator<Book>{}.allocate(num_instruments_);
+        size_t constructed = 0;
+        try {
+            for (; constructed < num_instruments_; ++constructed) {
+                const InstrumentConfig& config = instruments[constructed];
+                std::pmr::memory_resource* resource = config.resource ? config.resource
+                                                                      : std::pmr::get_default_resource();
+                Book* book = config.use_ladder ? new (&books_[constructed]) Book(config.ladder, TradeSink{}, resource)
+                                               : new (&books_[constructed]) Book(TradeSink{}, resource);
+                book->reserve_orders(config.reserve_orders);
+            }
+        } catch (...) {
+            while (constructed > 0) books_[--constructed].~Book();
+            std::allocator<Book>{}.deallocate(books_, num_instruments_);
+            throw;
+        }
+
+        shards_.reserve(num_shards);
+        for (size_t s = 0; s < num_shards; ++s) {
+            auto shard = std::make_unique<Shard>();
+            shard->placement.core = s < shard_cores.size() ? shard_cores[s] : -1;
+            for (size_t p = 0; p < num_producers; ++p) {
+                shard->queues.push_back(std::make_unique<Fifo4<BookCommand>>(queue_capacity));
+            }
+            shards_.push_back(std::move(shard));
+        }
+    }
+
+    BookManager(const BookManager&) = delete;
+    BookManager& operator=(const BookManager&) = delete;
+
+    ~BookManager() {
+        stop();
+        for (size_t i = 0; i < num_instruments_; ++i) {
+            books_[i].~Book();
+        }
+        std::allocator<Book>{}.deallocate(books_, num_instruments_);
+    }
+
+    // Takes each shard's placement from the runtime's "matcher.N" role,
+    // replacing the shard_cores given at construction. Before start() only.
+    void place_shards(const ThreadRuntime& runtime) {
+        for (size_t s = 0; s < shards_.size(); ++s) {
+            shards_[s]->placement = runtime.placement("matcher." + std::to_string(s));
+        }
+    }
+    
+    // Spawns one worker per shard, placed on its configured core if any. A
+    // worker starts draining only once its placement took; if one fails, the
+    // workers already running keep going until stop().
+    void start() {
+        if (running_.exchange(true)) return;
+        for (size_t s = 0; s < shards_.size(); ++s) {
+            Shard& shard = *shards_[s];
+            PlacementResult result;
+            shard.thread = spawn_placed_thread("matcher." + std::to_string(s), shard.placement,
+                                               [this, s] { run_shard(s); }, result, true);
+            if (!shard.thread.joinable()) {
+                throw std::runtime_error("Failed to place shard " + std::to_string(s) + ": " + result.error);
+            }
+        }
+    }
+
+    // Drains every queue, then joins the workers. Producers must have stopped.
+    void stop() {
+        if (!running_.exchange(false)) return;
+        for (auto& shard : shards_) {
+            shard->wait.wake_all();
+            if (shard->thread.joinable()) shard->thread.join();
+        }
+    }
+
+    // Called from producer thread `producer` only.
+    // @return `false` if the instrument is unknown or the shard's queue is full.
+    bool submit(size_t producer, const BookCommand& command) {
+        if (command.instrument_id >= num_instruments_) return false;
+        Shard& shard = *shards_[shard_of(command.instrument_id)];
+        return push_notify(*shard.queues[producer], command, shard.wait);
+    }
+
+    size_t shard_of(uint32_t instrument_id) const { return instrument_id % shards_.size(); }
+    size_t num_instruments() const { return num_instruments_; }
+    size_t num_shards() const { return shards_.size(); }
+
+    Book& book(uint32_t instrument_id) { return books_[instrument_id]; }
+    const Book& book(uint32_t instrument_id) const { return books_[instrument_id]; }
+
+    // Runs f(instrument_id, book) for every book on `pool`, e.g. to rebuild books
+    // at startup or gather statistics. Only while the shards are stopped.
+    template<typename F>
+    void for_each_book(WorkStealingPool& pool, F&& f) {
+        if (running_.load(std::memory_order_acquire)) {
+            throw std::runtime_error("BookManager::for_each_book needs the shards stopped");
+        }
+        pool.parallel_for(0, num_instruments_, 1, [&](size_t i) { f(static_cast<uint32_t>(i), books_[i]); });
+    }
+    
+    // Commands applied by a shard so far; exact once stop() has returned
+    uint64_t processed(size_t shard) const { return shards_[shard]->processed.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t max_burst = 64;  // Per queue per sweep, so one busy producer cannot starve others
+
+    // Heap-allocated and aligned so shard-local state never shares a cache line
+    struct alignas(64) Shard {
+        std::vector<std::unique_ptr<Fifo4<BookCommand>>> queues;
+        std::thread thread;
+        ThreadPlacement placement;
+        std::atomic<uint64_t> processed{0};
+        WaitStrategy wait;
+    };
+
+    size_t drain_once(Shard& shard) {
+        size_t applied = 0;
+        for (auto& queue : shard.queues) {
+            // Commands are applied in place and their slots released with one cursor store
+            auto burst = queue->claim_pop(max_burst);
+            for (const BookCommand& message : burst) {
+                books_[message.instrument_id].apply_batch(std::span<const OrderCommand>(&message.command, 1));
+            }
+            queue->commit_pop(burst.size());
+            applied += burst.size();
+        }
+        if (applied) {
+            shard.processed.store(shard.processed.load(std::memory_order_relaxed) + applied,
+                                  std::memory_order_relaxed);
+        }
+        return applied;
+    }
+    
+    bool has_pending(const Shard& shard) const {
+        for (auto& queue : shard.queues) {
+            if (!queue->empty()) return true;
+        }
+        return false;
+    }
+
+    void run_shard(size_t s) {
+        Shard& shard = *shards_[s];
+        unsigned idle = 0;
+        while (running_.load(std::memory_order_acquire)) {
+            if (drain_once(shard) != 0) {
+                idle = 0;
+                continue;
+            }
+            shard.wait.idle(idle++, [&] { return has_pending(shard) || !running_.load(std::memory_order_relaxed); });
+        }
+        while (drain_once(shard) != 0) {
+        }
+    }
+
+    Book* books_;
+    size_t num_instruments_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> running_;
+};
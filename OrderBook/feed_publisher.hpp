@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "order_book.hpp"
+#include "../L1/mocks/multicast_feed.hpp"
+
+// Publishes one book's market-by-price deltas and its trades on a
+// MulticastPublisher channel. It is the book's trade sink, so fills are
+// queued from the matching path as they happen:
+//
+//   MulticastPublisher publisher(MulticastConfig{}, channels);
+//   BasicOrderBook<BookFeedPublisher> book{BookFeedPublisher(&publisher, channel, instrument)};
+//   book.enable_level_deltas(4096);
+//   ...
+//   book.trade_sink().poll(book);   // Level deltas since the last poll
+//   publisher.flush();
+//   publisher.serve_recovery([&](uint16_t, auto& emit) { book.trade_sink().snapshot(book, emit); });
+//
+// Queuing never blocks, but a message that fills the publisher's batch
+// sends it from whichever call queued it; size the batch so that happens
+// off the matching path, or flush after each poll.
+//
+// Levels go out as LevelUpdate with the level total saturated at 2^32 - 1.
+// A trade's order_id is the resting order and its side the aggressor, as in
+// the exchange feed; crossed-book matching has no aggressor and counts the
+// buy. If the book's delta ring laps the publisher between polls, the
+// changes in between are lost, so the publisher sends BookClear and the
+// whole book, sequenced like any other message, and carries on from there.
+class BookFeedPublisher {
+public:
+    BookFeedPublisher() = default;
+    BookFeedPublisher(MulticastPublisher* publisher, uint16_t channel, uint32_t instrument)
+        : publisher_(publisher), channel_(channel), instrument_(instrument) {}
+
+    void on_trade(const TradeEvent& event) {
+        WireMessage message = make_message(MessageType::Trade, event.price, event.quantity);
+        message.order_id = event.buyer_aggressor ? event.sell_order_id : event.buy_order_id;
+        message.side = event.buyer_aggressor ? WireSide::Buy : WireSide::Sell;
+        publisher_->publish(message);
+    }
+
+    // Publishes every level delta since the last poll; returns the number of messages
+    template<typename Book>
+    size_t poll(const Book& book) {
+        std::array<LevelDelta, 64> batch;
+        size_t published = 0;
+        while (true) {
+            bool gap = false;
+            size_t count = book.level_deltas().read(cursor_, std::span<LevelDelta>(batch), gap);
+            if (gap) {
+                // The state now already includes every delta still in the ring
+                published += snapshot(book, [this](const WireMessage& message) { publisher_->publish(message); });
+                cursor_ = book.level_deltas().next_sequence();
+                return published;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const LevelDelta& delta = batch[i];
+                publisher_->publish(level_message(delta.is_buy, delta.price, delta.quantity));
+            }
+            published += count;
+            if (count < batch.size()) return published;
+        }
+    }
+
+    // Calls emit(message) with BookClear and then every level of the book;
+    // returns the number of messages
+    template<typename Book, typename Emit>
+    size_t snapshot(const Book& book, Emit&& emit) const {
+        std::vector<PriceLevel> bids, asks;
+        book.get_snapshot(std::max(book.get_bid_levels(), book.get_ask_levels()), bids, asks);
+        emit(make_message(MessageType::BookClear, 0.0, 0));
+        for (const PriceLevel& level : bids) emit(level_message(true, level.price, level.total_quantity));
+        for (const PriceLevel& level : asks) emit(level_message(false, level.price, level.total_quantity));
+        return 1 + bids.size() + asks.size();
+    }
+
+    uint16_t channel() const { return channel_; }
+    uint32_t instrument() const { return instrument_; }
+
+private:
+    WireMessage make_message(MessageType type, double price, uint64_t quantity) const {
+        WireMessage message{};
+        message.header.type = type;
+        message.header.channel = channel_;
+        message.header.instrument = instrument_;
+        message.price = static_cast<int64_t>(std::llround(price * wire_price_scale));
+        message.quantity = static_cast<uint32_t>(std::min<uint64_t>(quantity, std::numeric_limits<uint32_t>::max()));
+        return message;
+    }
+
+    WireMessage level_message(bool is_buy, double price, uint64_t quantity) const {
+        WireMessage message = make_message(MessageType::LevelUpdate, price, quantity);
+        message.side = is_buy ? WireSide::Buy : WireSide::Sell;
+        return message;
+    }
+
+    MulticastPublisher* publisher_ = nullptr;
+    uint16_t channel_ = 0;
+    uint32_t instrument_ = 0;
+    uint64_t cursor_ = 1;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "order_book.hpp"
+#include "../SPSC_QUEUES/spsc_q3.cpp"
+
+// Compile-time instrument configuration. Instruments whose tick size, band
+// and queue capacity are known when the program is built get a book and an
+// inbound queue with those values as constants:
+//
+//   constexpr InstrumentSpec es_spec{0.25, 1000.0, 9000.0, 4096};
+//   using ES = Instrument<es_spec>;
+//   ES::Book<TradeRecorder> book{TradeRecorder(64)};   // Ladder sized at compile time
+//   ES::Queue<OrderCommand> inbound;                   // cursor % 4096 becomes a mask
+//
+// Price-to-tick conversion multiplies by a constant reciprocal and
+// subtracts a constant floor, bounds checks compare against a constant,
+// and every "ladder or map?" branch is removed. The specialization depends
+// only on the spec's values, so instruments that trade on the same grid
+// share one: Instrument<a> and Instrument<b> are the same type when a == b.
+//
+// Instruments configured at run time keep using BasicOrderBook<Sink> with a
+// TickLadderConfig. with_instrument_grid() picks between the two from a
+// runtime config, so a feed handler can list the common grids once and fall
+// back for the rest.
+
+template<InstrumentSpec Spec>
+struct Instrument {
+    static constexpr InstrumentSpec spec = Spec;
+    using Grid = StaticTickGrid<Spec>;
+
+    template<typename TradeSink = NullTradeSink>
+    using Book = BasicOrderBook<TradeSink, Grid>;
+
+    template<typename T>
+    using Queue = Fifo3<T, std::allocator<T>, FixedCapacity<Spec.queue_capacity>>;
+};
+
+// Calls fn(grid) with StaticTickGrid<Spec> for the first of the listed
+// specs whose band matches `config` exactly, otherwise with
+// RuntimeTickGrid(config). fn is typically a generic lambda that builds a
+// BasicOrderBook<Sink, decltype(grid)> and runs the instrument's loop; it
+// must return the same type for every grid.
+template<typename Fn>
+decltype(auto) with_instrument_grid(const TickLadderConfig& config, Fn&& fn) {
+    return fn(RuntimeTickGrid(config));
+}
+
+template<InstrumentSpec First, InstrumentSpec... Rest, typename Fn>
+decltype(auto) with_instrument_grid(const TickLadderConfig& config, Fn&& fn) {
+    if (First.matches(config)) return fn(StaticTickGrid<First>{});
+    return with_instrument_grid<Rest...>(config, std::forward<Fn>(fn));
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "order_book.hpp"
+
+// Append-only binary journal of book calls, for rebuilding state after a
+// restart and replaying incidents.
+//
+// Every accepted add_order / submit_order / cancel_order / amend_order becomes one fixed
+// 48-byte record, numbered from the journal's first sequence. The matching
+// thread only pushes records into a Fifo4; a background thread drains it and
+// writes them out in large batches, so the hot path never touches the file.
+// A full queue stalls the caller instead of dropping, since a journal with a
+// hole would rebuild a different book.
+//
+// Replay memory-maps the file and drives the book straight from the mapping.
+// Order timestamps are journaled as resolved, so replay into an empty book
+// reproduces the original book exactly, trades and time priority included.
+// A record torn by a crash mid-write is ignored.
+
+enum class JournalOp : uint8_t { Add, Cancel, Amend };
+
+struct JournalRecord {
+    uint64_t sequence;
+    uint64_t order_id;
+    double price;           // Add, Amend
+    uint64_t quantity;      // Add, Amend
+    uint64_t timestamp_ns;  // Add: the order's time priority
+    JournalOp op;
+    uint8_t is_buy;         // Add
+    uint8_t match;          // match_immediately as passed
+    OrderType order_type;   // Add: Limit for add_order, else the submit_order type
+    uint8_t reserved[4];
+};
+
+static_assert(sizeof(JournalRecord) == 48);
+
+struct JournalHeader {
+    char magic[8];          // "OBJRNL\0\0"
+    uint32_t version;
+    uint32_t record_size;
+};
+
+static_assert(sizeof(JournalHeader) == 16);
+
+constexpr char journal_magic[8] = {'O', 'B', 'J', 'R', 'N', 'L', 0, 0};
+constexpr uint32_t journal_version = 1;
+
+// Owns the journal file and its writer thread. append() must be called from
+// one thread, the one driving the book.
+class JournalWriter {
+public:
+    explicit JournalWriter(const std::string& path, uint64_t first_sequence = 1, size_t queue_capacity = 65536)
+        : queue_(queue_capacity), next_sequence_(first_sequence), full_stalls_(0),
+          written_(0), failed_(false), running_(true) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Cannot open journal " + path + ": " + std::strerror(errno));
+        }
+        JournalHeader header{};
+        std::memcpy(header.magic, journal_magic, sizeof(header.magic));
+        header.version = journal_version;
+        header.record_size = sizeof(JournalRecord);
+        if (!write_all(&header, sizeof(header))) {
+            ::close(fd_);
+            throw std::runtime_error("Cannot write journal header to " + path);
+        }
+        thread_ = std::thread([this] { run(); });
+    }
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    // Writes everything appended before destruction and syncs the file
+    ~JournalWriter() {
+        running_.store(false, std::memory_order_release);
+        thread_.join();
+        ::fdatasync(fd_);
+        ::close(fd_);
+    }
+
+    // Numbers the record and queues it; spins while the writer is behind
+    void append(JournalRecord record) {
+        record.sequence = next_sequence_++;
+        if (!queue_.push(record)) {
+            full_stalls_++;
+            while (!queue_.push(record)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    uint64_t next_sequence() const { return next_sequence_; }
+    uint64_t full_stalls() const { return full_stalls_; }
+    uint64_t records_written() const { return written_.load(std::memory_order_acquire); }
+    bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+private:
+    void run() {
+        std::vector<JournalRecord> batch(1024);
+        while (true) {
+            size_t count = drain(batch);
+            if (count > 0) {
+                flush(batch.data(), count);
+            } else if (!running_.load(std::memory_order_acquire)) {
+                while ((count = drain(batch)) > 0) {
+                    flush(batch.data(), count);
+                }
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    size_t drain(std::vector<JournalRecord>& batch) {
+        size_t count = 0;
+        while (count < batch.size() && queue_.pop(batch[count])) {
+            count++;
+        }
+        return count;
+    }
+
+    void flush(const JournalRecord* records, size_t count) {
+        if (failed_.load(std::memory_order_relaxed)) return;
+        if (write_all(records, count * sizeof(JournalRecord))) {
+            written_.fetch_add(count, std::memory_order_release);
+        } else {
+            failed_.store(true, std::memory_order_release);  // Later records would follow a hole
+        }
+    }
+
+    bool write_all(const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd_, p, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    Fifo4<JournalRecord> queue_;
+    int fd_;
+    uint64_t next_sequence_;
+    uint64_t full_stalls_;
+    std::atomic<uint64_t> written_;
+    std::atomic<bool> failed_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+// Forwards book calls and journals the ones the book accepted. Queries go
+// through book().
+template<typename Book = OrderBook>
+class JournaledOrderBook {
+public:
+    JournaledOrderBook(Book& book, JournalWriter& journal) : book_(book), journal_(journal) {}
+
+    void add_order(const Order& order, bool match_immediately = true) {
+        Order stamped = order;
+        if (stamped.timestamp_ns == 0) {
+            // Stamp here rather than in the book, so replay gets the same time priority
+            stamped.timestamp_ns = tsc_clock().now_ns();
+        }
+        book_.add_order(stamped, match_immediately);
+        journal_.append(JournalRecord{0, stamped.order_id, stamped.price, stamped.quantity, stamped.timestamp_ns,
+                                      JournalOp::Add, stamped.is_buy, match_immediately, OrderType::Limit, {}});
+    }
+
+    ExecutionReport submit_order(const Order& order, OrderType type = OrderType::Limit) {
+        Order stamped = order;
+        if (stamped.timestamp_ns == 0) {
+            stamped.timestamp_ns = tsc_clock().now_ns();
+        }
+        ExecutionReport report = book_.submit_order(stamped, type);
+        journal_.append(JournalRecord{0, stamped.order_id, stamped.price, stamped.quantity, stamped.timestamp_ns,
+                                      JournalOp::Add, stamped.is_buy, 1, type, {}});
+        return report;
+    }
+
+    bool cancel_order(uint64_t order_id) {
+        if (!book_.cancel_order(order_id)) return false;
+        journal_.append(JournalRecord{0, order_id, 0.0, 0, 0, JournalOp::Cancel, 0, 0, OrderType::Limit, {}});
+        return true;
+    }
+
+    bool amend_order(uint64_t order_id, double new_price, uint64_t new_quantity, bool match_immediately = true) {
+        if (!book_.amend_order(order_id, new_price, new_quantity, match_immediately)) return false;
+        journal_.append(JournalRecord{0, order_id, new_price, new_quantity, 0, JournalOp::Amend, 0,
+                                      match_immediately, OrderType::Limit, {}});
+        return true;
+    }
+
+    Book& book() { return book_; }
+    const Book& book() const { return book_; }
+
+private:
+    Book& book_;
+    JournalWriter& journal_;
+};
+
+// Read-only mapping of a whole file, populated up front for sequential reads
+class MappedFile {
+public:
+    MappedFile(const std::string& path, size_t min_size) : data_(nullptr), size_(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < std::max<size_t>(min_size, 1)) {
+            ::close(fd);
+            throw std::runtime_error(path + " is truncated");
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        data_ = static_cast<const std::byte*>(data);
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+
+    std::span<const std::byte> bytes() const { return {data_, size_}; }
+
+private:
+    const std::byte* data_;
+    size_t size_;
+};
+
+// Read-only mapping of a journal file
+class MappedJournal {
+public:
+    explicit MappedJournal(const std::string& path) : file_(path, sizeof(JournalHeader)) {
+        const auto* header = reinterpret_cast<const JournalHeader*>(file_.bytes().data());
+        if (std::memcmp(header->magic, journal_magic, sizeof(journal_magic)) != 0 ||
+            header->version != journal_version || header->record_size != sizeof(JournalRecord)) {
+            throw std::runtime_error("Journal " + path + " has an unknown format");
+        }
+    }
+
+    // Every complete record; a torn trailing record is left out
+    std::span<const JournalRecord> records() const {
+        std::span<const std::byte> bytes = file_.bytes();
+        return {reinterpret_cast<const JournalRecord*>(bytes.data() + sizeof(JournalHeader)),
+                (bytes.size() - sizeof(JournalHeader)) / sizeof(JournalRecord)};
+    }
+
+private:
+    MappedFile file_;
+};
+
+struct ReplayResult {
+    uint64_t applied;
+    uint64_t skipped;        // At or below the starting sequence
+    uint64_t rejected;       // The book refused the call: the journal does not fit its state
+    uint64_t last_sequence;  // Of the last record applied
+};
+
+// Applies every record after `after_sequence`, e.g. the sequence a snapshot was
+// taken at, to `book`
+template<typename Book>
+ReplayResult replay_journal(std::span<const JournalRecord> records, Book& book, uint64_t after_sequence = 0) {
+    ReplayResult result{0, 0, 0, after_sequence};
+    for (const JournalRecord& record : records) {
+        if (record.sequence <= after_sequence) {
+            result.skipped++;
+            continue;
+        }
+        bool ok = true;
+        try {
+            switch (record.op) {
+            case JournalOp::Add: {
+                Order order{record.order_id, record.is_buy != 0, record.price, record.quantity, record.timestamp_ns};
+                if (record.order_type == OrderType::Limit) {
+                    book.add_order(order, record.match != 0);
+                } else {
+                    book.submit_order(order, record.order_type);
+                }
+                break;
+            }
+            case JournalOp::Cancel:
+                ok = book.cancel_order(record.order_id);
+                break;
+            case JournalOp::Amend:
+                ok = book.amend_order(record.order_id, record.price, record.quantity, record.match != 0);
+                break;
+            }
+        } catch (const std::runtime_error&) {
+            ok = false;
+        }
+        if (ok) {
+            result.applied++;
+        } else {
+            result.rejected++;
+        }
+        result.last_sequence = record.sequence;
+    }
+    return result;
+}
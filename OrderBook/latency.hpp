@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "tsc_clock.hpp"
+
+// TSC timing and percentile reporting shared by the benchmarks and the
+// tick-to-trade pipeline, on the process-wide tsc_clock().
+
+// Serialised TSC read for the start of a timed region
+inline uint64_t read_cycles() { return tsc_read<TscFence::LFence>(); }
+
+// Cycles per nanosecond of the process-wide clock
+inline double calibrate_cycles_per_ns() { return tsc_clock().cycles_per_ns(); }
+
+// One line on the clock's health: invariance and cross-core offsets
+inline void report_clock(std::ostream& out) {
+    TscCoreCheck cores = tsc_clock().check_cores();
+    out << "TSC: " << std::fixed << std::setprecision(3) << tsc_clock().cycles_per_ns() << " cycles/ns, "
+        << (tsc_invariant() ? "invariant" : "NOT invariant") << ", max offset " << std::setprecision(1)
+        << cores.max_offset_ns << " ns (+/- " << cores.error_ns << ") over " << cores.cpus << " cpus" << std::endl;
+}
+
+// Cost of one read_cycles() pair, to subtract from samples
+inline uint64_t timer_overhead_cycles() {
+    uint64_t overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t start = read_cycles();
+        uint64_t end = read_cycles();
+        overhead = std::min(overhead, end - start);
+    }
+    return overhead;
+}
+
+// Collects cycle samples and prints count, p50, p99, p99.9 and max in ns,
+// followed by any `extra` columns the caller has formatted
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t capacity) { samples_.reserve(capacity); }
+
+    void record(uint64_t cycles) { samples_.push_back(cycles); }
+    void clear() { samples_.clear(); }
+
+    void report(const std::string& name, double cycles_per_ns, uint64_t overhead, const std::string& extra = "") {
+        if (samples_.empty()) return;
+        for (auto& sample : samples_) {
+            sample = sample > overhead ? sample - overhead : 0;
+        }
+        std::sort(samples_.begin(), samples_.end());
+        auto ns = [&](double quantile) {
+            size_t index = std::min(samples_.size() - 1, static_cast<size_t>(quantile * static_cast<double>(samples_.size())));
+            return static_cast<double>(samples_[index]) / cycles_per_ns;
+        };
+        // A space before every field, inside the header widths, so long values never run together
+        std::cout << std::left << std::setw(34) << name << std::right
+                  << ' ' << std::setw(8) << samples_.size()
+                  << std::fixed << std::setprecision(1)
+                  << ' ' << std::setw(9) << ns(0.50)
+                  << ' ' << std::setw(9) << ns(0.99)
+                  << ' ' << std::setw(9) << ns(0.999)
+                  << ' ' << std::setw(11) << static_cast<double>(samples_.back()) / cycles_per_ns << extra << std::endl;
+        samples_.clear();
+    }
+
+private:
+    std::vector<uint64_t> samples_;
+};
@@ -2,443 +2,55 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
-#include <map>
-#include <memory>
-#include <chrono>
 #include <iostream>
 #include <iomanip>
-#include <algorithm>
-#include <set>
+#include <sstream>
 #include <cassert>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
-struct Order {
-    uint64_t order_id;
-    bool is_buy;  // true for buy, false for sell
-    double price;
-    uint64_t quantity;
-    uint64_t timestamp_ns;
-};
+#include "order_book.hpp"
+#include "book_manager.hpp"
+#include "journal.hpp"
+#include "book_image.hpp"
+#include "strategy.hpp"
+#include "instrument.hpp"
+#include "feed_publisher.hpp"
+#include "thread_runtime.hpp"
+#include "risk_gate.hpp"
+#include "../L5/arena_allocator.hpp"
+#include "../L1/mocks/feed_sequencer.hpp"
 
-struct PriceLevel {
-    double price;
-    uint64_t total_quantity;
-    
-    PriceLevel(double p, uint64_t qty) : price(p), total_quantity(qty) {}
-    
-    bool operator==(const PriceLevel& other) const {
-        return price == other.price && total_quantity == other.total_quantity;
+// Strategies for Test 28; local classes cannot have member templates
+struct DeltaCounter : Strategy<DeltaCounter> {
+    static constexpr const char* name = "deltas";
+    uint64_t deltas = 0, deletes = 0, gaps = 0;
+    template<typename Book>
+    void on_book_update(const LevelDelta& delta, const Book&) {
+        deltas++;
+        deletes += delta.action == LevelAction::Delete;
     }
+    template<typename Book>
+    void on_book_gap(const Book&) { gaps++; }
 };
 
-class OrderBook {
-private:
-    struct OrderNode {
-        Order order;
-        OrderNode* next;
-        OrderNode* prev;
-        
-        OrderNode(const Order& ord) : order(ord), next(nullptr), prev(nullptr) {}
-    };
-    
-    struct PriceLevelData {
-        uint64_t total_quantity;
-        OrderNode* head;
-        OrderNode* tail;
-        
-        PriceLevelData() : total_quantity(0), head(nullptr), tail(nullptr) {}
-    };
-    
-    // Bid side (buy orders) - sorted descending by price
-    std::map<double, PriceLevelData, std::greater<double>> bids_;
-    
-    // Ask side (sell orders) - sorted ascending by price  
-    std::map<double, PriceLevelData, std::less<double>> asks_;
-    
-    // Order lookup for O(1) access
-    std::unordered_map<uint64_t, OrderNode*> order_lookup_;
-    
-    // Trading statistics
-    uint64_t total_trades_;
-    uint64_t total_volume_;
-    
-    uint64_t get_current_timestamp() const {
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    }
-    
-    void add_order_to_side(const Order& order, std::map<double, PriceLevelData, std::greater<double>>& side) {
-        OrderNode* new_node = new OrderNode(order);
-        order_lookup_[order.order_id] = new_node;
-        
-        auto& level_data = side[order.price];
-        level_data.total_quantity += order.quantity;
-        
-        // Add to the tail of the price level (FIFO)
-        if (!level_data.head) {
-            level_data.head = level_data.tail = new_node;
-        } else {
-            level_data.tail->next = new_node;
-            new_node->prev = level_data.tail;
-            level_data.tail = new_node;
-        }
-    }
-    
-    void add_order_to_side(const Order& order, std::map<double, PriceLevelData, std::less<double>>& side) {
-        OrderNode* new_node = new OrderNode(order);
-        order_lookup_[order.order_id] = new_node;
-        
-        auto& level_data = side[order.price];
-        level_data.total_quantity += order.quantity;
-        
-        // Add to the tail of the price level (FIFO)
-        if (!level_data.head) {
-            level_data.head = level_data.tail = new_node;
-        } else {
-            level_data.tail->next = new_node;
-            new_node->prev = level_data.tail;
-            level_data.tail = new_node;
-        }
-    }
-    
-    bool remove_order_from_side(uint64_t order_id, std::map<double, PriceLevelData, std::greater<double>>& side) {
-        auto node_it = order_lookup_.find(order_id);
-        if (node_it == order_lookup_.end()) return false;
-        
-        OrderNode* node = node_it->second;
-        double price = node->order.price;
-        
-        auto level_it = side.find(price);
-        if (level_it == side.end()) return false;
-        
-        auto& level_data = level_it->second;
-        
-        // Update quantity
-        if (level_data.total_quantity >= node->order.quantity) {
-            level_data.total_quantity -= node->order.quantity;
-        } else {
-            level_data.total_quantity = 0;
-        }
-        
-        // Remove from linked list
-        if (node->prev) node->prev->next = node->next;
-        if (node->next) node->next->prev = node->prev;
-        
-        if (node == level_data.head) level_data.head = node->next;
-        if (node == level_data.tail) level_data.tail = node->prev;
-        
-        // Remove price level if empty
-        if (!level_data.head) {
-            side.erase(level_it);
-        }
-        
-        delete node;
-        order_lookup_.erase(node_it);
-        return true;
-    }
-    
-    bool remove_order_from_side(uint64_t order_id, std::map<double, PriceLevelData, std::less<double>>& side) {
-        auto node_it = order_lookup_.find(order_id);
-        if (node_it == order_lookup_.end()) return false;
-        
-        OrderNode* node = node_it->second;
-        double price = node->order.price;
-        
-        auto level_it = side.find(price);
-        if (level_it == side.end()) return false;
-        
-        auto& level_data = level_it->second;
-        
-        if (level_data.total_quantity >= node->order.quantity) {
-            level_data.total_quantity -= node->order.quantity;
-        } else {
-            level_data.total_quantity = 0;
-        }
-        
-        if (node->prev) node->prev->next = node->next;
-        if (node->next) node->next->prev = node->prev;
-        
-        if (node == level_data.head) level_data.head = node->next;
-        if (node == level_data.tail) level_data.tail = node->prev;
-        
-        if (!level_data.head) {
-            side.erase(level_it);
-        }
-        
-        delete node;
-        order_lookup_.erase(node_it);
-        return true;
-    }
-    
-    void execute_trade(OrderNode* buy_order, OrderNode* sell_order, uint64_t trade_quantity) {
-        double trade_price = std::min(buy_order->order.price, sell_order->order.price);
-        
-        std::cout << "TRADE: " << trade_quantity << " @ " << trade_price 
-                  << " (Buy: " << buy_order->order.order_id 
-                  << ", Sell: " << sell_order->order.order_id << ")" << std::endl;
-        
-        total_trades_++;
-        total_volume_ += trade_quantity;
-        
-        // Update quantities
-        buy_order->order.quantity -= trade_quantity;
-        sell_order->order.quantity -= trade_quantity;
-        
-        // Update price level quantities
-        auto buy_level_it = bids_.find(buy_order->order.price);
-        if (buy_level_it != bids_.end()) {
-            buy_level_it->second.total_quantity -= trade_quantity;
-        }
-        
-        auto sell_level_it = asks_.find(sell_order->order.price);
-        if (sell_level_it != asks_.end()) {
-            sell_level_it->second.total_quantity -= trade_quantity;
-        }
-        
-        // Remove fully filled orders
-        if (buy_order->order.quantity == 0) {
-            remove_order_from_side(buy_order->order.order_id, bids_);
-        }
-        if (sell_order->order.quantity == 0) {
-            remove_order_from_side(sell_order->order.order_id, asks_);
-        }
-    }
-    
-    void process_matching() {
-        while (!bids_.empty() && !asks_.empty()) {
-            double best_bid = bids_.begin()->first;
-            double best_ask = asks_.begin()->first;
-            
-            if (best_bid < best_ask) {
-                break; // No crossing
-            }
-            
-            // Get the first orders at best bid/ask
-            OrderNode* best_buy_order = bids_.begin()->second.head;
-            OrderNode* best_sell_order = asks_.begin()->second.head;
-            
-            if (!best_buy_order || !best_sell_order) {
-                break;
-            }
-            
-            uint64_t trade_quantity = std::min(best_buy_order->order.quantity, best_sell_order->order.quantity);
-            execute_trade(best_buy_order, best_sell_order, trade_quantity);
-        }
-    }
+struct FillCounter : Strategy<FillCounter> {
+    static constexpr const char* name = "fills";
+    uint64_t volume = 0;
+    void on_trade(const TradeEvent& event) { volume += event.quantity; }
+};
 
-public:
-    OrderBook() : total_trades_(0), total_volume_(0) {}
-    
-    ~OrderBook() {
-        // Cleanup all orders
-        for (auto& [order_id, node] : order_lookup_) {
-            delete node;
-        }
-    }
-    
-    // Core interface
-    void add_order(const Order& order, bool match_immediately = true) {
-        if (order_lookup_.find(order.order_id) != order_lookup_.end()) {
-            throw std::runtime_error("Order ID " + std::to_string(order.order_id) + " already exists");
-        }
-        
-        if (order.quantity == 0) {
-            throw std::runtime_error("Order quantity cannot be zero");
-        }
-        
-        if (order.price <= 0.0) {
-            throw std::runtime_error("Invalid price: " + std::to_string(order.price));
-        }
-        
-        Order order_with_ts = order;
-        if (order_with_ts.timestamp_ns == 0) {
-            order_with_ts.timestamp_ns = get_current_timestamp();
-        }
-        
-        if (order_with_ts.is_buy) {
-            add_order_to_side(order_with_ts, bids_);
-        } else {
-            add_order_to_side(order_with_ts, asks_);
-        }
-        
-        // Try to match orders
-        if (match_immediately) {
-            process_matching();
-        }
-    }
-    
-    bool cancel_order(uint64_t order_id) {
-        auto it = order_lookup_.find(order_id);
-        if (it == order_lookup_.end()) {
-            return false;
-        }
-        
-        OrderNode* node = it->second;
-        bool success = false;
-        
-        if (node->order.is_buy) {
-            success = remove_order_from_side(order_id, bids_);
-        } else {
-            success = remove_order_from_side(order_id, asks_);
-        }
-        
-        return success;
-    }
-    
-    bool amend_order(uint64_t order_id, double new_price, uint64_t new_quantity, bool match_immediately = true) {
-        auto it = order_lookup_.find(order_id);
-        if (it == order_lookup_.end()) {
-            return false;
-        }
-        
-        if (new_quantity == 0) {
-            throw std::runtime_error("New quantity cannot be zero");
-        }
-        
-        if (new_price <= 0.0) {
-            throw std::runtime_error("Invalid new price: " + std::to_string(new_price));
-        }
-        
-        OrderNode* node = it->second;
-        Order& existing_order = node->order;
-        
-        // Check if price changed
-        bool price_changed = std::abs(existing_order.price - new_price) > 1e-12;
-        
-        if (price_changed) {
-            // Cancel and re-add
-            Order new_order = existing_order;
-            new_order.price = new_price;
-            new_order.quantity = new_quantity;
-            
-            // Cancel old order
-            if (!cancel_order(order_id)) {
-                return false;
-            }
-            
-            // Add new order
-            add_order(new_order, match_immediately);
-        } else {
-            // Update quantity in place
-            int64_t quantity_diff = static_cast<int64_t>(new_quantity) - static_cast<int64_t>(existing_order.quantity);
-            
-            if (existing_order.is_buy) {
-                auto level_it = bids_.find(existing_order.price);
-                if (level_it != bids_.end()) {
-                    level_it->second.total_quantity += quantity_diff;
-                }
-            } else {
-                auto level_it = asks_.find(existing_order.price);
-                if (level_it != asks_.end()) {
-                    level_it->second.total_quantity += quantity_diff;
-                }
-            }
-            existing_order.quantity = new_quantity;
-        }
-        
-        // Try to match after amendment
-        if (match_immediately) {
-            process_matching();
-        }
-        return true;
-    }
-    
-    void get_snapshot(size_t depth, std::vector<PriceLevel>& bids, std::vector<PriceLevel>& asks) const {
-        bids.clear();
-        asks.clear();
-        
-        // Get top bids (highest prices first)
-        size_t count = 0;
-        for (const auto& [price, level_data] : bids_) {
-            if (count++ >= depth) break;
-            bids.push_back(PriceLevel(price, level_data.total_quantity));
-        }
-        
-        // Get top asks (lowest prices first)
-        count = 0;
-        for (const auto& [price, level_data] : asks_) {
-            if (count++ >= depth) break;
-            asks.push_back(PriceLevel(price, level_data.total_quantity));
-        }
-    }
-    
-    void print_book(size_t depth = 10) const {
-        std::vector<PriceLevel> bids, asks;
-        get_snapshot(depth, bids, asks);
-        
-        std::cout << "\n=== ORDER BOOK (Top " << depth << ") ===" << std::endl;
-        std::cout << std::setw(12) << "BID QTY" << " | " << std::setw(10) << "PRICE" 
-                  << " || " << std::setw(10) << "PRICE" << " | " << std::setw(12) << "ASK QTY" << std::endl;
-        std::cout << std::string(60, '-') << std::endl;
-        
-        size_t max_levels = std::max(bids.size(), asks.size());
-        
-        for (size_t i = 0; i < max_levels; ++i) {
-            if (i < bids.size()) {
-                std::cout << std::setw(12) << bids[i].total_quantity << " | " 
-                          << std::setw(10) << std::fixed << std::setprecision(4) << bids[i].price;
-            } else {
-                std::cout << std::setw(12) << " " << " | " << std::setw(10) << " ";
-            }
-            
-            std::cout << " || ";
-            
-            if (i < asks.size()) {
-                std::cout << std::setw(10) << std::fixed << std::setprecision(4) << asks[i].price << " | " 
-                          << std::setw(12) << asks[i].total_quantity;
-            } else {
-                std::cout << std::setw(10) << " " << " | " << std::setw(12) << " ";
-            }
-            std::cout << std::endl;
-        }
-        
-        std::cout << "Total Orders: " << get_total_orders() 
-                  << " (Bids: " << get_bid_levels() << " levels, "
-                  << "Asks: " << get_ask_levels() << " levels)" << std::endl;
-        std::cout << "Trades: " << total_trades_ << ", Volume: " << total_volume_ << std::endl;
-    }
-    
-    // Additional utility methods
-    size_t get_total_orders() const { return order_lookup_.size(); }
-    size_t get_bid_levels() const { return bids_.size(); }
-    size_t get_ask_levels() const { return asks_.size(); }
-    bool order_exists(uint64_t order_id) const { 
-        return order_lookup_.find(order_id) != order_lookup_.end(); 
-    }
-    double get_best_bid() const { 
-        return bids_.empty() ? 0.0 : bids_.begin()->first; 
-    }
-    double get_best_ask() const { 
-        return asks_.empty() ? 0.0 : asks_.begin()->first; 
-    }
-    double get_spread() const {
-        return get_best_ask() - get_best_bid();
-    }
-    
-    void get_statistics(uint64_t& trades, uint64_t& volume, size_t& active_orders) const {
-        trades = total_trades_;
-        volume = total_volume_;
-        active_orders = order_lookup_.size();
-    }
-    
-    void print_order(uint64_t order_id) const {
-        auto it = order_lookup_.find(order_id);
-        if (it == order_lookup_.end()) {
-            std::cout << "Order " << order_id << " not found" << std::endl;
-            return;
-        }
-        
-        const Order& order = it->second->order;
-        std::cout << "Order " << order_id << ": " 
-                  << (order.is_buy ? "BUY" : "SELL") 
-                  << " " << order.quantity << " @ " << order.price 
-                  << " (TS: " << order.timestamp_ns << ")" << std::endl;
-    }
-    
-    // Manual matching control
-    void match_orders() {
-        process_matching();
-    }
+// Handler for Test 35: records what the sequencer delivers and asks for
+struct SequencerRecorder {
+    std::vector<uint64_t> delivered;
+    std::vector<std::pair<uint64_t, uint64_t>> replays;
+    std::vector<uint64_t> snapshots;
+
+    void on_sequenced(const WireMessage& message) { delivered.push_back(message.header.sequence); }
+    void on_replay_request(uint16_t, uint64_t first, uint64_t last) { replays.emplace_back(first, last); }
+    void on_snapshot_request(uint16_t, uint64_t from) { snapshots.push_back(from); }
 };
 
 //All different types of test
@@ -579,6 +191,1475 @@ void run_comprehensive_tests() {
     }
     total++;
     
+    // Test 8: Tick Ladder Mode
+    {
+        OrderBook book(TickLadderConfig{0.01, 90.0, 110.0});
+        book.add_order(Order{1, true, 100.00, 100, 1});
+        book.add_order(Order{2, true, 100.00, 200, 2});
+        book.add_order(Order{3, true, 101.00, 50, 3});
+        book.add_order(Order{4, false, 101.50, 80, 4});
+        
+        std::vector<PriceLevel> bids, asks;
+        book.get_snapshot(5, bids, asks);
+        assert(bids.size() == 2);
+        assert(bids[0].price == 101.0 && bids[0].total_quantity == 50);
+        assert(bids[1].price == 100.0 && bids[1].total_quantity == 300);
+        assert(book.get_best_ask() == 101.5);
+        
+        // Aggressive sell sweeps the best bid and rests the remainder
+        book.add_order(Order{5, false, 100.00, 120, 5});
+        assert(book.order_exists(3) == false);
+        assert(book.order_exists(5) == false);
+        assert(book.get_best_bid() == 100.0);
+        book.get_snapshot(5, bids, asks);
+        assert(bids[0].total_quantity == 230);
+        
+        // Cancelling the last order at the touch moves best bid down the ladder
+        book.add_order(Order{6, true, 99.50, 10, 6});
+        assert(book.cancel_order(1) == true);
+        assert(book.get_best_bid() == 100.0);
+        assert(book.cancel_order(2) == true);
+        assert(book.get_best_bid() == 99.5);
+        
+        try {
+            book.add_order(Order{7, true, 120.0, 10, 7});
+            assert(false);
+        } catch (const std::runtime_error&) {
+            // Expected: outside the configured band
+        }
+        try {
+            book.add_order(Order{8, true, 100.005, 10, 8});
+            assert(false);
+        } catch (const std::runtime_error&) {
+            // Expected: off the tick grid
+        }
+        assert(book.get_total_orders() == 2);
+        std::cout << "✓ Test 8: Tick Ladder Mode - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 9: Pooled Node Recycling
+    {
+        OrderBook book;
+        book.reserve_orders(500);
+        size_t capacity = book.get_order_capacity();
+        assert(capacity >= 500);
+        
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 500; ++i) {
+                book.add_order(Order{static_cast<uint64_t>(i + 1), i % 2 == 0,
+                                     i % 2 == 0 ? 99.0 : 101.0, 10, 1}, false);
+            }
+            for (int i = 0; i < 500; ++i) {
+                assert(book.cancel_order(static_cast<uint64_t>(i + 1)));
+            }
+        }
+        
+        // Freed nodes are reused, so the pool never grows past the reservation
+        assert(book.get_total_orders() == 0);
+        assert(book.get_order_capacity() == capacity);
+        std::cout << "✓ Test 9: Pooled Node Recycling - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 10: Open-Addressing Id Index
+    {
+        OrderIdMap<int> index;
+        std::unordered_map<uint64_t, int*> reference;
+        std::vector<int> values(4096);
+        
+        // Strided ids collide in the low bits; interleave inserts and erases
+        for (uint64_t i = 0; i < values.size(); ++i) {
+            uint64_t id = i * 1024;
+            index.insert(id, &values[i]);
+            reference[id] = &values[i];
+            if (i % 3 == 0) {
+                uint64_t victim = (i / 2) * 1024;
+                assert(index.erase(victim) == (reference.erase(victim) == 1));
+            }
+        }
+        
+        assert(index.size() == reference.size());
+        for (uint64_t i = 0; i < values.size(); ++i) {
+            uint64_t id = i * 1024;
+            auto it = reference.find(id);
+            assert(index.find(id) == (it == reference.end() ? nullptr : it->second));
+        }
+        assert(index.erase(7) == false);
+        std::cout << "✓ Test 10: Open-Addressing Id Index - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 11: Trade Event Sinks
+    {
+        BasicOrderBook<TradeRecorder> book{TradeRecorder(2)};
+        book.add_order(Order{1, true, 100.0, 100, 1});
+        book.add_order(Order{2, true, 99.0, 100, 2});
+        book.add_order(Order{3, false, 98.0, 250, 3});   // Sweeps both bids, rests 50
+        book.add_order(Order{4, true, 98.0, 50, 4});     // Third fill overflows the buffer
+        
+        const TradeRecorder& fills = book.trade_sink();
+        assert(fills.size() == 2 && fills.dropped() == 1);
+        assert(fills[0].trade_id == 1 && fills[0].buy_order_id == 1 && fills[0].sell_order_id == 3);
+        assert(fills[0].quantity == 100 && fills[0].price == 100.0);   // At the resting bid
+        assert(fills[1].buy_order_id == 2 && fills[1].quantity == 100);
+        
+        // Fills handed across a Fifo4 are written by the logger thread
+        std::ostringstream log;
+        {
+            AsyncTradeLogger logger(log, 64);
+            BasicOrderBook<QueueTradeSink> queued_book{QueueTradeSink{&logger.queue()}};
+            queued_book.add_order(Order{1, true, 100.0, 10, 1});
+            queued_book.add_order(Order{2, false, 100.0, 10, 2});
+            assert(queued_book.trade_sink().dropped == 0);
+        }
+        assert(log.str() == "TRADE: 10 @ 100 (Buy: 1, Sell: 2)\n");
+        std::cout << "✓ Test 11: Trade Event Sinks - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 12: Batch Submission
+    {
+        OrderBook book;
+        book.add_order(Order{1, false, 101.0, 100, 1});
+        
+        // The crossing pair is cancelled before the batch's matching pass runs
+        const OrderCommand packet[] = {
+            OrderCommand::add(Order{2, true, 101.0, 40, 0}),
+            OrderCommand::add(Order{3, true, 100.0, 60, 0}),
+            OrderCommand::add(Order{4, true, 102.0, 10, 0}),
+            OrderCommand::cancel(4),
+            OrderCommand::amend(3, 101.0, 70),
+            OrderCommand::add(Order{2, true, 99.0, 10, 0}),   // Duplicate id
+            OrderCommand::cancel(42),                        // Unknown id
+            OrderCommand::add(Order{5, true, 99.0, 0, 0}),    // Zero quantity
+        };
+        CommandStatus statuses[std::size(packet)];
+        BatchResult result = book.apply_batch(packet, statuses);
+        
+        assert(result.accepted == 5 && result.rejected == 3);
+        assert(statuses[5] == CommandStatus::DuplicateOrderId);
+        assert(statuses[6] == CommandStatus::UnknownOrderId);
+        assert(statuses[7] == CommandStatus::InvalidQuantity);
+        
+        // Order 2 (40) then the amended order 3 (70) fill against the resting 100
+        assert(result.trades == 2 && result.volume == 100);
+        assert(book.order_exists(1) == false && book.order_exists(2) == false);
+        assert(book.order_exists(3) == true);
+        std::vector<PriceLevel> bids, asks;
+        book.get_snapshot(5, bids, asks);
+        assert(bids.size() == 1 && bids[0].total_quantity == 10 && asks.empty());
+        std::cout << "✓ Test 12: Batch Submission - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 13: Incremental Depth Cache
+    {
+        OrderBook map_book;
+        OrderBook ladder_book(TickLadderConfig{0.5, 50.0, 150.0});
+        for (OrderBook* book : {&map_book, &ladder_book}) {
+            DepthSnapshot depth;
+            uint64_t seen = book->get_version();
+            assert(book->get_depth(depth, seen) == false);
+            
+            // Random mix of adds, cancels, amends and crossing orders; the cached
+            // top levels must always equal a full walk of the book
+            uint64_t seed = 12345;
+            auto next = [&seed]() { seed = seed * 6364136223846793005ull + 1442695040888963407ull; return seed >> 33; };
+            std::vector<PriceLevel> cached_bids, cached_asks, full_bids, full_asks;
+            for (uint64_t id = 1; id <= 3000; ++id) {
+                uint64_t action = next() % 10;
+                if (action < 6) {
+                    bool is_buy = next() % 2 == 0;
+                    double price = 100.0 + (is_buy ? -1.0 : 1.0) * 0.5 * static_cast<double>(next() % 30)
+                                   + (next() % 20 == 0 ? (is_buy ? 3.0 : -3.0) : 0.0);
+                    book->add_order(Order{id, is_buy, price, 1 + next() % 100, id});
+                } else if (action < 8) {
+                    book->cancel_order(next() % id);
+                } else {
+                    uint64_t target = next() % id;
+                    if (book->order_exists(target)) book->amend_order(target, 100.0, 1 + next() % 50);
+                }
+                
+                book->get_snapshot(DepthSnapshot::max_depth, cached_bids, cached_asks);
+                book->get_snapshot(1000, full_bids, full_asks);
+                full_bids.resize(std::min(full_bids.size(), DepthSnapshot::max_depth));
+                full_asks.resize(std::min(full_asks.size(), DepthSnapshot::max_depth));
+                assert(cached_bids == full_bids && cached_asks == full_asks);
+            }
+            
+            assert(book->get_version() != seen);
+            assert(book->get_depth(depth, seen) == true);
+            assert(depth.version == book->get_version());
+            assert(depth.bid_count == cached_bids.size() && depth.ask_count == cached_asks.size());
+            assert(depth.bid_count == 0 || depth.bids[0].price == book->get_best_bid());
+            assert(book->get_depth(depth, depth.version) == false);
+        }
+        std::cout << "✓ Test 13: Incremental Depth Cache - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 14: Market-By-Price Delta Feed
+    {
+        OrderBook book;
+        book.enable_level_deltas(8);
+        book.add_order(Order{1, true, 100.0, 10, 1});
+        book.add_order(Order{2, true, 100.0, 5, 2});
+        book.add_order(Order{3, false, 100.0, 12, 3});   // Fills order 1, partially fills 2
+        assert(book.cancel_order(2));
+        
+        LevelDelta deltas[16];
+        uint64_t cursor = 1;
+        bool gap = false;
+        size_t count = book.level_deltas().read(cursor, deltas, gap);
+        
+        // The aggressive sell trades before it could rest, so no ask level ever
+        // appears; fully filled orders leave no redundant Change behind
+        assert(!gap && count == 5 && cursor == 6);
+        assert(deltas[0].action == LevelAction::New && deltas[0].is_buy && deltas[0].quantity == 10);
+        assert(deltas[1].action == LevelAction::Change && deltas[1].quantity == 15);
+        assert(deltas[2].action == LevelAction::Change && deltas[2].is_buy && deltas[2].quantity == 5);
+        assert(deltas[3].action == LevelAction::Change && deltas[3].is_buy && deltas[3].quantity == 3);
+        assert(deltas[4].action == LevelAction::Delete && deltas[4].is_buy && deltas[4].quantity == 0);
+        for (size_t i = 0; i < count; ++i) assert(deltas[i].sequence == i + 1);
+        
+        // A reader lapped by the writer is resynchronised and told about the gap
+        for (uint64_t id = 10; id < 20; ++id) {
+            book.add_order(Order{id, true, 90.0 + static_cast<double>(id), 1, id});
+        }
+        count = book.level_deltas().read(cursor, deltas, gap);
+        assert(gap && count == 8 && cursor == book.level_deltas().next_sequence());
+        std::cout << "✓ Test 14: Market-By-Price Delta Feed - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 15: Sharded Book Manager
+    {
+        const uint32_t NUM_INSTRUMENTS = 8;
+        std::vector<InstrumentConfig> instruments(NUM_INSTRUMENTS, InstrumentConfig{false, {}, 64});
+        instruments[3] = InstrumentConfig{true, TickLadderConfig{0.01, 50.0, 150.0}, 64};
+        
+        BookManager<> manager(instruments, 2, 2, 256);
+        manager.start();
+        
+        // Each producer thread owns half the order ids of every instrument
+        auto produce = [&manager](size_t producer) {
+            for (uint64_t i = 0; i < 200; ++i) {
+                uint32_t instrument = static_cast<uint32_t>(i % NUM_INSTRUMENTS);
+                uint64_t id = producer * 1000 + i + 1;
+                BookCommand message{instrument, OrderCommand::add(Order{id, producer == 0, producer == 0 ? 99.0 : 101.0, 10, id})};
+                while (!manager.submit(producer, message)) {
+                    std::this_thread::yield();
+                }
+            }
+        };
+        std::thread producer0(produce, 0), producer1(produce, 1);
+        producer0.join();
+        producer1.join();
+        
+        // Producer 0 then cancels its orders on instrument 0
+        for (uint64_t i = 0; i < 200; i += NUM_INSTRUMENTS) {
+            while (!manager.submit(0, BookCommand{0, OrderCommand::cancel(i + 1)})) {
+                std::this_thread::yield();
+            }
+        }
+        assert(manager.submit(0, BookCommand{NUM_INSTRUMENTS, OrderCommand::cancel(1)}) == false);
+        manager.stop();
+        
+        assert(manager.processed(0) + manager.processed(1) == 400 + 25);
+        assert(manager.book(0).get_total_orders() == 25 && manager.book(0).get_bid_levels() == 0);
+        for (uint32_t instrument = 1; instrument < NUM_INSTRUMENTS; ++instrument) {
+            assert(manager.book(instrument).get_total_orders() == 50);
+            assert(manager.book(instrument).get_best_bid() == 99.0);
+        }
+        assert(manager.book(3).is_ladder_mode());
+        
+        // A parked shard is woken by the producer and by stop()
+        BookManager<NullTradeSink, ParkingWait> parked({InstrumentConfig{false, {}, 16}}, 1, 1, 16);
+        parked.start();
+        for (uint64_t id = 1; id <= 20; ++id) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            while (!parked.submit(0, BookCommand{0, OrderCommand::add(Order{id, true, 99.0, 10, id})})) {
+                std::this_thread::yield();
+            }
+        }
+        parked.stop();
+        assert(parked.processed(0) == 20 && parked.book(0).get_total_orders() == 20);
+        std::cout << "✓ Test 15: Sharded Book Manager - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 16: Seqlock-Published Snapshots
+    {
+        // Readers must never observe a half-written snapshot
+        SeqLock<DepthSnapshot> lock;
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> torn{0}, reads{0};
+        std::thread reader([&]() {
+            DepthSnapshot seen;
+            while (!done.load(std::memory_order_acquire)) {
+                lock.load(seen);
+                for (size_t i = 0; i < DepthSnapshot::max_depth; ++i) {
+                    if (seen.bids[i].total_quantity != seen.version || seen.asks[i].total_quantity != seen.version) {
+                        torn++;
+                    }
+                }
+                reads++;
+            }
+        });
+        while (reads.load() == 0) {
+            std::this_thread::yield();  // Make sure the reader overlaps the writes even on one core
+        }
+        for (uint64_t v = 1; v <= 20000; ++v) {
+            DepthSnapshot next;
+            for (size_t i = 0; i < DepthSnapshot::max_depth; ++i) {
+                next.bids[i] = PriceLevel(100.0 - static_cast<double>(i), v);
+                next.asks[i] = PriceLevel(101.0 + static_cast<double>(i), v);
+            }
+            next.bid_count = next.ask_count = DepthSnapshot::max_depth;
+            next.version = v;
+            lock.store(next);
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        assert(torn == 0 && reads > 0 && lock.generation() == 20000);
+        
+        // The book republishes only after matching passes that changed it
+        OrderBook book;
+        SeqLock<DepthSnapshot> published;
+        book.set_snapshot_publisher(&published);
+        uint64_t generation = published.generation();
+        book.add_order(Order{1, true, 100.0, 100, 1});
+        book.add_order(Order{2, false, 100.0, 40, 2});
+        book.match_orders();
+        assert(published.generation() == generation + 2);
+        
+        DepthSnapshot top;
+        published.load(top);
+        assert(top.version == book.get_version());
+        assert(top.bid_count == 1 && top.bids[0].price == 100.0 && top.bids[0].total_quantity == 60);
+        assert(top.ask_count == 0);
+        std::cout << "✓ Test 16: Seqlock-Published Snapshots - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 17: Parallel Book Maintenance
+    {
+        const uint32_t NUM_INSTRUMENTS = 64;
+        std::vector<InstrumentConfig> instruments(NUM_INSTRUMENTS, InstrumentConfig{false, {}, 0});
+        BookManager<> manager(instruments, 2, 1, 16);
+        WorkStealingPool pool(3);
+        
+        // Rebuild every book in parallel: instrument i gets i + 1 resting bids
+        manager.for_each_book(pool, [](uint32_t instrument, OrderBook& book) {
+            book.reserve_orders(instrument + 1);
+            for (uint64_t id = 1; id <= instrument + 1; ++id) {
+                book.add_order(Order{id, true, 100.0 - static_cast<double>(id % 5), 10, id});
+            }
+        });
+        
+        // End-of-day pass over the same books
+        std::vector<size_t> orders(NUM_INSTRUMENTS);
+        manager.for_each_book(pool, [&orders](uint32_t instrument, OrderBook& book) {
+            orders[instrument] = book.get_total_orders();
+        });
+        for (uint32_t instrument = 0; instrument < NUM_INSTRUMENTS; ++instrument) {
+            assert(orders[instrument] == instrument + 1);
+            assert(manager.book(instrument).get_best_bid() == (instrument + 1 >= 5 ? 100.0 : 99.0));
+        }
+        
+        // Nested jobs complete, and the first exception reaches the caller
+        std::atomic<uint64_t> sum{0};
+        pool.parallel_for(0, 16, 1, [&](size_t i) {
+            pool.parallel_for(0, 100, 8, [&](size_t j) { sum += i * 100 + j; });
+        });
+        assert(sum == 1600 * 1599 / 2);
+        bool thrown = false;
+        try {
+            pool.parallel_for(0, 1000, 10, [](size_t i) { if (i == 731) throw std::runtime_error("job failed"); });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        std::cout << "✓ Test 17: Parallel Book Maintenance - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 18: Journal Replay
+    {
+        const std::string path = "/tmp/order_book_test_journal.bin";
+        OrderBook original;
+        {
+            JournalWriter journal(path, 1, 16);  // Tiny queue: the writer falls behind and append() must wait
+            JournaledOrderBook<> book(original, journal);
+            for (uint64_t id = 1; id <= 200; ++id) {
+                book.add_order(Order{id, id % 2 == 0, id % 2 == 0 ? 99.0 - (id % 7) : 101.0 + (id % 7), 10 * id, 0});
+            }
+            for (uint64_t id = 1; id <= 200; id += 5) {
+                book.cancel_order(id);
+            }
+            assert(!book.cancel_order(1));  // Rejected calls are not journaled
+            book.amend_order(4, 98.5, 500);
+            book.amend_order(8, 99.0, 7);
+            book.add_order(Order{1000, true, 104.0, 900, 0});   // Sweeps asks through 104
+            book.submit_order(Order{1001, false, 0.0, 150, 0}, OrderType::Market);  // Replays as a market order
+            bool thrown = false;
+            try {
+                book.add_order(Order{4, true, 99.0, 10, 0});
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+            assert(journal.next_sequence() == 1 + 200 + 40 + 2 + 2);
+        }
+        
+        MappedJournal journal(path);
+        assert(journal.records().size() == 244);
+        OrderBook replayed;
+        ReplayResult result = replay_journal(journal.records(), replayed);
+        assert(result.applied == 244 && result.rejected == 0 && result.last_sequence == 244);
+        
+        std::vector<PriceLevel> bids, asks, replayed_bids, replayed_asks;
+        original.get_snapshot(100, bids, asks);
+        replayed.get_snapshot(100, replayed_bids, replayed_asks);
+        assert(bids.size() == replayed_bids.size() && asks.size() == replayed_asks.size());
+        for (size_t i = 0; i < bids.size(); ++i) {
+            assert(bids[i].price == replayed_bids[i].price && bids[i].total_quantity == replayed_bids[i].total_quantity);
+        }
+        for (size_t i = 0; i < asks.size(); ++i) {
+            assert(asks[i].price == replayed_asks[i].price && asks[i].total_quantity == replayed_asks[i].total_quantity);
+        }
+        uint64_t trades, volume, replayed_trades, replayed_volume;
+        size_t active, replayed_active;
+        original.get_statistics(trades, volume, active);
+        replayed.get_statistics(replayed_trades, replayed_volume, replayed_active);
+        assert(trades > 0 && trades == replayed_trades && volume == replayed_volume && active == replayed_active);
+        Order a, b;
+        assert(original.get_order(8, a) && replayed.get_order(8, b));
+        assert(a.quantity == 7 && b.quantity == 7 && a.timestamp_ns == b.timestamp_ns);
+        
+        // Replay from a later sequence skips what came before
+        OrderBook tail;
+        result = replay_journal(journal.records(), tail, 240);
+        assert(result.skipped == 240 && result.applied + result.rejected == 4);
+        
+        // A record torn by a crash is ignored
+        {
+            std::FILE* file = std::fopen(path.c_str(), "ab");
+            std::fwrite("torn", 1, 4, file);
+            std::fclose(file);
+        }
+        MappedJournal torn(path);
+        assert(torn.records().size() == 244);
+        std::remove(path.c_str());
+        std::cout << "✓ Test 18: Journal Replay - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 19: Book Image Warm Restart
+    {
+        auto same_book = [](const OrderBook& a, const OrderBook& b) {
+            std::vector<PriceLevel> a_bids, a_asks, b_bids, b_asks;
+            a.get_snapshot(1000, a_bids, a_asks);
+            b.get_snapshot(1000, b_bids, b_asks);
+            uint64_t a_trades, a_volume, b_trades, b_volume;
+            size_t a_orders, b_orders;
+            a.get_statistics(a_trades, a_volume, a_orders);
+            b.get_statistics(b_trades, b_volume, b_orders);
+            return a_bids == b_bids && a_asks == b_asks && a_trades == b_trades && a_volume == b_volume &&
+                   a_orders == b_orders;
+        };
+        
+        const std::string image_path = "/tmp/order_book_test.image";
+        const std::string journal_path = "/tmp/order_book_test_restart.bin";
+        OrderBook live;
+        {
+            JournalWriter journal(journal_path);
+            JournaledOrderBook<> book(live, journal);
+            for (uint64_t id = 1; id <= 300; ++id) {
+                book.add_order(Order{id, id % 2 == 1, id % 2 == 1 ? 100.0 - (id % 11) : 101.0 + (id % 11), id, id});
+            }
+            save_book_image(live, image_path, journal.next_sequence() - 1);
+            for (uint64_t id = 1; id <= 300; id += 3) {
+                book.cancel_order(id);
+            }
+            book.add_order(Order{1000, false, 95.0, 400, 1000});  // Trades through several bid levels
+            book.amend_order(2, 101.0, 1);
+        }
+        
+        // Image alone restores the state at the snapshot point, queues in time priority
+        OrderBook at_image;
+        assert(load_book_image(at_image, image_path) == 300);
+        assert(at_image.get_total_orders() == 300);
+        
+        // Image plus the journal tail matches the live book
+        OrderBook restored;
+        ReplayResult result = restore_book(restored, image_path, journal_path);
+        assert(result.skipped == 300 && result.rejected == 0 && result.applied > 100);
+        assert(same_book(live, restored));
+        
+        // A fill at the front of the queue proves FIFO order survived the round trip
+        live.add_order(Order{2000, false, 100.0, 1, 2000});
+        restored.add_order(Order{2000, false, 100.0, 1, 2000});
+        assert(same_book(live, restored));
+        for (uint64_t id = 1; id <= 300; ++id) {
+            Order a, b;
+            bool found = live.get_order(id, a);
+            assert(found == restored.get_order(id, b));
+            assert(!found || (a.quantity == b.quantity && a.price == b.price && a.timestamp_ns == b.timestamp_ns));
+        }
+        
+        // Ladder books round-trip too, and refuse images with another band
+        TickLadderConfig band{0.5, 50.0, 150.0};
+        OrderBook ladder(band);
+        for (uint64_t id = 1; id <= 50; ++id) {
+            ladder.add_order(Order{id, id % 3 != 0, id % 3 != 0 ? 99.5 - 0.5 * (id % 4) : 100.5 + 0.5 * (id % 4), 10, id});
+        }
+        std::vector<std::byte> image = ladder.save_image(7);
+        assert(image.size() == ladder.image_size());
+        OrderBook ladder_copy(band);
+        assert(ladder_copy.load_image(image) == 7 && same_book(ladder, ladder_copy));
+        
+        bool thrown = false;
+        try {
+            OrderBook other_band(TickLadderConfig{0.25, 50.0, 150.0});
+            other_band.load_image(image);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        
+        // A corrupt image is rejected and leaves the book empty
+        std::vector<std::byte> corrupt = image;
+        auto* first_order = reinterpret_cast<BookImageOrder*>(corrupt.data() + corrupt.size()) - 1;
+        first_order->order_id = 1;  // Repeats an id already loaded
+        OrderBook rejected(band);
+        thrown = false;
+        try {
+            rejected.load_image(corrupt);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown && rejected.get_total_orders() == 0 && rejected.get_bid_levels() == 0);
+        std::remove(image_path.c_str());
+        std::remove(journal_path.c_str());
+        std::cout << "✓ Test 19: Book Image Warm Restart - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 20: Arena-Backed Containers
+    {
+        Arena arena(16 << 20);
+        ArenaResource upstream(arena);
+        std::pmr::unsynchronized_pool_resource pool(&upstream);
+        
+        // Any pmr allocation that missed the explicit resource would throw
+        std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        size_t used_before = arena.used();
+        {
+            OrderBook book(NullTradeSink{}, &pool);
+            book.reserve_orders(1000);
+            book.enable_level_deltas(256);
+            for (uint64_t round = 0; round < 5; ++round) {
+                for (uint64_t id = 1; id <= 2000; ++id) {
+                    book.add_order(Order{round * 10000 + id, id % 2 == 0, id % 2 == 0 ? 90.0 - (id % 50) : 110.0 + (id % 50),
+                                         10, id});
+                }
+                for (uint64_t id = 1; id <= 2000; ++id) {
+                    book.cancel_order(round * 10000 + id);
+                }
+            }
+            book.add_order(Order{1, true, 100.0, 10, 1});
+            book.add_order(Order{2, false, 100.0, 4, 2});
+            assert(book.get_total_orders() == 1 && book.get_best_bid() == 100.0);
+            assert(book.memory_resource() == &pool);
+            
+            TickLadderConfig band{0.01, 50.0, 150.0};
+            OrderBook ladder(band, NullTradeSink{}, &pool);
+            ladder.add_order(Order{1, true, 99.99, 10, 1});
+            assert(std::abs(ladder.get_best_bid() - 99.99) < 1e-9);
+        }
+        std::pmr::set_default_resource(previous);
+        size_t used_by_books = arena.used() - used_before;
+        assert(used_by_books > 0);
+        
+        // Churn recycles through the pool: five rounds cost about one round of arena
+        {
+            OrderBook book(NullTradeSink{}, &pool);
+            size_t before = arena.used();
+            for (uint64_t round = 0; round < 5; ++round) {
+                for (uint64_t id = 1; id <= 2000; ++id) {
+                    book.add_order(Order{id, true, 50.0 + static_cast<double>(id % 100), 10, id});
+                }
+                for (uint64_t id = 1; id <= 2000; ++id) {
+                    book.cancel_order(id);
+                }
+            }
+            assert(arena.used() - before < used_by_books);
+        }
+        
+        // Queues take the STL allocator: the ring lives in the arena
+        {
+            size_t before = arena.used();
+            Fifo4<uint64_t, ArenaAllocator<uint64_t>> queue(1024, ArenaAllocator<uint64_t>(arena));
+            assert(arena.used() - before >= 1024 * sizeof(uint64_t));
+            for (uint64_t i = 0; i < 5000; ++i) {
+                uint64_t value = 0;
+                assert(queue.push(i) && queue.pop(value) && value == i);
+            }
+        }
+        std::cout << "✓ Test 20: Arena-Backed Containers - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 21: Compact Resting Orders
+    {
+        static_assert(sizeof(OrderNode) * 2 <= 64);
+
+        // One level queue spanning several store chunks keeps time priority
+        OrderBook book;
+        const uint64_t count = 10000;
+        for (uint64_t i = 1; i <= count; ++i) {
+            book.add_order(Order{i, false, 101.0, 10, 1000 + i}, false);
+        }
+        Order resting;
+        assert(book.get_order(count, resting));
+        assert(!resting.is_buy && resting.price == 101.0 && resting.quantity == 10 && resting.timestamp_ns == 1000 + count);
+
+        book.add_order(Order{count + 1, true, 101.0, 10 * (count - 2) + 5, 1}, true);
+        assert(book.get_total_orders() == 2);
+        assert(!book.order_exists(count - 2) && book.get_order(count - 1, resting));
+        assert(resting.quantity == 5 && resting.timestamp_ns == 1000 + count - 1);
+        assert(book.get_order(count, resting) && resting.quantity == 10);
+
+        // Freed slots are reused before the store grows
+        size_t capacity = book.get_order_capacity();
+        for (uint64_t i = 1; i <= count; ++i) {
+            book.add_order(Order{count + 1 + i, true, 99.0, 1, 0}, false);
+        }
+        assert(book.get_order_capacity() == capacity);
+        assert(book.get_best_bid() == 99.0 && book.get_best_ask() == 101.0);
+        std::cout << "✓ Test 21: Compact Resting Orders - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 22: Map and Ladder Sides Agree
+    {
+        OrderBook map_book;
+        OrderBook ladder_book(TickLadderConfig{0.5, 50.0, 150.0});
+        uint64_t state = 12345;
+        auto next = [&state](uint64_t bound) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return (state >> 33) % bound;
+        };
+
+        // Crossing adds, cancels and amends on both sides, matched as they arrive
+        for (uint64_t id = 1; id <= 20000; ++id) {
+            uint64_t action = next(10);
+            uint64_t target = 1 + next(id);
+            double price = 95.0 + 0.5 * static_cast<double>(next(21));
+            uint64_t quantity = 1 + next(100);
+            bool is_buy = next(2) == 0;
+            for (OrderBook* book : {&map_book, &ladder_book}) {
+                if (action < 6) {
+                    book->add_order(Order{id, is_buy, price, quantity, id});
+                } else if (action < 8) {
+                    book->cancel_order(target);
+                } else {
+                    book->amend_order(target, price, quantity);
+                }
+            }
+        }
+
+        uint64_t map_trades, map_volume, ladder_trades, ladder_volume;
+        size_t map_orders, ladder_orders;
+        map_book.get_statistics(map_trades, map_volume, map_orders);
+        ladder_book.get_statistics(ladder_trades, ladder_volume, ladder_orders);
+        assert(map_trades > 0 && map_trades == ladder_trades);
+        assert(map_volume == ladder_volume && map_orders == ladder_orders);
+
+        std::vector<PriceLevel> map_bids, map_asks, ladder_bids, ladder_asks;
+        map_book.get_snapshot(100, map_bids, map_asks);
+        ladder_book.get_snapshot(100, ladder_bids, ladder_asks);
+        assert(map_bids == ladder_bids && map_asks == ladder_asks);
+        std::cout << "✓ Test 22: Map and Ladder Sides Agree - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 23: Match Before Insert and Order Types
+    {
+        for (bool ladder : {false, true}) {
+            BasicOrderBook<TradeRecorder> book = ladder
+                ? BasicOrderBook<TradeRecorder>(TickLadderConfig{0.5, 50.0, 150.0}, TradeRecorder(16))
+                : BasicOrderBook<TradeRecorder>(TradeRecorder(16));
+            book.add_order(Order{1, false, 101.0, 50, 1});
+            book.add_order(Order{2, false, 102.0, 50, 2});
+            book.add_order(Order{3, true, 99.0, 40, 3});
+            book.enable_level_deltas(16);
+
+            // IOC trades what it can at the resting price and drops the rest
+            ExecutionReport ioc = book.submit_order(Order{10, true, 101.5, 60, 10}, OrderType::IOC);
+            assert(ioc.filled_quantity == 50 && ioc.cancelled_quantity == 10 && ioc.rested_quantity == 0);
+            assert(ioc.trades == 1 && book.trade_sink()[0].price == 101.0 && book.trade_sink()[0].buy_order_id == 10);
+            assert(!book.order_exists(10) && book.get_best_ask() == 102.0);
+
+            // FOK that cannot fill in full leaves the book untouched
+            uint64_t version = book.get_version();
+            ExecutionReport killed = book.submit_order(Order{11, true, 102.0, 100, 11}, OrderType::FOK);
+            assert(killed.filled_quantity == 0 && killed.cancelled_quantity == 100 && killed.trades == 0);
+            assert(book.get_version() == version && book.order_exists(2));
+            ExecutionReport filled = book.submit_order(Order{12, true, 102.0, 50, 12}, OrderType::FOK);
+            assert(filled.filled_quantity == 50 && filled.trades == 1 && book.get_ask_levels() == 0);
+
+            // Market orders ignore their price and never rest
+            ExecutionReport market = book.submit_order(Order{13, false, 0.0, 100, 13}, OrderType::Market);
+            assert(market.filled_quantity == 40 && market.cancelled_quantity == 60);
+            assert(book.trade_sink()[2].price == 99.0 && book.trade_sink()[2].sell_order_id == 13);
+            assert(book.get_total_orders() == 0);
+
+            // A limit order's rest goes on the book; the aggressor's side saw no level until then
+            ExecutionReport rested = book.submit_order(Order{14, true, 100.0, 30, 14});
+            assert(rested.rested_quantity == 30 && rested.filled_quantity == 0 && book.get_best_bid() == 100.0);
+            LevelDelta deltas[16];
+            uint64_t cursor = 1;
+            bool gap = false;
+            size_t count = book.level_deltas().read(cursor, deltas, gap);
+            for (size_t i = 0; i + 1 < count; ++i) assert(deltas[i].action == LevelAction::Delete);
+            assert(count == 4 && deltas[3].action == LevelAction::New && deltas[3].is_buy);
+
+            try {
+                book.submit_order(Order{14, false, 100.0, 10, 15}, OrderType::IOC);
+                assert(false);
+            } catch (const std::runtime_error&) {
+                // Expected: the id is resting
+            }
+        }
+        std::cout << "✓ Test 23: Match Before Insert and Order Types - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 24: Amend In Place
+    {
+        for (bool ladder : {false, true}) {
+            BasicOrderBook<TradeRecorder> book = ladder
+                ? BasicOrderBook<TradeRecorder>(TickLadderConfig{0.5, 50.0, 150.0}, TradeRecorder(16))
+                : BasicOrderBook<TradeRecorder>(TradeRecorder(16));
+            book.add_order(Order{1, true, 100.0, 50, 1});
+            book.add_order(Order{2, true, 100.0, 50, 2});
+            book.add_order(Order{3, true, 100.0, 50, 3});
+            size_t capacity = book.get_order_capacity();
+            auto bid_volume = [&book](double price) {
+                std::vector<PriceLevel> bids, asks;
+                book.get_snapshot(10, bids, asks);
+                for (const auto& level : bids) {
+                    if (level.price == price) return level.total_quantity;
+                }
+                return uint64_t{0};
+            };
+
+            // A smaller quantity keeps the order first in its queue
+            assert(book.amend_order(1, 100.0, 20));
+            assert(bid_volume(100.0) == 120);
+            book.submit_order(Order{10, false, 100.0, 10, 10}, OrderType::IOC);
+            assert(book.trade_sink()[0].buy_order_id == 1);
+
+            // A larger quantity goes to the back
+            assert(book.amend_order(1, 100.0, 40));
+            book.submit_order(Order{11, false, 100.0, 60, 11}, OrderType::IOC);
+            assert(book.trade_sink()[1].buy_order_id == 2 && book.trade_sink()[2].buy_order_id == 3);
+
+            // A new price moves the same node to another level
+            assert(book.amend_order(3, 99.0, 50));
+            Order moved;
+            assert(book.get_order(3, moved) && moved.price == 99.0 && moved.quantity == 50 && moved.timestamp_ns == 3);
+            assert(book.get_bid_levels() == 2 && bid_volume(100.0) == 40);
+            assert(book.get_order_capacity() == capacity);
+
+            // An amend that crosses trades at the resting price before it rests
+            book.add_order(Order{4, false, 101.0, 30, 4});
+            assert(book.amend_order(3, 101.5, 50));
+            assert(book.trade_sink()[3].price == 101.0 && book.trade_sink()[3].buy_order_id == 3);
+            assert(book.get_best_bid() == 101.5 && bid_volume(101.5) == 20);
+            assert(!book.order_exists(4) && book.get_ask_levels() == 0);
+            assert(book.amend_order(3, 100.0, 20) && book.get_bid_levels() == 1);
+            assert(bid_volume(100.0) == 60 && book.get_total_orders() == 2);
+        }
+        std::cout << "✓ Test 24: Amend In Place - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 25: Ring Level Queues
+    {
+        for (bool ladder : {false, true}) {
+            OrderBook linked = ladder ? OrderBook(TickLadderConfig{0.5, 50.0, 150.0}) : OrderBook();
+            OrderBook ring = ladder ? OrderBook(TickLadderConfig{0.5, 50.0, 150.0}) : OrderBook();
+            ring.set_queue_layout(QueueLayout::Ring);
+            uint64_t state = 777;
+            auto next = [&state](uint64_t bound) {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                return (state >> 33) % bound;
+            };
+
+            // Few prices and many cancels, so queues get deep and compact repeatedly
+            for (uint64_t id = 1; id <= 30000; ++id) {
+                uint64_t action = next(20);
+                uint64_t target = 1 + next(id);
+                bool is_buy = next(2) == 0;
+                double price = is_buy ? 99.0 + 0.5 * static_cast<double>(next(3))
+                                      : 100.0 + 0.5 * static_cast<double>(next(3));
+                uint64_t quantity = 1 + next(50);
+                for (OrderBook* book : {&linked, &ring}) {
+                    if (action < 10) {
+                        book->add_order(Order{id, is_buy, price, quantity, id}, false);
+                    } else if (action < 18) {
+                        book->cancel_order(target);
+                    } else if (action < 19) {
+                        book->amend_order(target, price, quantity);
+                    } else {
+                        book->submit_order(Order{id, is_buy, is_buy ? 101.0 : 99.0, 4 * quantity, id}, OrderType::IOC);
+                    }
+                }
+            }
+
+            uint64_t linked_trades, linked_volume, ring_trades, ring_volume;
+            size_t linked_orders, ring_orders;
+            linked.get_statistics(linked_trades, linked_volume, linked_orders);
+            ring.get_statistics(ring_trades, ring_volume, ring_orders);
+            assert(linked_trades > 0 && linked_trades == ring_trades && linked_volume == ring_volume);
+            assert(linked_orders > 1000 && linked_orders == ring_orders);
+            // Same queues in the same order, level by level
+            assert(linked.save_image() == ring.save_image());
+
+            try {
+                ring.set_queue_layout(QueueLayout::Linked);
+                assert(false);
+            } catch (const std::runtime_error&) {
+                // Expected: orders are resting
+            }
+        }
+        // Cancelling most of a deep queue compacts it; fills still go oldest first
+        BasicOrderBook<TradeRecorder> deep{TradeRecorder(64)};
+        deep.set_queue_layout(QueueLayout::Ring);
+        for (uint64_t id = 1; id <= 300; ++id) {
+            deep.add_order(Order{id, true, 100.0, 10, id});
+        }
+        for (uint64_t id = 1; id <= 300; ++id) {
+            if (id % 5 != 0) deep.cancel_order(id);
+        }
+        deep.add_order(Order{301, true, 100.0, 10, 301});
+        deep.submit_order(Order{302, false, 100.0, 610, 302}, OrderType::IOC);
+        assert(deep.trade_sink().size() == 61 && deep.get_total_orders() == 0);
+        for (uint64_t i = 0; i < 60; ++i) {
+            assert(deep.trade_sink()[i].buy_order_id == 5 * (i + 1));
+        }
+        assert(deep.trade_sink()[60].buy_order_id == 301);
+        std::cout << "✓ Test 25: Ring Level Queues - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 26: TSC Clock
+    {
+        const TscClock& clock = tsc_clock();
+        assert(clock.cycles_per_ns() > 0.0);
+        uint64_t million_cycles_ns = clock.to_ns(static_cast<uint64_t>(clock.cycles_per_ns() * 1e6));
+        assert(million_cycles_ns > 999000 && million_cycles_ns < 1001000);
+
+        // Stamps track the system clock and never run backwards on one thread
+        uint64_t before = realtime_ns();
+        uint64_t previous = clock.now_ns();
+        for (int i = 0; i < 1000; ++i) {
+            uint64_t now = clock.now_ns();
+            assert(now >= previous);
+            previous = now;
+        }
+        uint64_t after = realtime_ns();
+        assert(previous + 1000000 > before && previous < after + 1000000);
+
+        // The book stamps unstamped orders from the same clock
+        OrderBook book;
+        book.add_order(Order{1, true, 100.0, 10, 0});
+        Order stamped;
+        assert(book.get_order(1, stamped));
+        assert(stamped.timestamp_ns + 1000000 > after && stamped.timestamp_ns < realtime_ns() + 1000000);
+        assert(clock.check_cores().cpus >= 1);
+        std::cout << "✓ Test 26: TSC Clock - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
+    // Test 27: Latency Histograms and Probes
+    {
+        // Every value is reported to bucket precision, never below itself
+        LatencyHistogram histogram;
+        for (uint64_t value = 1; value <= 100000; ++value) histogram.record(value);
+        assert(histogram.count() == 100000 && histogram.max() == 100000);
+        for (double quantile : {0.5, 0.99, 0.999}) {
+            double exact = quantile * 100000;
+            double reported = static_cast<double>(histogram.percentile(quantile));
+            assert(reported >= exact && reported <= exact * (1.0 + 1.0 / 32));
+        }
+        assert(histogram.percentile(1.0) == 100000);
+        for (uint64_t value : {uint64_t{0}, uint64_t{63}, uint64_t{64}, uint64_t{1} << 40, UINT64_MAX}) {
+            size_t bucket = LatencyHistogram::bucket_of(value);
+            assert(bucket < LatencyHistogram::bucket_count && LatencyHistogram::bucket_high(bucket) >= value);
+            assert(bucket == 0 || LatencyHistogram::bucket_high(bucket - 1) < value);
+        }
+
+        // Probes from two threads merge under one name; intervals subtract
+        uint32_t id = probe_register("test::section");
+        assert(probe_register("test::section") == id);
+        auto work = [id] {
+            for (int i = 0; i < 1000; ++i) {
+                ScopedProbe probe(id);
+            }
+        };
+        std::vector<std::string> names;
+        std::vector<LatencyHistogram> before, after;
+        probe_registry().collect(names, before);
+        std::thread other(work);
+        work();
+        other.join();
+        probe_registry().collect(names, after);
+        assert(names[id] == "test::section" && after[id].count() == 2000);
+        LatencyHistogram interval = after[id].since(before[id]);
+        assert(interval.count() == 2000 && interval.percentile(0.5) <= interval.max());
+#ifdef ENABLE_PROBES
+        OrderBook probed;
+        probed.add_order(Order{1, true, 100.0, 10, 1});
+        probed.add_order(Order{2, false, 100.0, 10, 2});
+        probe_registry().collect(names, after);
+        uint32_t submit = probe_register("submit_order");
+        assert(after.size() > submit && after[submit].count() >= 2);
+#endif
+        std::cout << "✓ Test 27: Latency Histograms and Probes - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 28: Strategy Hosts
+    {
+        // Fills reach the strategies from the matching path, deltas via poll()
+        using Host = StrategyHost<DeltaCounter, FillCounter>;
+        BasicOrderBook<Host> book;
+        book.enable_level_deltas(64);
+        book.add_order(Order{1, false, 101.0, 50, 1});
+        book.add_order(Order{2, false, 102.0, 50, 2});
+        book.add_order(Order{3, true, 102.0, 80, 3});
+        assert(book.trade_sink().get<FillCounter>().volume == 80);
+        assert(book.trade_sink().get<DeltaCounter>().deltas == 0);
+        size_t delivered = book.trade_sink().poll(book);
+        const DeltaCounter& deltas = book.trade_sink().get<DeltaCounter>();
+        assert(delivered == book.level_deltas().next_sequence() - 1);
+        assert(deltas.deltas == delivered && deltas.deletes == 1 && deltas.gaps == 0);
+        assert(book.trade_sink().poll(book) == 0);
+        
+        // More deltas than the ring holds: one gap, then what is left
+        for (uint64_t id = 10; id < 200; ++id) book.add_order(Order{id, true, 90.0 + static_cast<double>(id % 5), 1, id});
+        delivered = book.trade_sink().poll(book);
+        assert(delivered == 64 && deltas.gaps == 1);
+        
+        // Configured by name at runtime, dispatched through std::visit
+        RuntimeStrategyHost<DeltaCounter, FillCounter> runtime;
+        runtime.add("fills");
+        runtime.add("deltas");
+        bool threw = false;
+        try {
+            runtime.add("momentum");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && runtime.size() == 2);
+        OrderBook plain;
+        plain.enable_level_deltas(64);
+        plain.add_order(Order{1, true, 100.0, 10, 1});
+        plain.add_order(Order{2, true, 99.0, 10, 2});
+        assert(runtime.poll(plain) == 2);
+        runtime.on_trade(TradeEvent{1, 1, 2, 100.0, 7});
+        assert(std::get<FillCounter>(runtime[0]).volume == 7);
+        assert(std::get<DeltaCounter>(runtime[1]).deltas == 2);
+        std::cout << "✓ Test 28: Strategy Hosts - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 29: Vector
+    {
+        // Trivially copyable: geometric growth, contents kept across relocations
+        Vector<TradeEvent> events;
+        assert(events.capacity() == 0 && events.data() == nullptr);
+        size_t reallocations = 0, capacity = 0;
+        for (uint64_t i = 0; i < 1000; ++i) {
+            events.push_back(TradeEvent{i, i, i + 1, 100.0, i});
+            if (events.capacity() != capacity) {
+                reallocations++;
+                capacity = events.capacity();
+            }
+        }
+        assert(events.size() == 1000 && reallocations <= 10);
+        for (uint64_t i = 0; i < 1000; ++i) assert(events[i].trade_id == i && events[i].quantity == i);
+        const TradeEvent* heap = events.data();
+        Vector<TradeEvent> stolen(std::move(events));
+        assert(stolen.data() == heap && events.empty() && events.capacity() == 0);
+        
+        // Inline buffer, then spill to the heap; growth copies an element of itself
+        Vector<std::string, 4> names;
+        for (int i = 0; i < 4; ++i) names.push_back("level-" + std::to_string(i));
+        assert(names.is_inline() && names.capacity() == 4);
+        names.push_back(names[0]);
+        assert(!names.is_inline() && names.size() == 5 && names[4] == "level-0" && names[3] == "level-3");
+        Vector<std::string, 4> small{"a", "b"};
+        Vector<std::string, 4> moved(std::move(small));
+        assert(moved.is_inline() && moved.size() == 2 && moved[1] == "b" && small.empty());
+        Vector<std::string, 4> copy = names;
+        copy = moved;
+        assert(copy.size() == 2 && copy.is_inline() && names.size() == 5);
+        moved = std::move(names);
+        assert(moved.size() == 5 && !moved.is_inline() && names.empty() && names.is_inline());
+        moved.resize(2);
+        moved.resize(4, "x");
+        assert(moved.size() == 4 && moved[1] == "level-1" && moved[3] == "x");
+        
+        // Constructions and destructions balance; a failed growth changes nothing
+        struct Tracked {
+            int* live;
+            int value;
+            bool* fail_copy;
+            Tracked(int* l, int v, bool* f) : live(l), value(v), fail_copy(f) { ++*live; }
+            Tracked(const Tracked& o) : live(o.live), value(o.value), fail_copy(o.fail_copy) {
+                if (*fail_copy) throw std::runtime_error("copy");
+                ++*live;
+            }
+            ~Tracked() { --*live; }
+        };
+        int live = 0;
+        bool fail_copy = false;
+        {
+            Vector<Tracked, 2> tracked;
+            for (int i = 0; i < 5; ++i) tracked.emplace_back(&live, i, &fail_copy);
+            assert(live == 5);
+            fail_copy = true;   // No move constructor, so growth copies
+            bool threw = false;
+            try {
+                for (int i = 0; i < 8; ++i) tracked.emplace_back(&live, 10 + i, &fail_copy);
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            assert(threw && live == static_cast<int>(tracked.size()));
+            for (int i = 0; i < 5; ++i) assert(tracked[i].value == i);
+            fail_copy = false;
+            tracked.pop_back();
+            assert(live == static_cast<int>(tracked.size()));
+        }
+        assert(live == 0);
+        std::cout << "✓ Test 29: Vector - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 30: Pool Deleters and Intrusive Handles
+    {
+        // A stateless deleter costs nothing and hands the block back to its pool
+        using PooledTrade = UniquePtr<TradeEvent, SmallDelete<TradeEvent>>;
+        static_assert(sizeof(PooledTrade) == sizeof(TradeEvent*));
+        TradeEvent* first;
+        {
+            PooledTrade trade(small_new<TradeEvent>(TradeEvent{1, 2, 3, 100.0, 5}));
+            first = trade.get();
+            PooledTrade moved = std::move(trade);
+            assert(!trade && moved->quantity == 5);
+        }
+        PooledTrade reused(small_new<TradeEvent>());
+        assert(reused.get() == first);   // The thread cache gives the freed block back first
+        UniquePtr<std::string> owned = make_unique_ptr<std::string>("book");
+        owned.reset(new std::string("depth"));
+        assert(*owned == "depth");
+        
+        // Local counts for single-thread sharing
+        struct Local : RefCounted<Local, LocalRefCount> {
+            int* destroyed;
+            explicit Local(int* d) : destroyed(d) {}
+            ~Local() { ++*destroyed; }
+        };
+        int destroyed = 0;
+        {
+            IntrusivePtr<Local> a = make_intrusive<Local>(&destroyed);
+            IntrusivePtr<Local> b = a;
+            IntrusivePtr<const Local> c = std::move(b);
+            assert(a->use_count() == 2 && !b && c.get() == a.get());
+            a.reset();
+            assert(destroyed == 0 && c->use_count() == 1);
+        }
+        assert(destroyed == 1);
+        
+        // The book hands every reader the same snapshot until it changes
+        OrderBook book;
+        book.add_order(Order{1, true, 100.0, 10, 1});
+        IntrusivePtr<const SharedDepth> seen = book.share_depth();
+        IntrusivePtr<const SharedDepth> again = book.share_depth();
+        assert(seen == again && seen->use_count() == 3 && seen->depth.bid_count == 1);
+        book.add_order(Order{2, false, 101.0, 10, 2});
+        IntrusivePtr<const SharedDepth> fresh = book.share_depth();
+        assert(fresh.get() != seen.get() && fresh->depth.ask_count == 1 && seen->depth.ask_count == 0);
+        assert(seen->use_count() == 2);
+        
+        // Readers on other threads drop their handles; the last one frees it
+        std::vector<std::thread> readers;
+        std::atomic<uint64_t> quantity{0};
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([copy = fresh, &quantity] { quantity += copy->depth.bids[0].total_quantity; });
+        }
+        for (auto& reader : readers) reader.join();
+        assert(quantity == 40 && fresh->use_count() == 2);
+        std::cout << "✓ Test 30: Pool Deleters and Intrusive Handles - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 31: Compile-Time Instruments
+    {
+        static constexpr InstrumentSpec spec{0.5, 50.0, 150.0, 64};
+        static constexpr InstrumentSpec same_grid{0.5, 50.0, 150.0, 64};
+        using Future = Instrument<spec>;
+        static_assert(std::is_same_v<Future::Book<TradeRecorder>, Instrument<same_grid>::Book<TradeRecorder>>);
+        static_assert(Future::Grid::num_ticks() == 201 && Future::Grid::min_tick() == 100);
+        static_assert(sizeof(Future::Book<>) < sizeof(OrderBook));   // The grid takes no space
+        
+        // Same results as the runtime-configured ladder for the same band
+        Future::Book<TradeRecorder> fixed{TradeRecorder(16)};
+        BasicOrderBook<TradeRecorder> runtime(TickLadderConfig{0.5, 50.0, 150.0}, TradeRecorder(16));
+        assert(fixed.is_ladder_mode());
+        for (double off_band : {150.5, 100.25}) {
+            bool rejected = false;
+            try {
+                fixed.add_order(Order{99, true, off_band, 1, 1});
+            } catch (const std::runtime_error&) {
+                rejected = true;
+            }
+            assert(rejected);
+        }
+        auto drive = [](auto& book) {
+            book.add_order(Order{1, true, 100.0, 10, 1});
+            book.add_order(Order{2, true, 99.5, 20, 2});
+            book.add_order(Order{3, false, 101.0, 15, 3});
+            book.add_order(Order{4, false, 99.5, 25, 4});   // Crosses both bids
+            book.cancel_order(3);
+        };
+        drive(fixed);
+        drive(runtime);
+        DepthSnapshot a, b;
+        fixed.get_depth(a);
+        runtime.get_depth(b);
+        assert(a.bid_count == b.bid_count && a.ask_count == b.ask_count && a.ask_count == 0);
+        for (size_t i = 0; i < a.bid_count; ++i) assert(a.bids[i] == b.bids[i]);
+        assert(a.bid_count == 1 && a.bids[0] == PriceLevel(99.5, 5));
+        assert(fixed.trade_sink().size() == 2 && runtime.trade_sink().size() == 2);
+        
+        // Listed grids dispatch to their specialization; any other band runs on the runtime grid
+        auto is_fixed = [](auto grid) { return decltype(grid)::fixed; };
+        assert((with_instrument_grid<spec>(TickLadderConfig{0.5, 50.0, 150.0}, is_fixed)));
+        assert(!(with_instrument_grid<spec>(TickLadderConfig{0.25, 50.0, 150.0}, is_fixed)));
+        size_t ticks = with_instrument_grid<spec>(TickLadderConfig{0.25, 50.0, 150.0}, [](auto grid) {
+            BasicOrderBook<NullTradeSink, decltype(grid)> book;
+            return grid.num_ticks();
+        });
+        assert(ticks == 401);
+        
+        // The queue's capacity is a constant; the ring wraps as before
+        Future::Queue<int> queue;
+        assert(queue.capacity() == 64);
+        int value = 0;
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 64; ++i) assert(queue.push(i));
+            assert(queue.full() && !queue.push(64));
+            for (int i = 0; i < 64; ++i) assert(queue.pop(value) && value == i);
+        }
+        assert(queue.empty());
+        std::cout << "✓ Test 31: Compile-Time Instruments - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 32: Multicast Book Feed
+    {
+        // Unicast loopback exercises the same path as a group without needing a multicast route
+        MulticastConfig config;
+        config.group = "127.0.0.1";
+        config.port = 47556;
+        config.recovery_port = 47557;
+        MulticastFeedReceiver<WireMessage> receiver(config);
+        MulticastPublisher publisher(config, 1, 8);
+        BasicOrderBook<BookFeedPublisher> book{BookFeedPublisher(&publisher, 0, 7)};
+        book.enable_level_deltas(64);
+        auto snapshot = [&](uint16_t, auto& emit) { book.trade_sink().snapshot(book, emit); };
+        auto collect = [&](size_t count) {
+            std::vector<WireMessage> messages;
+            for (int tries = 0; messages.size() < count && tries < 100; ++tries) {
+                auto records = receiver.receive();
+                messages.insert(messages.end(), records.begin(), records.end());
+                if (records.empty()) receiver.wait(10);
+            }
+            return messages;
+        };
+        
+        book.add_order(Order{1, true, 100.0, 10, 1});
+        book.add_order(Order{2, false, 101.0, 20, 2});
+        book.add_order(Order{3, false, 100.0, 4, 3});   // Takes 4 from the bid
+        book.trade_sink().poll(book);
+        publisher.flush();
+        // Trade first (queued from the matching path), then bid New, ask New, bid Change
+        std::vector<WireMessage> live = collect(4);
+        assert(live.size() == 4);
+        for (size_t i = 0; i < live.size(); ++i) {
+            assert(live[i].header.sequence == i + 1 && live[i].header.instrument == 7 && !is_snapshot_reply(live[i]));
+        }
+        assert(live[0].header.type == MessageType::Trade && live[0].order_id == 1 && live[0].side == WireSide::Sell);
+        assert(live[0].price == 100 * wire_price_scale && live[0].quantity == 4);
+        assert(live[3].header.type == MessageType::LevelUpdate && live[3].side == WireSide::Buy && live[3].quantity == 6);
+        
+        // Replay from history, byte for byte
+        receiver.request_replay(0, 2, 3);
+        for (int tries = 0; publisher.serve_recovery(snapshot) == 0 && tries < 100; ++tries) receiver.wait(10);
+        std::vector<WireMessage> replayed = collect(2);
+        assert(replayed.size() == 2 && std::memcmp(&replayed[0], &live[1], 2 * sizeof(WireMessage)) == 0);
+        
+        // Snapshot: the book's levels with sequence 0, then the last sequence they include
+        receiver.request_snapshot(0, 1);
+        for (int tries = 0; publisher.serve_recovery(snapshot) == 0 && tries < 100; ++tries) receiver.wait(10);
+        std::vector<WireMessage> state = collect(4);
+        assert(state.size() == 4 && state[0].header.type == MessageType::BookClear);
+        assert(state[1].side == WireSide::Buy && state[1].quantity == 6 && state[2].price == 101 * wire_price_scale);
+        assert(state[3].header.type == MessageType::SnapshotEnd && state[3].header.sequence == 4);
+        for (const WireMessage& message : state) assert(is_snapshot_reply(message));
+        
+        // A ring that laps the publisher is replaced by the whole book, sequenced
+        for (uint64_t i = 0; i < 100; ++i) book.amend_order(2, 101.0, 21 + i % 2, false);
+        book.trade_sink().poll(book);
+        publisher.heartbeat();
+        std::vector<WireMessage> rebuilt = collect(4);
+        assert(rebuilt.size() == 4 && rebuilt[0].header.type == MessageType::BookClear && rebuilt[0].header.sequence == 5);
+        assert(rebuilt[2].quantity == 21 + 99 % 2 && rebuilt[3].header.type == MessageType::Heartbeat);
+        assert(rebuilt[3].header.sequence == 7 && receiver.malformed() == 0);
+        std::cout << "✓ Test 32: Multicast Book Feed - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 33: Thread Roles and Placement
+    {
+        assert((parse_cpu_list("2-4,7\n") == std::vector<int>{2, 3, 4, 7}) && parse_cpu_list("").empty());
+        ThreadRuntime runtime(parse_thread_roles("feed=0:50,matcher=0,logger=0@0"));
+        assert(runtime.placement("feed").fifo_priority == 50 && runtime.placement("logger").numa_node == 0);
+        assert(runtime.placement("matcher.3").core == 0 && runtime.placement("publisher").core == -1);
+        for (const char* bad : {"feed", "feed=x", "feed=1:100"}) {
+            bool rejected = false;
+            try {
+                parse_thread_roles(bad);
+            } catch (const std::runtime_error&) {
+                rejected = true;
+            }
+            assert(rejected);
+        }
+        
+        // The body runs only after the placement, on the core it names
+        std::atomic<int> ran_on{-2};
+        char name[16] = {};
+        std::thread matcher = runtime.spawn("matcher.0", [&] {
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            ran_on = sched_getcpu();
+        });
+        matcher.join();
+        const PlacementResult& placed = runtime.results().back();
+        assert(placed.ok() && placed.pinned && placed.numa_node == 0 && ran_on == 0);
+        assert(std::string(name) == "matcher.0");
+        
+        // SCHED_FIFO may be refused without privileges; that is reported, not fatal
+        std::thread feed = runtime.spawn("feed", [] {});
+        feed.join();
+        assert(runtime.results().back().pinned && runtime.results().back().realtime == runtime.results().back().ok());
+        
+        // A strict runtime never runs a body whose placement failed
+        ThreadRuntime strict(parse_thread_roles("feed=" + std::to_string(CPU_SETSIZE - 1)), true);
+        bool ran = false, refused = false;
+        try {
+            strict.spawn("feed", [&] { ran = true; });
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        assert(refused && !ran && !strict.results().back().pinned);
+        
+        // Shards take their matcher.N placement
+        BookManager<> manager({InstrumentConfig{false, {}, 16}}, 1, 1, 64);
+        manager.place_shards(runtime);
+        manager.start();
+        manager.submit(0, BookCommand{0, OrderCommand::add(Order{1, true, 100.0, 5, 1})});
+        manager.stop();
+        assert(manager.book(0).get_total_orders() == 1);
+        std::cout << "✓ Test 33: Thread Roles and Placement - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 34: Pre-Trade Risk
+    {
+        RiskGate gate(2, 1000);
+        gate.set_limits(0, RiskLimits{100, 10000.0, 50, 100});
+        gate.set_limits(1, RiskLimits{1000, 1e9, 50, 3});
+        assert(gate.check_add(5, Order{1, true, 100.0, 1, 0}, 0) == RiskDecision::UnknownAccount);
+        assert(gate.check_add(0, Order{1, true, 100.0, 0, 0}, 0) == RiskDecision::QuantityLimit);
+        assert(gate.check_add(0, Order{1, true, 100.0, 51, 0}, 0) == RiskDecision::QuantityLimit);
+        
+        // Working orders count against the position limit; refusals leave nothing reserved
+        assert(gate.check_add(0, Order{1, true, 100.0, 50, 0}, 0) == RiskDecision::Accepted);
+        assert(gate.check_add(0, Order{2, true, 100.0, 50, 0}, 0) == RiskDecision::Accepted);
+        assert(gate.check_add(0, Order{3, true, 100.0, 1, 0}, 0) == RiskDecision::PositionLimit);
+        assert(gate.check_add(0, Order{3, false, 100.0, 50, 0}, 0) == RiskDecision::NotionalLimit);
+        RiskExposure exposure = gate.exposure(0);
+        assert(exposure.open_buy == 100 && exposure.open_sell == 0 && exposure.open_notional == 10000.0);
+        assert(exposure.rejects == 4);
+        
+        // Fixed windows of window_ns
+        for (uint64_t id = 10; id < 13; ++id) assert(gate.check_add(1, Order{id, false, 99.0, 10, 0}, 500) == RiskDecision::Accepted);
+        assert(gate.check_add(1, Order{13, false, 99.0, 10, 0}, 999) == RiskDecision::RateLimit);
+        gate.release(1, false, 99.0, 30);
+        assert(gate.check_add(1, Order{13, false, 99.0, 30, 0}, 1000) == RiskDecision::Accepted);
+        
+        // Epoch timestamps in 1 ms windows: the window index runs past the 40 bits it is kept in
+        RiskGate epoch_gate(1, 1'000'000);
+        epoch_gate.set_limits(0, RiskLimits{1000, 1e9, 50, 3});
+        uint64_t window_start = tsc_clock().now_ns() / 1'000'000 * 1'000'000;
+        assert(window_start / 1'000'000 >= (uint64_t{1} << 40));
+        for (uint64_t id = 1; id <= 3; ++id) {
+            assert(epoch_gate.check_add(0, Order{id, true, 10.0, 1, 0}, window_start + id) == RiskDecision::Accepted);
+        }
+        assert(epoch_gate.check_add(0, Order{4, true, 10.0, 1, 0}, window_start + 999'999) == RiskDecision::RateLimit);
+        assert(epoch_gate.check_add(0, Order{4, true, 10.0, 1, 0}, window_start + 1'000'000) == RiskDecision::Accepted);
+        
+        // Through a queue into the book: fills and cancels hand reservations back
+        RiskLedger ledger(gate);
+        BasicOrderBook<RiskTradeSink> book{RiskTradeSink{&ledger}};
+        Fifo3<RiskedCommand> queue(16);
+        queue.push(RiskedCommand::add(0, Order{1, true, 100.0, 50, 1}));
+        queue.push(RiskedCommand::add(0, Order{2, true, 100.0, 50, 2}));
+        queue.push(RiskedCommand::add(1, Order{13, false, 99.0, 30, 3}));
+        queue.push(RiskedCommand::cancel(0, 2));
+        RiskedCommand command;
+        while (queue.pop(command)) assert(ledger.apply(book, command) == CommandStatus::Accepted);
+        exposure = gate.exposure(0);
+        assert(exposure.position == 30 && exposure.open_buy == 20 && exposure.open_notional == 2000.0);
+        exposure = gate.exposure(1);
+        assert(exposure.position == -30 && exposure.open_sell == 0 && exposure.open_notional == 0.0);
+        assert(book.trade_sink().trades == 1 && ledger.working() == 1);
+        
+        // A duplicate id is refused by the book and its reservation returned
+        assert(gate.check_add(0, Order{1, true, 100.0, 40, 4}, 1000) == RiskDecision::Accepted);
+        assert(ledger.apply(book, RiskedCommand::add(0, Order{1, true, 100.0, 40, 4})) == CommandStatus::DuplicateOrderId);
+        assert(gate.exposure(0).open_buy == 20 && ledger.working() == 1);
+        bool amend_refused = false;
+        try {
+            ledger.apply(book, RiskedCommand{0, OrderCommand::amend(1, 100.0, 10)});
+        } catch (const std::runtime_error&) {
+            amend_refused = true;
+        }
+        assert(amend_refused);
+        
+        // Gateways racing for one account never reserve past its limit
+        RiskGate shared(1);
+        shared.set_limits(0, RiskLimits{1000, 1e12, 10, 1 << 23});
+        std::atomic<int64_t> accepted{0};
+        std::vector<std::thread> gateways;
+        for (int g = 0; g < 4; ++g) {
+            gateways.emplace_back([&, g] {
+                for (uint64_t i = 0; i < 2000; ++i) {
+                    if (shared.check_add(0, Order{i, g % 2 == 0, 100.0, 7, 0}, 0) == RiskDecision::Accepted) {
+                        accepted.fetch_add(7);
+                    }
+                }
+            });
+        }
+        for (auto& gateway : gateways) gateway.join();
+        exposure = shared.exposure(0);
+        assert(exposure.open_buy <= 1000 && exposure.open_sell <= 1000 && exposure.open_buy > 0);
+        assert(exposure.open_buy + exposure.open_sell == accepted.load());
+        std::cout << "✓ Test 34: Pre-Trade Risk - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+    
+    // Test 35: Feed Sequencer
+    {
+        auto message = [](uint64_t sequence, uint64_t now, MessageType type = MessageType::AddOrder) {
+            WireMessage m{};
+            m.header = MessageHeader{wire_version, type, 0, 0, sequence, now};
+            return m;
+        };
+        using Replay = std::pair<uint64_t, uint64_t>;
+        SequencerRecorder recorder;
+        FeedSequencer<SequencerRecorder> sequencer(recorder, 1, {.window = 8, .reorder_ns = 100, .retry_ns = 1000});
+        
+        // In order, then reordered inside the window and within the grace period
+        for (uint64_t s : {1, 2, 4, 3}) sequencer.on_message(message(s, 0));
+        sequencer.on_message(message(2, 0));
+        assert((recorder.delivered == std::vector<uint64_t>{1, 2, 3, 4}) && recorder.replays.empty());
+        assert(sequencer.stats().reordered == 2 && sequencer.stats().duplicates == 1 && !sequencer.has_hole(0));
+        
+        // A hole outliving reorder_ns is requested once, then every retry_ns until filled
+        sequencer.on_message(message(6, 10));
+        sequencer.on_message(message(7, 50));
+        assert(recorder.replays.empty());
+        sequencer.on_message(message(8, 120));
+        sequencer.on_message(message(9, 500));
+        sequencer.on_message(message(10, 1200));
+        assert((recorder.replays == std::vector<Replay>{{5, 8}, {5, 10}}));
+        sequencer.on_message(message(5, 5));
+        assert(sequencer.expected(0) == 11 && !sequencer.has_hole(0));
+        
+        // A tail lost before a heartbeat, replayed in order: the next hole still gets its grace
+        sequencer.on_message(message(12, 2000, MessageType::Heartbeat));
+        sequencer.on_message(message(12, 2200, MessageType::Heartbeat));
+        assert(recorder.replays.size() == 3 && recorder.replays.back() == Replay(11, 12));
+        for (uint64_t s : {11, 12, 13, 14}) sequencer.on_message(message(s, 2250));
+        sequencer.on_message(message(16, 3300));
+        assert(recorder.replays.size() == 3);
+        sequencer.on_message(message(17, 3450));
+        assert(recorder.replays.size() == 4 && recorder.replays.back() == Replay(15, 17));
+        sequencer.on_message(message(15, 3000));
+        assert(sequencer.expected(0) == 18 && recorder.delivered.back() == 17);
+        
+        // Too far ahead for the window: slide and ask for a snapshot once; no replays meanwhile
+        sequencer.on_message(message(30, 4000));
+        assert((recorder.snapshots == std::vector<uint64_t>{23}) && sequencer.has_hole(0));
+        sequencer.on_message(message(31, 9000));
+        assert(recorder.delivered.back() == 17 && recorder.replays.size() == 4);
+        
+        // A snapshot older than the dropped range is refused and asked for again
+        sequencer.on_snapshot(0, 20);
+        assert((recorder.snapshots == std::vector<uint64_t>{23, 24}) && sequencer.has_hole(0));
+        sequencer.on_snapshot(0, 30);
+        assert(recorder.delivered.back() == 31 && sequencer.expected(0) == 32 && !sequencer.has_hole(0));
+        assert(sequencer.stats().dropped == 1 && sequencer.stats().snapshot_requests == 2);
+        std::cout << "✓ Test 35: Feed Sequencer - PASSED" << std::endl;
+        passed++;
+    }
+    total++;
+
     std::cout << "\n=== TEST SUMMARY ===" << std::endl;
     std::cout << "Passed: " << passed << "/" << total << std::endl;
     
@@ -593,7 +1674,7 @@ void run_comprehensive_tests() {
 void demonstrate_features() {
     std::cout << "\n=== DEMONSTRATING ALL FEATURES ===" << std::endl;
     
-    OrderBook book;
+    BasicOrderBook<PrintTradeSink> book;
     
     // 1. Add orders
     std::cout << "\n1. Adding initial orders..." << std::endl;
@@ -663,12 +1744,12 @@ void demonstrate_features() {
               << ", Spread: " << book.get_spread() << std::endl;
 }
 
-void performance_test() {
-    std::cout << "\n=== PERFORMANCE TEST ===" << std::endl;
+void performance_test(OrderBook& book, const std::string& label) {
+    std::cout << "\n=== PERFORMANCE TEST (" << label << ") ===" << std::endl;
     
-    OrderBook book;
+    book.reserve_orders(10000);
     
-    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t start = tsc_read();
     
     // Add orders without immediate matching for performance test
     for (int i = 0; i < 10000; i++) {
@@ -682,20 +1763,17 @@ void performance_test() {
         book.add_order(o, false); // Don't match immediately
     }
     
-    auto mid = std::chrono::high_resolution_clock::now();
+    uint64_t mid = tsc_read();
     
     // Cancel some orders
     for (int i = 0; i < 2000; i++) {
         book.cancel_order(i * 5 + 1);
     }
     
-    auto end = std::chrono::high_resolution_clock::now();
-    
-    auto add_time = std::chrono::duration_cast<std::chrono::microseconds>(mid - start);
-    auto cancel_time = std::chrono::duration_cast<std::chrono::microseconds>(end - mid);
+    uint64_t end = tsc_read<TscFence::Rdtscp>();
     
-    std::cout << "Added 10000 orders in " << add_time.count() << " us" << std::endl;
-    std::cout << "Cancelled 2000 orders in " << cancel_time.count() << " us" << std::endl;
+    std::cout << "Added 10000 orders in " << tsc_clock().to_ns(mid - start) / 1000 << " us" << std::endl;
+    std::cout << "Cancelled 2000 orders in " << tsc_clock().to_ns(end - mid) / 1000 << " us" << std::endl;
     
     uint64_t trades, volume;
     size_t active_orders;
@@ -715,7 +1793,10 @@ int main() {
         demonstrate_features();
         
         // Performance test
-        performance_test();
+        OrderBook map_book;
+        performance_test(map_book, "std::map levels");
+        OrderBook ladder_book(TickLadderConfig{0.01, 50.0, 150.0});
+        performance_test(ladder_book, "tick ladder");
         
         std::cout << "\n=== PROGRAM COMPLETED SUCCESSFULLY ===" << std::endl;
         
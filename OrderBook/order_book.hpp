@@ -0,0 +1,1898 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <set>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <span>
+#include <memory_resource>
+#include <type_traits>
+
+#include "../SPSC_QUEUES/spsc_q4.cpp"
+#include "seqlock.hpp"
+#include "tsc_clock.hpp"
+#include "probes.hpp"
+#include "../L10/vector.hpp"
+#include "../L4/size_class_allocator.hpp"
+#include "../L8/intrusive_ptr.hpp"
+
+struct Order {
+    uint64_t order_id;
+    bool is_buy;  // true for buy, false for sell
+    double price;
+    uint64_t quantity;
+    uint64_t timestamp_ns;
+};
+
+struct PriceLevel {
+    double price;
+    uint64_t total_quantity;
+    
+    PriceLevel() : price(0.0), total_quantity(0) {}
+    PriceLevel(double p, uint64_t qty) : price(p), total_quantity(qty) {}
+    
+    bool operator==(const PriceLevel& other) const {
+        return price == other.price && total_quantity == other.total_quantity;
+    }
+};
+
+// Fixed-size top-of-book depth copied out of the book's incremental cache.
+// `version` lets pollers skip books that have not changed since their last read.
+struct DepthSnapshot {
+    static constexpr size_t max_depth = 10;
+    
+    PriceLevel bids[max_depth];
+    PriceLevel asks[max_depth];
+    size_t bid_count;
+    size_t ask_count;
+    uint64_t version;
+};
+
+// A DepthSnapshot shared by any number of readers on any threads, immutable
+// once handed out. Allocated from the size-class pools and returned to them
+// by whichever thread drops the last handle.
+struct SharedDepth : RefCounted<SharedDepth, AtomicRefCount, SmallDelete<SharedDepth>> {
+    DepthSnapshot depth;
+};
+
+// Market-by-price update for one level, as published on the delta feed
+enum class LevelAction : uint8_t { New, Change, Delete };
+
+struct LevelDelta {
+    uint64_t sequence;
+    double price;
+    uint64_t quantity;   // Level total after the update; 0 for Delete
+    bool is_buy;
+    LevelAction action;
+};
+
+// Preallocated overwrite ring of level deltas. The book appends and never
+// blocks; readers keep their own sequence cursor and are told about a gap
+// if they fall a full ring behind the writer.
+class LevelDeltaRing {
+public:
+    LevelDeltaRing() : mask_(0), next_sequence_(1) {}
+    
+    // Capacity is rounded up to a power of two; zero disables the feed
+    explicit LevelDeltaRing(size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : slots_(resource), mask_(0), next_sequence_(1) {
+        if (capacity == 0) return;
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+    
+    bool enabled() const { return !slots_.empty(); }
+    
+    void push(bool is_buy, double price, uint64_t quantity, LevelAction action) {
+        slots_[next_sequence_ & mask_] = LevelDelta{next_sequence_, price, quantity, is_buy, action};
+        next_sequence_++;
+    }
+    
+    // Sequence number the next delta will carry
+    uint64_t next_sequence() const { return next_sequence_; }
+    
+    // Copies deltas starting at `cursor` into `out` and advances `cursor`.
+    // Sets `gap` if deltas before the oldest one still held were overwritten.
+    size_t read(uint64_t& cursor, std::span<LevelDelta> out, bool& gap) const {
+        uint64_t oldest = next_sequence_ > slots_.size() ? next_sequence_ - slots_.size() : 1;
+        gap = cursor < oldest;
+        if (gap) cursor = oldest;
+        
+        size_t count = 0;
+        while (cursor < next_sequence_ && count < out.size()) {
+            out[count++] = slots_[cursor & mask_];
+            cursor++;
+        }
+        return count;
+    }
+    
+private:
+    std::pmr::vector<LevelDelta> slots_;
+    size_t mask_;
+    uint64_t next_sequence_;
+};
+
+// How submit_order() treats an incoming order. Whatever the type, the order
+// first trades against the opposite side as far as its price allows; the
+// type decides what happens to the rest.
+enum class OrderType : uint8_t {
+    Limit,   // The rest is added to the book
+    IOC,     // Immediate-or-cancel: the rest is dropped
+    FOK,     // Fill-or-kill: trades its whole quantity on arrival, or nothing
+    Market,  // IOC without a price limit; Order::price is ignored
+};
+
+// Outcome of one submit_order() call
+struct ExecutionReport {
+    uint64_t filled_quantity;
+    uint64_t rested_quantity;     // Added to the book (Limit only)
+    uint64_t cancelled_quantity;  // Dropped unfilled (IOC, FOK, Market)
+    uint64_t trades;
+};
+
+// One message of a batch submitted through apply_batch()
+enum class CommandType : uint8_t { Add, Cancel, Amend };
+
+struct OrderCommand {
+    CommandType type;
+    Order order;  // Add: the full order; Cancel: order_id; Amend: order_id, price, quantity
+    
+    static OrderCommand add(const Order& order) { return OrderCommand{CommandType::Add, order}; }
+    static OrderCommand cancel(uint64_t order_id) {
+        return OrderCommand{CommandType::Cancel, Order{order_id, false, 0.0, 0, 0}};
+    }
+    static OrderCommand amend(uint64_t order_id, double new_price, uint64_t new_quantity) {
+        return OrderCommand{CommandType::Amend, Order{order_id, false, new_price, new_quantity, 0}};
+    }
+};
+
+enum class CommandStatus : uint8_t {
+    Accepted,
+    DuplicateOrderId,
+    UnknownOrderId,
+    InvalidQuantity,
+    InvalidPrice
+};
+
+// Consolidated outcome of one apply_batch() call
+struct BatchResult {
+    size_t accepted;
+    size_t rejected;
+    uint64_t trades;   // Fills produced by the batch's single matching pass
+    uint64_t volume;
+};
+
+// One fill, as reported to the book's trade sink
+struct TradeEvent {
+    uint64_t trade_id;
+    uint64_t buy_order_id;
+    uint64_t sell_order_id;
+    double price;
+    uint64_t quantity;
+    bool buyer_aggressor = false;   // The buy order took liquidity; crossed-book matching counts the buy
+};
+
+// Trade sinks receive every fill from the matching path via on_trade().
+// They are a template policy of BasicOrderBook, so a sink must never block
+// or do I/O; the no-op sink compiles away entirely.
+struct NullTradeSink {
+    void on_trade(const TradeEvent&) {}
+};
+
+// Records fills into a buffer preallocated at construction; fills beyond
+// capacity are counted as dropped rather than growing on the hot path.
+class TradeRecorder {
+public:
+    explicit TradeRecorder(size_t capacity = 4096) : events_(capacity), count_(0), dropped_(0) {}
+    
+    void on_trade(const TradeEvent& event) {
+        if (count_ < events_.size()) {
+            events_[count_++] = event;
+        } else {
+            dropped_++;
+        }
+    }
+    
+    const TradeEvent& operator[](size_t i) const { return events_[i]; }
+    size_t size() const { return count_; }
+    uint64_t dropped() const { return dropped_; }
+    void clear() { count_ = 0; dropped_ = 0; }
+    
+private:
+    Vector<TradeEvent> events_;
+    size_t count_;
+    uint64_t dropped_;
+};
+
+// Hands fills to another thread through a Fifo4; a full queue drops the
+// event instead of stalling the matcher.
+struct QueueTradeSink {
+    Fifo4<TradeEvent>* queue = nullptr;
+    uint64_t dropped = 0;
+    
+    void on_trade(const TradeEvent& event) {
+        if (!queue->push(event)) {
+            dropped++;
+        }
+    }
+};
+
+inline void write_trade(std::ostream& out, const TradeEvent& event) {
+    out << "TRADE: " << event.quantity << " @ " << event.price 
+        << " (Buy: " << event.buy_order_id 
+        << ", Sell: " << event.sell_order_id << ")\n";
+}
+
+// Synchronous console output, for demos only
+struct PrintTradeSink {
+    void on_trade(const TradeEvent& event) { write_trade(std::cout, event); }
+};
+
+// Background thread draining a Fifo4 of fills to a stream.
+// Pair with QueueTradeSink{&logger.queue()} on the matching thread.
+class AsyncTradeLogger {
+public:
+    AsyncTradeLogger(std::ostream& out, size_t queue_capacity)
+        : queue_(queue_capacity), out_(out), running_(true), thread_([this] { run(); }) {}
+    
+    AsyncTradeLogger(const AsyncTradeLogger&) = delete;
+    AsyncTradeLogger& operator=(const AsyncTradeLogger&) = delete;
+    
+    // Flushes everything pushed before destruction
+    ~AsyncTradeLogger() {
+        running_.store(false, std::memory_order_release);
+        thread_.join();
+    }
+    
+    Fifo4<TradeEvent>& queue() { return queue_; }
+    
+private:
+    void run() {
+        TradeEvent event;
+        while (true) {
+            if (queue_.pop(event)) {
+                write_trade(out_, event);
+            } else if (!running_.load(std::memory_order_acquire)) {
+                while (queue_.pop(event)) {
+                    write_trade(out_, event);
+                }
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        out_.flush();
+    }
+    
+    Fifo4<TradeEvent> queue_;
+    std::ostream& out_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+// Integer-tick price band for the array-indexed ladder mode.
+// Prices must lie on the tick grid within [min_price, max_price].
+struct TickLadderConfig {
+    double tick_size;
+    double min_price;
+    double max_price;
+};
+
+// Tick grid of a book whose band is chosen at run time: map mode, or a
+// ladder configured at construction
+class RuntimeTickGrid {
+public:
+    static constexpr bool fixed = false;
+    
+    RuntimeTickGrid() = default;
+    explicit RuntimeTickGrid(const TickLadderConfig& config)
+        : use_ladder_(true), tick_size_(config.tick_size), inv_tick_size_(1.0 / config.tick_size) {
+        if (config.tick_size <= 0.0 || config.min_price <= 0.0 || config.max_price < config.min_price) {
+            throw std::runtime_error("Invalid tick ladder configuration");
+        }
+        min_tick_ = std::llround(config.min_price / config.tick_size);
+        num_ticks_ = static_cast<size_t>(std::llround(config.max_price / config.tick_size) - min_tick_) + 1;
+    }
+    
+    bool use_ladder() const { return use_ladder_; }
+    double tick_size() const { return tick_size_; }
+    double inv_tick_size() const { return inv_tick_size_; }
+    int64_t min_tick() const { return min_tick_; }   // Band floor in absolute ticks (price / tick_size)
+    size_t num_ticks() const { return num_ticks_; }
+    
+private:
+    bool use_ladder_ = false;
+    double tick_size_ = 0.0;
+    double inv_tick_size_ = 0.0;
+    int64_t min_tick_ = 0;
+    size_t num_ticks_ = 0;
+};
+
+// Compile-time instrument parameters. Used as a template argument, every
+// instrument with the same values shares one book and queue specialization
+// (see instrument.hpp), with the band and capacity folded into the code.
+struct InstrumentSpec {
+    double tick_size;
+    double min_price;
+    double max_price;
+    size_t queue_capacity;   // Inbound queue slots; a power of two
+    
+    constexpr int64_t min_tick() const { return round_ticks(min_price / tick_size); }
+    constexpr size_t num_ticks() const {
+        return static_cast<size_t>(round_ticks(max_price / tick_size) - min_tick()) + 1;
+    }
+    
+    constexpr bool valid() const {
+        auto on_grid = [this](double price) {
+            double ticks = price / tick_size;
+            double offset = ticks - static_cast<double>(round_ticks(ticks));
+            return offset < 1e-6 && offset > -1e-6;
+        };
+        return tick_size > 0.0 && min_price > 0.0 && max_price >= min_price && on_grid(min_price) &&
+               on_grid(max_price) && queue_capacity > 0 && (queue_capacity & (queue_capacity - 1)) == 0;
+    }
+    
+    constexpr bool matches(const TickLadderConfig& config) const {
+        return config.tick_size == tick_size && config.min_price == min_price && config.max_price == max_price;
+    }
+    
+    // std::llround is not constexpr; prices here are positive
+    static constexpr int64_t round_ticks(double ticks) { return static_cast<int64_t>(ticks + 0.5); }
+};
+
+// Ladder grid fixed at compile time: the same interface as RuntimeTickGrid
+// with constants, so price-to-tick math folds and map-mode branches vanish
+template<InstrumentSpec Spec>
+struct StaticTickGrid {
+    static_assert(Spec.valid(), "tick size must be positive, the band on the tick grid, capacity a power of two");
+    static constexpr bool fixed = true;
+    
+    static constexpr bool use_ladder() { return true; }
+    static constexpr double tick_size() { return Spec.tick_size; }
+    static constexpr double inv_tick_size() { return 1.0 / Spec.tick_size; }
+    static constexpr int64_t min_tick() { return Spec.min_tick(); }
+    static constexpr size_t num_ticks() { return Spec.num_ticks(); }
+};
+
+// How a price level keeps its FIFO of resting orders.
+//   Linked: orders link to each other; a sweep loads each order to find the next.
+//   Ring:   the level holds order indices in cache-line chunks, so the next
+//           orders are known ahead of the one being filled and are prefetched.
+//           Cancels leave tombstones, compacted once they outnumber live orders.
+enum class QueueLayout : uint8_t {
+    Linked,
+    Ring
+};
+
+// Binary image of a book's resting state, for warm restarts. Layout:
+//   BookImageHeader
+//   BookImageLevel[bid_levels + ask_levels]  bids best first, then asks best first
+//   BookImageOrder[orders]                   level by level, in time priority
+// Levels own the next order_count orders, so queues are implied by position
+// and the image holds no pointers: it loads straight from an mmap'd file.
+struct BookImageHeader {
+    char magic[8];          // "OBIMAGE\0"
+    uint32_t version;
+    uint32_t ladder;        // 1 for a tick-ladder book; the band must match to load
+    double tick_size;
+    int64_t min_tick;
+    uint64_t num_ticks;
+    uint64_t sequence;      // Journal sequence the image reflects; replay continues after it
+    uint64_t book_version;
+    uint64_t total_trades;
+    uint64_t total_volume;
+    uint64_t bid_levels;
+    uint64_t ask_levels;
+    uint64_t orders;
+};
+
+struct BookImageLevel {
+    double price;
+    uint64_t total_quantity;
+    uint64_t order_count;
+};
+
+struct BookImageOrder {
+    uint64_t order_id;
+    uint64_t quantity;
+    uint64_t timestamp_ns;
+};
+
+static_assert(sizeof(BookImageHeader) == 96);
+static_assert(sizeof(BookImageLevel) == 24 && sizeof(BookImageOrder) == 24);
+
+constexpr char book_image_magic[8] = {'O', 'B', 'I', 'M', 'A', 'G', 'E', 0};
+constexpr uint32_t book_image_version = 1;
+
+// One price level of a book side: its total and the FIFO queue of resting
+// orders. With linked queues, head and tail are OrderStore indices; with ring
+// queues they are QueueChunkStore slots. 0 is the null link either way, so a
+// level is empty exactly when head is 0. Levels do not move while they hold
+// orders, in a map node or a ladder slot.
+struct PriceLevelData {
+    double price = 0.0;
+    uint64_t total_quantity = 0;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t orders = 0;
+    uint32_t tombstones = 0;    // Ring queues: cancelled slots still in the chunks
+};
+
+// A resting order as the book stores it: 32 bytes, so two share a cache line
+// on a level sweep. The order points at its level, which holds its price, so
+// cancels, fills and amends reach the level without a lookup. Queue links
+// are 32-bit indices into an OrderStore and the side is a single bit; the
+// timestamp is only read when an order is copied out, so it lives in the
+// store's cold array instead.
+struct OrderNode {
+    uint64_t order_id;
+    uint64_t quantity;
+    PriceLevelData* level; // Set while the order is queued
+    uint32_t next;         // OrderStore index, 0 ends the queue; ring queues: the order's slot
+    uint32_t prev : 31;
+    uint32_t is_buy : 1;
+};
+
+static_assert(sizeof(OrderNode) == 32, "two resting orders per cache line");
+
+// Index-addressed storage for resting orders. Nodes are carved out of fixed
+// chunks (the MemoryPool idea from L5/memory_allocator.cpp), so growing never
+// moves a live node, and freed indices are recycled through a free list
+// threaded through `next`. Index 0 is never handed out: it is the null link.
+class OrderStore {
+public:
+    static constexpr uint32_t nil = 0;
+    
+    explicit OrderStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : chunks_(resource), free_list_(nil), next_unused_(1), in_use_(0) {}
+    
+    OrderStore(const OrderStore&) = delete;
+    OrderStore& operator=(const OrderStore&) = delete;
+    
+    ~OrderStore() {
+        std::pmr::memory_resource* resource = chunks_.get_allocator().resource();
+        for (const Chunk& chunk : chunks_) {
+            resource->deallocate(chunk.nodes, chunk_size * sizeof(OrderNode), 64);
+            resource->deallocate(chunk.timestamps, chunk_size * sizeof(uint64_t), alignof(uint64_t));
+        }
+    }
+    
+    // Make room for at least `count` live orders without further chunk allocation
+    void reserve(size_t count) {
+        while (capacity() < count) {
+            add_chunk();
+        }
+    }
+    
+    uint32_t create(const Order& order) {
+        uint32_t index = free_list_;
+        if (index != nil) {
+            free_list_ = node(index).next;
+        } else {
+            if (next_unused_ >= chunks_.size() * chunk_size) {
+                add_chunk();
+            }
+            index = next_unused_++;
+        }
+        node(index) = OrderNode{order.order_id, order.quantity, nullptr, nil, nil, order.is_buy};
+        timestamp(index) = order.timestamp_ns;
+        in_use_++;
+        return index;
+    }
+    
+    void destroy(uint32_t index) {
+        node(index).next = free_list_;
+        free_list_ = index;
+        in_use_--;
+    }
+    
+    OrderNode& node(uint32_t index) { return chunks_[index >> chunk_shift].nodes[index & (chunk_size - 1)]; }
+    const OrderNode& node(uint32_t index) const { return chunks_[index >> chunk_shift].nodes[index & (chunk_size - 1)]; }
+    
+    uint64_t& timestamp(uint32_t index) { return chunks_[index >> chunk_shift].timestamps[index & (chunk_size - 1)]; }
+    uint64_t timestamp(uint32_t index) const { return chunks_[index >> chunk_shift].timestamps[index & (chunk_size - 1)]; }
+    
+    Order to_order(uint32_t index) const {
+        const OrderNode& n = node(index);
+        return Order{n.order_id, static_cast<bool>(n.is_buy), n.level->price, n.quantity, timestamp(index)};
+    }
+    
+    size_t capacity() const { return chunks_.empty() ? 0 : chunks_.size() * chunk_size - 1; }
+    size_t in_use() const { return in_use_; }
+    
+private:
+    static constexpr unsigned chunk_shift = 12;
+    static constexpr size_t chunk_size = size_t{1} << chunk_shift;
+    static constexpr size_t max_chunks = (size_t{1} << 31) / chunk_size;  // prev is 31 bits
+    
+    struct Chunk {
+        OrderNode* nodes;
+        uint64_t* timestamps;
+    };
+    
+    void add_chunk() {
+        if (chunks_.size() == max_chunks) {
+            throw std::runtime_error("OrderStore: resting order limit reached");
+        }
+        std::pmr::memory_resource* resource = chunks_.get_allocator().resource();
+        Chunk chunk;
+        chunk.nodes = static_cast<OrderNode*>(resource->allocate(chunk_size * sizeof(OrderNode), 64));
+        try {
+            chunk.timestamps = static_cast<uint64_t*>(resource->allocate(chunk_size * sizeof(uint64_t), alignof(uint64_t)));
+            chunks_.push_back(chunk);
+        } catch (...) {
+            resource->deallocate(chunk.nodes, chunk_size * sizeof(OrderNode), 64);
+            throw;
+        }
+    }
+    
+    std::pmr::vector<Chunk> chunks_;
+    uint32_t free_list_;
+    uint32_t next_unused_;
+    size_t in_use_;
+};
+
+// Chunks for ring level queues: 15 order indices and a link to the level's
+// next chunk, one cache line each. A slot is addressed as chunk << 4 | offset,
+// so slot 0 (in the never-used chunk 0) is the null link. Queues refer to
+// chunks only by index, so the chunks sit in one flat array that may move
+// when it grows; freed chunks are recycled through a free list.
+struct alignas(64) QueueChunk {
+    uint32_t slots[15];
+    uint32_t next;
+};
+
+static_assert(sizeof(QueueChunk) == 64);
+
+class QueueChunkStore {
+public:
+    static constexpr uint32_t nil = 0;
+    static constexpr uint32_t slots_per_chunk = 15;
+    
+    explicit QueueChunkStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : chunks_(1, resource), free_list_(nil) {}
+    
+    // Make room for `count` chunks without growing the array
+    void reserve(size_t count) {
+        chunks_.reserve(std::min(count + 1, max_chunks));
+    }
+    
+    // A chunk with no next link; returns its first slot
+    uint32_t create() {
+        uint32_t index = free_list_;
+        if (index != nil) {
+            free_list_ = chunks_[index].next;
+        } else {
+            if (chunks_.size() == max_chunks) {
+                throw std::runtime_error("QueueChunkStore: queue chunk limit reached");
+            }
+            index = static_cast<uint32_t>(chunks_.size());
+            chunks_.emplace_back();
+        }
+        chunks_[index].next = nil;
+        return index << 4;
+    }
+    
+    void destroy(uint32_t chunk_index) {
+        chunks_[chunk_index].next = free_list_;
+        free_list_ = chunk_index;
+    }
+    
+    QueueChunk& chunk(uint32_t index) { return chunks_[index]; }
+    const QueueChunk& chunk(uint32_t index) const { return chunks_[index]; }
+    
+    uint32_t& slot(uint32_t slot_id) { return chunks_[slot_id >> 4].slots[slot_id & 15]; }
+    uint32_t slot(uint32_t slot_id) const { return chunks_[slot_id >> 4].slots[slot_id & 15]; }
+    
+    // The slot after slot_id in a level's queue, nil past the last chunk
+    uint32_t next_slot(uint32_t slot_id) const {
+        if ((slot_id & 15) + 1 < slots_per_chunk) return slot_id + 1;
+        return chunks_[slot_id >> 4].next << 4;
+    }
+    
+private:
+    static constexpr size_t max_chunks = size_t{1} << 28;  // Slot ids are 32 bits
+    
+    std::pmr::vector<QueueChunk> chunks_;
+    uint32_t free_list_;
+};
+
+// Flat open-addressing map from 64-bit order id to a small value (a pointer
+// or a store index). Linear probing over a power-of-two table with Fibonacci
+// hashing; erase uses backward-shift deletion so no tombstones accumulate
+// under heavy cancel flow. A value-initialized Value (null, index 0) marks an
+// empty slot, so it cannot be stored.
+template<typename Value>
+class FlatIdMap {
+public:
+    explicit FlatIdMap(size_t initial_capacity = 16,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : slots_(resource), size_(0) {
+        rehash(table_size_for(initial_capacity));
+    }
+    
+    // Size the table so `count` entries fit without rehashing
+    void reserve(size_t count) {
+        size_t wanted = table_size_for(count);
+        if (wanted > slots_.size()) {
+            rehash(wanted);
+        }
+    }
+    
+    // Value{} if the key is absent
+    Value find(uint64_t key) const {
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            if (!slot.value) return Value{};
+            if (slot.key == key) return slot.value;
+        }
+    }
+    
+    bool contains(uint64_t key) const { return find(key) != Value{}; }
+    
+    // Inserts or overwrites the value for key
+    void insert(uint64_t key, Value value) {
+        assert(value != Value{});
+        if ((size_ + 1) * 2 > slots_.size()) {
+            rehash(slots_.size() * 2);
+        }
+        size_t i = home(key);
+        while (slots_[i].value && slots_[i].key != key) {
+            i = (i + 1) & mask_;
+        }
+        if (!slots_[i].value) size_++;
+        slots_[i] = Slot{key, value};
+    }
+    
+    bool erase(uint64_t key) {
+        size_t hole = home(key);
+        while (true) {
+            if (!slots_[hole].value) return false;
+            if (slots_[hole].key == key) break;
+            hole = (hole + 1) & mask_;
+        }
+        
+        // Shift later members of the probe run back into the hole
+        for (size_t next = (hole + 1) & mask_; slots_[next].value; next = (next + 1) & mask_) {
+            size_t ideal = home(slots_[next].key);
+            if (((next - ideal) & mask_) >= ((next - hole) & mask_)) {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+        }
+        slots_[hole] = Slot{};
+        size_--;
+        return true;
+    }
+    
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.value) fn(slot.key, slot.value);
+        }
+    }
+    
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    
+private:
+    struct Slot {
+        uint64_t key = 0;
+        Value value{};
+    };
+    
+    // Keeps the load factor at or below one half
+    static size_t table_size_for(size_t count) {
+        size_t size = 16;
+        while (size < count * 2) size <<= 1;
+        return size;
+    }
+    
+    size_t home(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+    
+    void rehash(size_t new_size) {
+        std::pmr::vector<Slot> old_slots(new_size, slots_.get_allocator());
+        old_slots.swap(slots_);
+        mask_ = new_size - 1;
+        shift_ = 64 - static_cast<unsigned>(__builtin_ctzll(new_size));
+        size_ = 0;
+        for (const Slot& slot : old_slots) {
+            if (slot.value) insert(slot.key, slot.value);
+        }
+    }
+    
+    std::pmr::vector<Slot> slots_;
+    size_t mask_;
+    unsigned shift_;
+    size_t size_;
+};
+
+template<typename T>
+using OrderIdMap = FlatIdMap<T*>;
+
+// Grid is RuntimeTickGrid, or StaticTickGrid<Spec> for a ladder book whose
+// band is fixed at compile time
+template<typename TradeSink = NullTradeSink, typename Grid = RuntimeTickGrid>
+class BasicOrderBook : private TradeSink {
+private:
+    // The two level containers below share one interface over a level key
+    // (the price in a map, the tick offset in a ladder), and the book's add,
+    // remove, walk and match paths are written once against it:
+    //   level(key), key_of(level), on_level_added(key), on_level_removed(key),
+    //   best_key(), best_level(), for_each(fn), empty(), size()
+    // Compare orders a side best first (std::greater for bids, std::less for
+    // asks) and fixes the side at compile time, so each direction gets its
+    // own code with no is_buy tests below the one dispatch in with_side().
+    
+    // Map mode: one tree node per price
+    template<typename Compare>
+    class BookSide {
+    public:
+        static constexpr bool is_bid = std::is_same_v<Compare, std::greater<double>>;
+        
+        explicit BookSide(std::pmr::memory_resource* resource) : levels_(resource) {}
+        
+        // Level at price, created empty if absent
+        PriceLevelData& level(double price) { return levels_[price]; }
+        
+        double key_of(const PriceLevelData* level) const { return level->price; }
+        
+        void on_level_added(double) {}
+        void on_level_removed(double price) { levels_.erase(price); }
+        
+        bool empty() const { return levels_.empty(); }
+        size_t size() const { return levels_.size(); }
+        double best_key() const { return levels_.begin()->first; }
+        PriceLevelData& best_level() { return levels_.begin()->second; }
+        
+        // Calls fn(price, level) best first until it returns false
+        template<typename Fn>
+        void for_each(Fn&& fn) const {
+            for (const auto& [price, level] : levels_) {
+                if (!fn(price, level)) return;
+            }
+        }
+        
+        std::pmr::memory_resource* resource() const { return levels_.get_allocator().resource(); }
+        
+    private:
+        std::pmr::map<double, PriceLevelData, Compare> levels_;
+    };
+    
+    // Tick ladder mode: a contiguous array of levels indexed by tick offset.
+    // The best level is tracked as an index so lookups never walk a tree.
+    template<typename Compare>
+    class PriceLadder {
+    public:
+        static constexpr bool is_bid = std::is_same_v<Compare, std::greater<double>>;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        
+        explicit PriceLadder(std::pmr::memory_resource* resource)
+            : levels_(resource), best_(npos), active_levels_(0) {}
+        PriceLadder(size_t num_ticks, std::pmr::memory_resource* resource)
+            : levels_(num_ticks, resource), best_(npos), active_levels_(0) {}
+        
+        PriceLevelData& level(size_t tick) { return levels_[tick]; }
+        size_t key_of(const PriceLevelData* level) const { return static_cast<size_t>(level - levels_.data()); }
+        
+        // Called after the first order is linked into an empty level
+        void on_level_added(size_t tick) {
+            active_levels_++;
+            if (best_ == npos || is_better(tick, best_)) {
+                best_ = tick;
+            }
+        }
+        
+        // Called after the last order is unlinked from a level
+        void on_level_removed(size_t tick) {
+            active_levels_--;
+            if (tick != best_) return;
+            best_ = active_levels_ == 0 ? npos : next_active(tick);
+        }
+        
+        bool empty() const { return active_levels_ == 0; }
+        size_t size() const { return active_levels_; }
+        size_t best_key() const { return best_; }
+        PriceLevelData& best_level() { return levels_[best_]; }
+        
+        // Calls fn(tick, level) best first until it returns false
+        template<typename Fn>
+        void for_each(Fn&& fn) const {
+            for (size_t tick = best_; tick != npos; tick = next_active(tick)) {
+                if (!fn(tick, levels_[tick])) return;
+            }
+        }
+        
+    private:
+        static bool is_better(size_t a, size_t b) {
+            if constexpr (is_bid) return a > b;
+            else return a < b;
+        }
+        
+        // Next non-empty level strictly worse than tick, or npos
+        size_t next_active(size_t tick) const {
+            if constexpr (is_bid) {
+                while (tick-- > 0) {
+                    if (levels_[tick].head != OrderStore::nil) return tick;
+                }
+            } else {
+                while (++tick < levels_.size()) {
+                    if (levels_[tick].head != OrderStore::nil) return tick;
+                }
+            }
+            return npos;
+        }
+        
+        std::pmr::vector<PriceLevelData> levels_;
+        size_t best_;
+        size_t active_levels_;
+    };
+    
+    // Bid side (buy orders) - sorted descending by price
+    BookSide<std::greater<double>> bids_;
+    
+    // Ask side (sell orders) - sorted ascending by price  
+    BookSide<std::less<double>> asks_;
+    
+    // Tick ladder mode: both sides share one tick grid so indices compare directly
+    [[no_unique_address]] Grid grid_;
+    PriceLadder<std::greater<double>> bid_ladder_;
+    PriceLadder<std::less<double>> ask_ladder_;
+    
+    // Top-N levels per side, maintained incrementally. Quantity changes at a
+    // cached level are written through; a level appearing or disappearing
+    // inside the window marks the side stale and it is re-walked on next read.
+    struct SideDepthCache {
+        PriceLevel levels[DepthSnapshot::max_depth];
+        size_t count = 0;
+        bool stale = true;
+    };
+    mutable SideDepthCache bid_depth_;
+    mutable SideDepthCache ask_depth_;
+    
+    // Bumped on every change to a price level
+    uint64_t version_;
+    
+    // Market-by-price delta feed; disabled until enable_level_deltas()
+    LevelDeltaRing level_deltas_;
+    
+    // Seqlock that concurrent readers poll for the top of book, if attached
+    SeqLock<DepthSnapshot>* snapshot_target_ = nullptr;
+    uint64_t published_version_ = UINT64_MAX;
+    
+    // Last share_depth() result, reused until the book changes
+    mutable IntrusivePtr<const SharedDepth> shared_depth_;
+    
+    // Order id to OrderStore index of the resting order
+    FlatIdMap<uint32_t> order_lookup_;
+    
+    // Backing storage for every resting order
+    OrderStore orders_;
+    
+    // Level queue layout and, for ring queues, their chunks
+    QueueLayout queue_layout_;
+    QueueChunkStore queue_chunks_;
+    
+    // Trading statistics
+    uint64_t total_trades_;
+    uint64_t total_volume_;
+    
+    uint64_t get_current_timestamp() const { return tsc_clock().now_ns(); }
+    
+    // False if the price lies outside the band or off the tick grid
+    bool try_price_to_tick(double price, size_t& tick) const {
+        double offset = price * grid_.inv_tick_size() - static_cast<double>(grid_.min_tick());
+        double rounded = std::round(offset);
+        if (rounded < 0.0 || rounded >= static_cast<double>(grid_.num_ticks()) || std::abs(offset - rounded) > 1e-6) {
+            return false;
+        }
+        tick = static_cast<size_t>(rounded);
+        return true;
+    }
+    
+    size_t price_to_tick(double price) const {
+        size_t tick;
+        if (!try_price_to_tick(price, tick)) {
+            throw std::runtime_error("Price outside ladder band or off tick grid: " + std::to_string(price));
+        }
+        return tick;
+    }
+    
+    bool is_valid_price(double price) const {
+        size_t tick;
+        return price > 0.0 && (!grid_.use_ladder() || try_price_to_tick(price, tick));
+    }
+    
+    // Validates an incoming order, stamps it and snaps its price to the grid.
+    // Market orders carry no price.
+    Order prepare_order(const Order& order, OrderType type) const {
+        if (order_lookup_.contains(order.order_id)) {
+            throw std::runtime_error("Order ID " + std::to_string(order.order_id) + " already exists");
+        }
+        
+        if (order.quantity == 0) {
+            throw std::runtime_error("Order quantity cannot be zero");
+        }
+        
+        Order prepared = order;
+        if (prepared.timestamp_ns == 0) {
+            prepared.timestamp_ns = get_current_timestamp();
+        }
+        
+        if (type == OrderType::Market) {
+            prepared.price = 0.0;
+            return prepared;
+        }
+        
+        if (order.price <= 0.0) {
+            throw std::runtime_error("Invalid price: " + std::to_string(order.price));
+        }
+        
+        if (grid_.use_ladder()) {
+            // Snap to the grid so stored and reported prices agree exactly
+            prepared.price = tick_to_price(price_to_tick(prepared.price));
+        }
+        return prepared;
+    }
+    
+    // Non-throwing counterpart of add_order's checks; `timestamp` is shared by
+    // every unstamped order of one batch
+    CommandStatus apply_add(const Order& order, uint64_t& timestamp) {
+        if (order_lookup_.contains(order.order_id)) return CommandStatus::DuplicateOrderId;
+        if (order.quantity == 0) return CommandStatus::InvalidQuantity;
+        if (!is_valid_price(order.price)) return CommandStatus::InvalidPrice;
+        
+        Order order_with_ts = order;
+        if (order_with_ts.timestamp_ns == 0) {
+            if (timestamp == 0) timestamp = get_current_timestamp();
+            order_with_ts.timestamp_ns = timestamp;
+        }
+        if (grid_.use_ladder()) {
+            order_with_ts.price = tick_to_price(price_to_tick(order_with_ts.price));
+        }
+        add_order_to_book(order_with_ts);
+        return CommandStatus::Accepted;
+    }
+    
+    CommandStatus apply_command(const OrderCommand& command, uint64_t& timestamp) {
+        const Order& order = command.order;
+        switch (command.type) {
+        case CommandType::Add:
+            return apply_add(order, timestamp);
+        case CommandType::Cancel:
+            return cancel_order(order.order_id) ? CommandStatus::Accepted : CommandStatus::UnknownOrderId;
+        case CommandType::Amend:
+            if (!order_lookup_.contains(order.order_id)) return CommandStatus::UnknownOrderId;
+            if (order.quantity == 0) return CommandStatus::InvalidQuantity;
+            if (!is_valid_price(order.price)) return CommandStatus::InvalidPrice;
+            amend_order(order.order_id, order.price, order.quantity, false);
+            return CommandStatus::Accepted;
+        }
+        return CommandStatus::InvalidQuantity;
+    }
+    
+    double tick_to_price(size_t tick) const {
+        return static_cast<double>(grid_.min_tick() + static_cast<int64_t>(tick)) * grid_.tick_size();
+    }
+    
+    // Level key of a price in each container, and back
+    template<typename Compare>
+    double level_key(const BookSide<Compare>&, double price) const { return price; }
+    template<typename Compare>
+    size_t level_key(const PriceLadder<Compare>&, double price) const { return price_to_tick(price); }
+    double key_price(double price) const { return price; }
+    double key_price(size_t tick) const { return tick_to_price(tick); }
+    
+    // Calls fn(bids, asks) with the containers of the book's representation
+    template<typename Fn>
+    decltype(auto) with_sides(Fn&& fn) {
+        return grid_.use_ladder() ? fn(bid_ladder_, ask_ladder_) : fn(bids_, asks_);
+    }
+    
+    // Calls fn(side) with one side of the book's representation
+    template<typename Fn>
+    decltype(auto) with_side(bool is_buy, Fn&& fn) {
+        if (grid_.use_ladder()) return is_buy ? fn(bid_ladder_) : fn(ask_ladder_);
+        return is_buy ? fn(bids_) : fn(asks_);
+    }
+    
+    template<typename Fn>
+    decltype(auto) with_side(bool is_buy, Fn&& fn) const {
+        if (grid_.use_ladder()) return is_buy ? fn(bid_ladder_) : fn(ask_ladder_);
+        return is_buy ? fn(bids_) : fn(asks_);
+    }
+    
+    template<typename Side>
+    void add_order_to_side(const Order& order, Side& side) {
+        auto key = level_key(side, order.price);
+        uint32_t index = orders_.create(order);
+        order_lookup_.insert(order.order_id, index);
+        attach_order(side, key, order.price, index);
+    }
+    
+    template<typename Side>
+    bool remove_order_from_side(uint64_t order_id, Side& side) {
+        uint32_t index = order_lookup_.find(order_id);
+        if (index == OrderStore::nil) return false;
+        erase_order(side, index);
+        return true;
+    }
+    
+    // Links a stored order to the back of the level at `key` (FIFO)
+    template<typename Side, typename Key>
+    void attach_order(Side& side, Key key, double price, uint32_t index) {
+        OrderNode& node = orders_.node(index);
+        PriceLevelData& level_data = side.level(key);
+        level_data.price = price;
+        level_data.total_quantity += node.quantity;
+        node.level = &level_data;
+        bool new_level = link_back(level_data, index);
+        if (new_level) {
+            side.on_level_added(key);
+        }
+        on_level_changed(Side::is_bid, price, level_data.total_quantity,
+                         new_level ? LevelAction::New : LevelAction::Change);
+    }
+    
+    // Unlinks an order from its level and drops the level if it is now empty.
+    // The order keeps its slot and id entry.
+    template<typename Side>
+    void detach_order(Side& side, uint32_t index) {
+        OrderNode& node = orders_.node(index);
+        PriceLevelData& level_data = *node.level;
+        double price = level_data.price;
+        
+        if (level_data.total_quantity >= node.quantity) {
+            level_data.total_quantity -= node.quantity;
+        } else {
+            level_data.total_quantity = 0;
+        }
+        
+        bool level_removed = unlink(level_data, index);
+        if (level_removed) {
+            level_data.total_quantity = 0;
+        }
+        uint64_t remaining = level_data.total_quantity;
+        node.level = nullptr;
+        node.next = node.prev = OrderStore::nil;
+        if (level_removed) {
+            side.on_level_removed(side.key_of(&level_data));
+        }
+        // A fill that emptied the order was reported already, unless it emptied the level
+        if (level_removed || node.quantity > 0) {
+            on_level_changed(Side::is_bid, price, remaining, level_removed ? LevelAction::Delete : LevelAction::Change);
+        }
+    }
+    
+    template<typename Side>
+    void erase_order(Side& side, uint32_t index) {
+        detach_order(side, index);
+        order_lookup_.erase(orders_.node(index).order_id);
+        orders_.destroy(index);
+    }
+    
+    // True if an incoming order limited at `limit` may trade with the level at `key` of side Resting
+    template<typename Resting, typename Key>
+    static bool reaches(Key key, Key limit) {
+        if constexpr (Resting::is_bid) return key >= limit;
+        else return key <= limit;
+    }
+    
+    // Fill-or-kill check: whether `quantity` is resting within the limit
+    template<typename Resting, typename Key>
+    bool can_fill(const Resting& resting, bool market, Key limit, uint64_t quantity) const {
+        uint64_t available = 0;
+        resting.for_each([&](Key key, const PriceLevelData& level) {
+            if (!market && !reaches<Resting>(key, limit)) return false;
+            available += level.total_quantity;
+            return available < quantity;
+        });
+        return available >= quantity;
+    }
+    
+    // Trades an incoming order against the opposite side, best level and
+    // oldest order first, and returns the quantity left over. Every fill is
+    // at the resting order's price, and the incoming order never touches the
+    // book's structures.
+    template<typename Resting, typename Key>
+    uint64_t match_incoming(const Order& order, bool market, Key limit, Resting& resting) {
+        uint64_t quantity = order.quantity;
+        while (quantity > 0 && !resting.empty() && (market || reaches<Resting>(resting.best_key(), limit))) {
+            PriceLevelData& level = resting.best_level();
+            uint32_t maker_index = front(level);
+            prefetch_queue(level);
+            OrderNode& maker = orders_.node(maker_index);
+            uint64_t trade_quantity = std::min(quantity, maker.quantity);
+            
+            total_trades_++;
+            if constexpr (Resting::is_bid) {
+                trade_sink().on_trade(TradeEvent{total_trades_, maker.order_id, order.order_id, level.price, trade_quantity});
+            } else {
+                trade_sink().on_trade(TradeEvent{total_trades_, order.order_id, maker.order_id, level.price, trade_quantity, true});
+            }
+            total_volume_ += trade_quantity;
+            
+            quantity -= trade_quantity;
+            maker.quantity -= trade_quantity;
+            level.total_quantity -= trade_quantity;
+            // A level emptied by the fill is reported once, as a Delete, on removal below
+            if (level.total_quantity > 0) {
+                on_level_changed(Resting::is_bid, level.price, level.total_quantity, LevelAction::Change);
+            }
+            if (maker.quantity == 0) {
+                erase_order(resting, maker_index);
+            }
+        }
+        return quantity;
+    }
+    
+    // Chunks for `orders` orders in queues at most half tombstones, plus a
+    // partly used one at each end of a few hundred levels
+    static size_t queue_chunks_for(size_t orders) {
+        return orders == 0 ? 0 : 2 * orders / QueueChunkStore::slots_per_chunk + 512;
+    }
+    
+    // Oldest order of a non-empty level
+    uint32_t front(const PriceLevelData& level) const {
+        return queue_layout_ == QueueLayout::Ring ? queue_chunks_.slot(level.head) : level.head;
+    }
+    
+    // Calls fn(index) for a level's orders, oldest first
+    template<typename Fn>
+    void for_each_queued(const PriceLevelData& level, Fn&& fn) const {
+        if (queue_layout_ == QueueLayout::Ring) {
+            for (uint32_t slot = level.head; slot != QueueChunkStore::nil; slot = queue_chunks_.next_slot(slot)) {
+                uint32_t index = queue_chunks_.slot(slot);
+                if (index != OrderStore::nil) fn(index);
+                if (slot == level.tail) return;
+            }
+        } else {
+            for (uint32_t index = level.head; index != OrderStore::nil; index = orders_.node(index).next) {
+                fn(index);
+            }
+        }
+    }
+    
+    // Ahead of a fill: prefetches the order after the front one, which ring
+    // queues know without loading the front order first. Stays inside the
+    // front chunk, so it costs no extra link walk.
+    void prefetch_queue(const PriceLevelData& level) const {
+        if (queue_layout_ != QueueLayout::Ring || level.head == level.tail) return;
+        if ((level.head & 15) + 1 < QueueChunkStore::slots_per_chunk) {
+            uint32_t index = queue_chunks_.slot(level.head + 1);
+            if (index != OrderStore::nil) __builtin_prefetch(&orders_.node(index), 1);
+        }
+    }
+    
+    // Appends an order to the back of its level's queue; true if the level was empty
+    bool link_back(PriceLevelData& level, uint32_t index) {
+        level.orders++;
+        if (queue_layout_ == QueueLayout::Ring) {
+            return ring_push(level, index);
+        }
+        if (level.head == OrderStore::nil) {
+            level.head = level.tail = index;
+            return true;
+        }
+        orders_.node(level.tail).next = index;
+        orders_.node(index).prev = level.tail;
+        level.tail = index;
+        return false;
+    }
+    
+    // Takes an order out of its level's queue; true if the level is now empty
+    bool unlink(PriceLevelData& level, uint32_t index) {
+        level.orders--;
+        if (queue_layout_ == QueueLayout::Ring) {
+            return ring_remove(level, index);
+        }
+        const OrderNode& node = orders_.node(index);
+        if (node.prev != OrderStore::nil) {
+            orders_.node(node.prev).next = node.next;
+        } else {
+            level.head = node.next;
+        }
+        if (node.next != OrderStore::nil) {
+            orders_.node(node.next).prev = node.prev;
+        } else {
+            level.tail = node.prev;
+        }
+        return level.head == OrderStore::nil;
+    }
+    
+    bool ring_push(PriceLevelData& level, uint32_t index) {
+        bool was_empty = level.head == QueueChunkStore::nil;
+        if (was_empty) {
+            level.head = level.tail = queue_chunks_.create();
+        } else if ((level.tail & 15) + 1 < QueueChunkStore::slots_per_chunk) {
+            level.tail++;
+        } else {
+            uint32_t slot = queue_chunks_.create();
+            queue_chunks_.chunk(level.tail >> 4).next = slot >> 4;
+            level.tail = slot;
+        }
+        queue_chunks_.slot(level.tail) = index;
+        orders_.node(index).next = level.tail;
+        return was_empty;
+    }
+    
+    // Cancels in the middle leave a tombstone; removing the front skips past
+    // tombstones so the front slot is always live. Called with level.orders
+    // already decremented.
+    bool ring_remove(PriceLevelData& level, uint32_t index) {
+        if (level.orders == 0) {
+            release_chunks(level.head >> 4);
+            level.head = level.tail = QueueChunkStore::nil;
+            level.tombstones = 0;
+            return true;
+        }
+        uint32_t slot = orders_.node(index).next;
+        if (slot != level.head) {
+            queue_chunks_.slot(slot) = OrderStore::nil;
+            if (++level.tombstones > level.orders && level.tombstones >= QueueChunkStore::slots_per_chunk) {
+                compact(level);
+            }
+            return false;
+        }
+        // A live order follows, so this stops before running off the tail
+        for (;;) {
+            uint32_t next = queue_chunks_.next_slot(slot);
+            if ((next >> 4) != (slot >> 4)) {
+                queue_chunks_.destroy(slot >> 4);
+            }
+            slot = next;
+            if (queue_chunks_.slot(slot) != OrderStore::nil) break;
+            level.tombstones--;
+        }
+        level.head = slot;
+        return false;
+    }
+    
+    // Packs a level's live orders into its leading chunks and frees the rest
+    void compact(PriceLevelData& level) {
+        uint32_t write = level.head & ~uint32_t{15};
+        uint32_t last = write;
+        for (uint32_t read = level.head;; read = queue_chunks_.next_slot(read)) {
+            uint32_t index = queue_chunks_.slot(read);
+            if (index != OrderStore::nil) {
+                queue_chunks_.slot(write) = index;
+                orders_.node(index).next = write;
+                last = write;
+                write = queue_chunks_.next_slot(write);
+            }
+            if (read == level.tail) break;
+        }
+        QueueChunk& tail_chunk = queue_chunks_.chunk(last >> 4);
+        release_chunks(tail_chunk.next);
+        tail_chunk.next = QueueChunkStore::nil;
+        level.head = level.head & ~uint32_t{15};
+        level.tail = last;
+        level.tombstones = 0;
+    }
+    
+    void release_chunks(uint32_t chunk_index) {
+        while (chunk_index != QueueChunkStore::nil) {
+            uint32_t next = queue_chunks_.chunk(chunk_index).next;
+            queue_chunks_.destroy(chunk_index);
+            chunk_index = next;
+        }
+    }
+    
+    void on_level_changed(bool is_buy, double price, uint64_t total_quantity, LevelAction action) {
+        version_++;
+        if (level_deltas_.enabled()) {
+            level_deltas_.push(is_buy, price, total_quantity, action);
+        }
+        
+        SideDepthCache& cache = is_buy ? bid_depth_ : ask_depth_;
+        if (cache.stale) return;
+        
+        if (action != LevelAction::Change) {
+            // Only levels at or inside the cached window can change its contents
+            bool inside = cache.count < DepthSnapshot::max_depth ||
+                          (is_buy ? price >= cache.levels[cache.count - 1].price
+                                  : price <= cache.levels[cache.count - 1].price);
+            cache.stale = inside;
+            return;
+        }
+        for (size_t i = 0; i < cache.count; ++i) {
+            if (cache.levels[i].price == price) {
+                cache.levels[i].total_quantity = total_quantity;
+                return;
+            }
+        }
+    }
+    
+    // Writes up to `depth` best levels of one side into `out`, returns the count
+    size_t collect_levels(bool is_buy, size_t depth, PriceLevel* out) const {
+        size_t count = 0;
+        for_each_level(is_buy, [&](double price, const PriceLevelData& level) {
+            if (count == depth) return false;
+            out[count++] = PriceLevel(price, level.total_quantity);
+            return true;
+        });
+        return count;
+    }
+    
+    void append_levels(bool is_buy, size_t depth, std::vector<PriceLevel>& out) const {
+        for_each_level(is_buy, [&](double price, const PriceLevelData& level) {
+            if (out.size() == depth) return false;
+            out.push_back(PriceLevel(price, level.total_quantity));
+            return true;
+        });
+    }
+    
+    // Calls fn(price, level) for the levels of one side, best first, until it returns false
+    template<typename Fn>
+    void for_each_level(bool is_buy, Fn&& fn) const {
+        with_side(is_buy, [&](const auto& side) {
+            side.for_each([&](auto key, const PriceLevelData& level) { return fn(key_price(key), level); });
+        });
+    }
+    
+    const SideDepthCache& depth_cache(bool is_buy) const {
+        SideDepthCache& cache = is_buy ? bid_depth_ : ask_depth_;
+        if (cache.stale) {
+            cache.count = collect_levels(is_buy, DepthSnapshot::max_depth, cache.levels);
+            cache.stale = false;
+        }
+        return cache;
+    }
+    
+    // Dispatch to the map or ladder representation of the given side
+    void add_order_to_book(const Order& order) {
+        with_side(order.is_buy, [&](auto& side) { add_order_to_side(order, side); });
+    }
+    
+    bool remove_order_from_book(uint64_t order_id, bool is_buy) {
+        return with_side(is_buy, [&](auto& side) { return remove_order_from_side(order_id, side); });
+    }
+    
+    // Rolls back a failed load_image() by removing the orders it added
+    void unload_image_orders(const std::byte* begin, const std::byte* end) {
+        for (const std::byte* p = begin; p < end; p += sizeof(BookImageOrder)) {
+            uint64_t order_id;
+            std::memcpy(&order_id, p + offsetof(BookImageOrder, order_id), sizeof(order_id));
+            if (uint32_t index = order_lookup_.find(order_id)) {
+                remove_order_from_book(order_id, orders_.node(index).is_buy);
+            }
+        }
+    }
+    
+    // Trades the orders at the front of the best bid and the best ask
+    template<typename Bids, typename Asks>
+    void execute_trade(Bids& bids, Asks& asks) {
+        PROBE_SCOPE("execute_trade");
+        PriceLevelData& buy_level = bids.best_level();
+        PriceLevelData& sell_level = asks.best_level();
+        uint32_t buy_index = front(buy_level);
+        uint32_t sell_index = front(sell_level);
+        prefetch_queue(buy_level);
+        prefetch_queue(sell_level);
+        OrderNode& buy_order = orders_.node(buy_index);
+        OrderNode& sell_order = orders_.node(sell_index);
+        uint64_t trade_quantity = std::min(buy_order.quantity, sell_order.quantity);
+        double trade_price = std::min(buy_level.price, sell_level.price);
+        
+        total_trades_++;
+        trade_sink().on_trade(TradeEvent{total_trades_, buy_order.order_id,
+                                         sell_order.order_id, trade_price, trade_quantity, true});
+        
+        total_volume_ += trade_quantity;
+        
+        // Update quantities
+        buy_order.quantity -= trade_quantity;
+        sell_order.quantity -= trade_quantity;
+        
+        // Update price level quantities; a level emptied by the fill is
+        // reported once, as a Delete, on removal below
+        buy_level.total_quantity -= trade_quantity;
+        if (buy_level.total_quantity > 0) {
+            on_level_changed(true, buy_level.price, buy_level.total_quantity, LevelAction::Change);
+        }
+        sell_level.total_quantity -= trade_quantity;
+        if (sell_level.total_quantity > 0) {
+            on_level_changed(false, sell_level.price, sell_level.total_quantity, LevelAction::Change);
+        }
+        
+        // Remove fully filled orders
+        if (buy_order.quantity == 0) {
+            erase_order(bids, buy_index);
+        }
+        if (sell_order.quantity == 0) {
+            erase_order(asks, sell_index);
+        }
+    }
+    
+    template<typename Bids, typename Asks>
+    void match_crossed(Bids& bids, Asks& asks) {
+        while (!bids.empty() && !asks.empty() && bids.best_key() >= asks.best_key()) {
+            execute_trade(bids, asks);
+        }
+    }
+    
+    void process_matching() {
+        PROBE_SCOPE("process_matching");
+        with_sides([this](auto& bids, auto& asks) { match_crossed(bids, asks); });
+        publish_snapshot();
+    }
+    
+    // Pushes the top of book to the seqlock after a matching pass that changed it
+    void publish_snapshot() {
+        if (!snapshot_target_ || published_version_ == version_) return;
+        DepthSnapshot depth;
+        get_depth(depth);
+        snapshot_target_->store(depth);
+        published_version_ = version_;
+    }
+    
+
+public:
+    // Every container of the book (level maps or ladders, id index, node slabs,
+    // delta ring) allocates from `resource`, which must outlive the book
+    // Map mode with the runtime grid; with a static grid, the compiled-in ladder
+    explicit BasicOrderBook(const TradeSink& sink = TradeSink{},
+                            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : TradeSink(sink), bids_(resource), asks_(resource), bid_ladder_(grid_.num_ticks(), resource),
+          ask_ladder_(grid_.num_ticks(), resource), version_(0), level_deltas_(0, resource),
+          order_lookup_(16, resource), orders_(resource), queue_layout_(QueueLayout::Linked),
+          queue_chunks_(resource), total_trades_(0), total_volume_(0) {}
+    
+    // Integer-tick mode: levels live in contiguous arrays indexed by tick offset
+    explicit BasicOrderBook(const TickLadderConfig& config, const TradeSink& sink = TradeSink{},
+                            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        requires(!Grid::fixed)
+        : TradeSink(sink), bids_(resource), asks_(resource), grid_(config), bid_ladder_(grid_.num_ticks(), resource),
+          ask_ladder_(grid_.num_ticks(), resource), version_(0), level_deltas_(0, resource),
+          order_lookup_(16, resource), orders_(resource), queue_layout_(QueueLayout::Linked),
+          queue_chunks_(resource), total_trades_(0), total_volume_(0) {}
+    
+    // Pre-size node storage and the id index so the first `order_capacity`
+    // resting orders never allocate
+    void reserve_orders(size_t order_capacity) {
+        orders_.reserve(order_capacity);
+        order_lookup_.reserve(order_capacity);
+        if (queue_layout_ == QueueLayout::Ring) {
+            queue_chunks_.reserve(queue_chunks_for(order_capacity));
+        }
+    }
+    
+    // Picks how levels queue their orders; only while the book is empty
+    void set_queue_layout(QueueLayout layout) {
+        if (!order_lookup_.empty()) {
+            throw std::runtime_error("Queue layout can only change on an empty book");
+        }
+        queue_layout_ = layout;
+        if (layout == QueueLayout::Ring) {
+            queue_chunks_.reserve(queue_chunks_for(orders_.capacity()));
+        }
+    }
+    
+    QueueLayout queue_layout() const { return queue_layout_; }
+    
+    // Core interface. With matching, this is submit_order() for a Limit order;
+    // without, the order is added as is, even if it crosses the book.
+    void add_order(const Order& order, bool match_immediately = true) {
+        if (match_immediately) {
+            submit_order(order, OrderType::Limit);
+            return;
+        }
+        add_order_to_book(prepare_order(order, OrderType::Limit));
+    }
+    
+    // Matches an incoming order against the book before anything is stored:
+    // only a Limit order's unfilled rest is added, so aggressive flow never
+    // pays for an insert and erase. Throws on invalid orders, like add_order.
+    ExecutionReport submit_order(const Order& order, OrderType type = OrderType::Limit) {
+        PROBE_SCOPE("submit_order");
+        Order incoming = prepare_order(order, type);
+        uint64_t trades_before = total_trades_;
+        
+        // Orders added without matching may have left the book crossed; they came first
+        with_sides([this](auto& bids, auto& asks) { match_crossed(bids, asks); });
+        
+        bool market = type == OrderType::Market;
+        uint64_t remaining = with_side(!incoming.is_buy, [&](auto& resting) {
+            auto limit = market ? decltype(resting.best_key()){} : level_key(resting, incoming.price);
+            if (type == OrderType::FOK && !can_fill(resting, market, limit, incoming.quantity)) {
+                return incoming.quantity;
+            }
+            return match_incoming(incoming, market, limit, resting);
+        });
+        
+        ExecutionReport report{incoming.quantity - remaining, 0, 0, 0};
+        if (remaining > 0 && type == OrderType::Limit) {
+            incoming.quantity = remaining;
+            add_order_to_book(incoming);
+            report.rested_quantity = remaining;
+        } else {
+            report.cancelled_quantity = remaining;
+        }
+        report.trades = total_trades_ - trades_before;
+        publish_snapshot();
+        return report;
+    }
+    
+    // Applies every command in order without matching, then runs one matching
+    // pass for the whole batch. Invalid commands are rejected without throwing;
+    // if `statuses` is non-empty it receives one status per command.
+    BatchResult apply_batch(std::span<const OrderCommand> commands, std::span<CommandStatus> statuses = {}) {
+        assert(statuses.empty() || statuses.size() == commands.size());
+        
+        BatchResult result{0, 0, 0, 0};
+        uint64_t trades_before = total_trades_;
+        uint64_t volume_before = total_volume_;
+        uint64_t timestamp = 0;
+        
+        for (size_t i = 0; i < commands.size(); ++i) {
+            CommandStatus status = apply_command(commands[i], timestamp);
+            if (status == CommandStatus::Accepted) {
+                result.accepted++;
+            } else {
+                result.rejected++;
+            }
+            if (!statuses.empty()) statuses[i] = status;
+        }
+        
+        process_matching();
+        result.trades = total_trades_ - trades_before;
+        result.volume = total_volume_ - volume_before;
+        return result;
+    }
+    
+    bool cancel_order(uint64_t order_id) {
+        uint32_t index = order_lookup_.find(order_id);
+        if (index == OrderStore::nil) {
+            return false;
+        }
+        
+        return remove_order_from_book(order_id, orders_.node(index).is_buy);
+    }
+    
+    bool amend_order(uint64_t order_id, double new_price, uint64_t new_quantity, bool match_immediately = true) {
+        uint32_t index = order_lookup_.find(order_id);
+        if (index == OrderStore::nil) {
+            return false;
+        }
+        
+        if (new_quantity == 0) {
+            throw std::runtime_error("New quantity cannot be zero");
+        }
+        
+        if (new_price <= 0.0) {
+            throw std::runtime_error("Invalid new price: " + std::to_string(new_price));
+        }
+        
+        if (grid_.use_ladder()) {
+            // Reject off-grid prices before touching the book, and snap to the grid
+            new_price = tick_to_price(price_to_tick(new_price));
+        }
+        
+        OrderNode& node = orders_.node(index);
+        PriceLevelData& level = *node.level;
+        bool price_changed = std::abs(level.price - new_price) > 1e-12;
+        
+        if (!price_changed && new_quantity <= node.quantity) {
+            // Reducing quantity keeps the order's place in the queue
+            level.total_quantity -= node.quantity - new_quantity;
+            node.quantity = new_quantity;
+            on_level_changed(node.is_buy, level.price, level.total_quantity, LevelAction::Change);
+        } else {
+            // A new price or a larger quantity goes to the back of the queue.
+            // The order is relinked, not reallocated, and trades first if the
+            // new price crosses.
+            bool is_buy = node.is_buy;
+            with_side(is_buy, [&](auto& side) { detach_order(side, index); });
+            
+            uint64_t remaining = new_quantity;
+            if (match_immediately) {
+                Order incoming{order_id, is_buy, new_price, new_quantity, 0};
+                remaining = with_side(!is_buy, [&](auto& resting) {
+                    return match_incoming(incoming, false, level_key(resting, new_price), resting);
+                });
+            }
+            if (remaining > 0) {
+                node.quantity = remaining;
+                with_side(is_buy, [&](auto& side) { attach_order(side, level_key(side, new_price), new_price, index); });
+            } else {
+                order_lookup_.erase(order_id);
+                orders_.destroy(index);
+            }
+        }
+        
+        // Try to match after amendment
+        if (match_immediately) {
+            process_matching();
+        }
+        return true;
+    }
+    
+    void get_snapshot(size_t depth, std::vector<PriceLevel>& bids, std::vector<PriceLevel>& asks) const {
+        bids.clear();
+        asks.clear();
+        
+        if (depth <= DepthSnapshot::max_depth) {
+            const SideDepthCache& bid_cache = depth_cache(true);
+            const SideDepthCache& ask_cache = depth_cache(false);
+            bids.assign(bid_cache.levels, bid_cache.levels + std::min(depth, bid_cache.count));
+            asks.assign(ask_cache.levels, ask_cache.levels + std::min(depth, ask_cache.count));
+            return;
+        }
+        
+        append_levels(true, depth, bids);
+        append_levels(false, depth, asks);
+    }
+    
+    // Copies the cached top levels into `out` unless the book is still at
+    // `known_version`. Returns false (leaving `out` untouched) when unchanged.
+    bool get_depth(DepthSnapshot& out, uint64_t known_version = UINT64_MAX) const {
+        if (known_version == version_) return false;
+        
+        const SideDepthCache& bid_cache = depth_cache(true);
+        const SideDepthCache& ask_cache = depth_cache(false);
+        std::memcpy(out.bids, bid_cache.levels, sizeof(out.bids));
+        std::memcpy(out.asks, ask_cache.levels, sizeof(out.asks));
+        out.bid_count = bid_cache.count;
+        out.ask_count = ask_cache.count;
+        out.version = version_;
+        return true;
+    }
+    
+    uint64_t get_version() const { return version_; }
+    
+    // The top of book as a shared immutable snapshot. Calls at the same
+    // version return the same object, so readers fanned out from one update
+    // share one copy and the book allocates once per change, not per reader.
+    IntrusivePtr<const SharedDepth> share_depth() const {
+        if (!shared_depth_ || shared_depth_->depth.version != version_) {
+            SharedDepth* fresh = small_new<SharedDepth>();
+            get_depth(fresh->depth);
+            shared_depth_ = IntrusivePtr<const SharedDepth>(fresh);
+        }
+        return shared_depth_;
+    }
+    
+    // Publishes a DepthSnapshot into `target` after every matching pass that
+    // changed the book. Readers on other threads load it without locking.
+    void set_snapshot_publisher(SeqLock<DepthSnapshot>* target) {
+        snapshot_target_ = target;
+        published_version_ = UINT64_MAX;
+        publish_snapshot();
+    }
+    
+    // Starts publishing market-by-price deltas into a ring of `capacity` entries
+    void enable_level_deltas(size_t capacity) { level_deltas_ = LevelDeltaRing(capacity, memory_resource()); }
+    const LevelDeltaRing& level_deltas() const { return level_deltas_; }
+    
+    void print_book(size_t depth = 10) const {
+        std::vector<PriceLevel> bids, asks;
+        get_snapshot(depth, bids, asks);
+        
+        std::cout << "\n=== ORDER BOOK (Top " << depth << ") ===" << std::endl;
+        std::cout << std::setw(12) << "BID QTY" << " | " << std::setw(10) << "PRICE" 
+                  << " || " << std::setw(10) << "PRICE" << " | " << std::setw(12) << "ASK QTY" << std::endl;
+        std::cout << std::string(60, '-') << std::endl;
+        
+        size_t max_levels = std::max(bids.size(), asks.size());
+        
+        for (size_t i = 0; i < max_levels; ++i) {
+            if (i < bids.size()) {
+                std::cout << std::setw(12) << bids[i].total_quantity << " | " 
+                          << std::setw(10) << std::fixed << std::setprecision(4) << bids[i].price;
+            } else {
+                std::cout << std::setw(12) << " " << " | " << std::setw(10) << " ";
+            }
+            
+            std::cout << " || ";
+            
+            if (i < asks.size()) {
+                std::cout << std::setw(10) << std::fixed << std::setprecision(4) << asks[i].price << " | " 
+                          << std::setw(12) << asks[i].total_quantity;
+            } else {
+                std::cout << std::setw(10) << " " << " | " << std::setw(12) << " ";
+            }
+            std::cout << std::endl;
+        }
+        
+        std::cout << "Total Orders: " << get_total_orders() 
+                  << " (Bids: " << get_bid_levels() << " levels, "
+                  << "Asks: " << get_ask_levels() << " levels)" << std::endl;
+        std::cout << "Trades: " << total_trades_ << ", Volume: " << total_volume_ << std::endl;
+    }
+    
+    // Additional utility methods
+    size_t get_total_orders() const { return order_lookup_.size(); }
+    size_t get_order_capacity() const { return orders_.capacity(); }
+    size_t get_bid_levels() const { return grid_.use_ladder() ? bid_ladder_.size() : bids_.size(); }
+    size_t get_ask_levels() const { return grid_.use_ladder() ? ask_ladder_.size() : asks_.size(); }
+    bool order_exists(uint64_t order_id) const { 
+        return order_lookup_.contains(order_id); 
+    }
+    double get_best_bid() const { 
+        const SideDepthCache& cache = depth_cache(true);
+        return cache.count == 0 ? 0.0 : cache.levels[0].price; 
+    }
+    double get_best_ask() const { 
+        const SideDepthCache& cache = depth_cache(false);
+        return cache.count == 0 ? 0.0 : cache.levels[0].price; 
+    }
+    bool is_ladder_mode() const { return grid_.use_ladder(); }
+    double get_spread() const {
+        return get_best_ask() - get_best_bid();
+    }
+    
+    void get_statistics(uint64_t& trades, uint64_t& volume, size_t& active_orders) const {
+        trades = total_trades_;
+        volume = total_volume_;
+        active_orders = order_lookup_.size();
+    }
+    
+    // Copies the resting state of an order; false if it is not in the book
+    bool get_order(uint64_t order_id, Order& out) const {
+        uint32_t index = order_lookup_.find(order_id);
+        if (index == OrderStore::nil) return false;
+        out = orders_.to_order(index);
+        return true;
+    }
+    
+    size_t image_size() const {
+        size_t levels = get_bid_levels() + get_ask_levels();
+        return sizeof(BookImageHeader) + levels * sizeof(BookImageLevel) + order_lookup_.size() * sizeof(BookImageOrder);
+    }
+    
+    // Replaces `out` with an image of the resting book; `sequence` is the last
+    // journal record applied to it
+    void save_image(std::vector<std::byte>& out, uint64_t sequence = 0) const {
+        out.resize(image_size());
+        auto* header = reinterpret_cast<BookImageHeader*>(out.data());
+        auto* level_out = reinterpret_cast<BookImageLevel*>(header + 1);
+        auto* order_out = reinterpret_cast<BookImageOrder*>(level_out + get_bid_levels() + get_ask_levels());
+        
+        *header = BookImageHeader{};
+        std::memcpy(header->magic, book_image_magic, sizeof(header->magic));
+        header->version = book_image_version;
+        header->ladder = grid_.use_ladder() ? 1 : 0;
+        header->tick_size = grid_.tick_size();
+        header->min_tick = grid_.min_tick();
+        header->num_ticks = grid_.num_ticks();
+        header->sequence = sequence;
+        header->book_version = version_;
+        header->total_trades = total_trades_;
+        header->total_volume = total_volume_;
+        header->bid_levels = get_bid_levels();
+        header->ask_levels = get_ask_levels();
+        header->orders = order_lookup_.size();
+        
+        for (bool is_buy : {true, false}) {
+            for_each_level(is_buy, [&](double price, const PriceLevelData& level) {
+                for_each_queued(level, [&](uint32_t index) {
+                    const OrderNode& node = orders_.node(index);
+                    *order_out++ = BookImageOrder{node.order_id, node.quantity, orders_.timestamp(index)};
+                });
+                *level_out++ = BookImageLevel{price, level.total_quantity, level.orders};
+                return true;
+            });
+        }
+    }
+    
+    std::vector<std::byte> save_image(uint64_t sequence = 0) const {
+        std::vector<std::byte> out;
+        save_image(out, sequence);
+        return out;
+    }
+    
+    // Rebuilds an empty book from an image and returns its journal sequence.
+    // The image is validated first; a book that rejects it is left empty.
+    uint64_t load_image(std::span<const std::byte> image) {
+        if (!order_lookup_.empty()) {
+            throw std::runtime_error("Book image can only be loaded into an empty book");
+        }
+        if (image.size() < sizeof(BookImageHeader)) {
+            throw std::runtime_error("Book image is truncated");
+        }
+        BookImageHeader header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (std::memcmp(header.magic, book_image_magic, sizeof(header.magic)) != 0 ||
+            header.version != book_image_version) {
+            throw std::runtime_error("Book image has an unknown format");
+        }
+        if ((header.ladder != 0) != grid_.use_ladder() ||
+            (grid_.use_ladder() && (header.tick_size != grid_.tick_size() || header.min_tick != grid_.min_tick() ||
+                             header.num_ticks != grid_.num_ticks()))) {
+            throw std::runtime_error("Book image was written by a book with another price layout");
+        }
+        uint64_t levels = header.bid_levels + header.ask_levels;
+        if (levels > image.size() / sizeof(BookImageLevel) || header.orders > image.size() / sizeof(BookImageOrder) ||
+            image.size() != sizeof(BookImageHeader) + levels * sizeof(BookImageLevel) +
+                            header.orders * sizeof(BookImageOrder)) {
+            throw std::runtime_error("Book image size does not match its header");
+        }
+        
+        // Records are copied out one at a time, so the image needs no alignment
+        const std::byte* level_in = image.data() + sizeof(BookImageHeader);
+        const std::byte* order_in = level_in + levels * sizeof(BookImageLevel);
+        uint64_t assigned = 0;
+        for (uint64_t i = 0; i < levels; ++i) {
+            BookImageLevel level;
+            std::memcpy(&level, level_in + i * sizeof(level), sizeof(level));
+            uint64_t quantity = 0;
+            for (uint64_t j = 0; j < level.order_count && assigned + j < header.orders; ++j) {
+                BookImageOrder order;
+                std::memcpy(&order, order_in + (assigned + j) * sizeof(order), sizeof(order));
+                if (order.quantity == 0) throw std::runtime_error("Book image holds an empty order");
+                quantity += order.quantity;
+            }
+            if (level.order_count == 0 || level.order_count > header.orders - assigned ||
+                quantity != level.total_quantity || !is_valid_price(level.price)) {
+                throw std::runtime_error("Book image level " + std::to_string(i) + " is corrupt");
+            }
+            assigned += level.order_count;
+        }
+        if (assigned != header.orders) {
+            throw std::runtime_error("Book image orders do not match its levels");
+        }
+        
+        reserve_orders(header.orders);
+        const std::byte* next_order = order_in;
+        for (uint64_t i = 0; i < levels; ++i) {
+            BookImageLevel level;
+            std::memcpy(&level, level_in + i * sizeof(level), sizeof(level));
+            bool is_buy = i < header.bid_levels;
+            for (uint64_t j = 0; j < level.order_count; ++j, next_order += sizeof(BookImageOrder)) {
+                BookImageOrder order;
+                std::memcpy(&order, next_order, sizeof(order));
+                if (order_lookup_.contains(order.order_id)) {
+                    unload_image_orders(order_in, next_order);
+                    throw std::runtime_error("Book image repeats order ID " + std::to_string(order.order_id));
+                }
+                add_order_to_book(Order{order.order_id, is_buy, level.price, order.quantity, order.timestamp_ns});
+            }
+        }
+        version_ = std::max(version_, header.book_version);
+        total_trades_ = header.total_trades;
+        total_volume_ = header.total_volume;
+        return header.sequence;
+    }
+    
+    void print_order(uint64_t order_id) const {
+        uint32_t index = order_lookup_.find(order_id);
+        if (index == OrderStore::nil) {
+            std::cout << "Order " << order_id << " not found" << std::endl;
+            return;
+        }
+        
+        Order order = orders_.to_order(index);
+        std::cout << "Order " << order_id << ": " 
+                  << (order.is_buy ? "BUY" : "SELL") 
+                  << " " << order.quantity << " @ " << order.price 
+                  << " (TS: " << order.timestamp_ns << ")" << std::endl;
+    }
+    
+    std::pmr::memory_resource* memory_resource() const { return bids_.resource(); }
+    
+    TradeSink& trade_sink() { return *this; }
+    const TradeSink& trade_sink() const { return *this; }
+    
+    // Manual matching control
+    void match_orders() {
+        process_matching();
+    }
+};
+
+using OrderBook = BasicOrderBook<>;
@@ -0,0 +1,345 @@
+// Per-operation latency benchmark for OrderBook.
+// Every operation is timed individually with the TSC and reported as
+// p50 / p99 / p99.9 / max in nanoseconds after an untimed warm-up.
+// Hardware counters (cycles, instructions, L1d/LLC/branch/dTLB misses) run
+// over each case's timed phase and are printed per operation; they include
+// the harness's own random numbers and bookkeeping, but not the untimed
+// setup of the sweep and deep-queue cases. They show n/a where the kernel
+// or CPU does not provide them.
+//
+//   g++ -std=c++20 -O2 -pthread order_book_bench.cpp -o order_book_bench
+//   ./order_book_bench [iterations]
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+
+#include "order_book.hpp"
+#include "latency.hpp"
+#include "perf_counters.hpp"
+
+namespace {
+
+// Deterministic generator so every run replays the same message stream
+struct Lcg {
+    uint64_t state;
+    uint64_t next() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state >> 33;
+    }
+};
+
+// Times `op(i)` for i in [0, iterations) after `warmup` untimed calls
+// The op records its own sample when `timed` is set; the counters run over
+// the timed calls only, formatted per operation in the result
+template<typename Op>
+std::string measure(PerfCounters& counters, size_t warmup, size_t iterations, Op&& op) {
+    for (size_t i = 0; i < warmup; ++i) {
+        op(i, false);
+    }
+    counters.start();
+    for (size_t i = 0; i < iterations; ++i) {
+        op(warmup + i, true);
+    }
+    return perf_per_op(counters.stop(), iterations);
+}
+
+double price_of(const OrderBook& book, uint64_t order_id) {
+    Order order{};
+    book.get_order(order_id, order);
+    return order.price;
+}
+
+struct BenchContext {
+    std::string mode;
+    std::function<std::unique_ptr<OrderBook>()> make_book;
+    double cycles_per_ns;
+    uint64_t overhead;
+    size_t iterations;
+    PerfCounters* counters;
+};
+
+constexpr double MID = 100.0;
+constexpr double TICK = 0.01;
+
+double bid_price(uint64_t r) { return MID - TICK * static_cast<double>(1 + r % 200); }
+double ask_price(uint64_t r) { return MID + TICK * static_cast<double>(1 + r % 200); }
+
+// Resting book around the touch: `orders` passive orders spread over 200 ticks each side
+void populate(OrderBook& book, uint64_t& next_id, size_t orders, Lcg& rng) {
+    for (size_t i = 0; i < orders; ++i) {
+        bool is_buy = (i & 1) == 0;
+        double price = is_buy ? bid_price(rng.next()) : ask_price(rng.next());
+        book.add_order(Order{next_id++, is_buy, price, 1 + rng.next() % 100, 1}, false);
+    }
+}
+
+void bench_add(const BenchContext& ctx, LatencyStats& stats) {
+    auto book = ctx.make_book();
+    Lcg rng{1};
+    uint64_t next_id = 1;
+    populate(*book, next_id, 10000, rng);
+    book->reserve_orders(10000 + 2 * ctx.iterations);
+
+    std::string counts = measure(*ctx.counters, ctx.iterations / 10, ctx.iterations, [&](size_t i, bool timed) {
+        bool is_buy = (i & 1) == 0;
+        Order order{next_id++, is_buy, is_buy ? bid_price(rng.next()) : ask_price(rng.next()), 10, 1};
+        uint64_t start = read_cycles();
+        book->add_order(order);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+    });
+    stats.report("add (passive)", ctx.cycles_per_ns, ctx.overhead, counts);
+}
+
+void bench_cancel(const BenchContext& ctx, LatencyStats& stats) {
+    auto book = ctx.make_book();
+    Lcg rng{2};
+    uint64_t next_id = 1;
+    size_t total = ctx.iterations + ctx.iterations / 10 + 10000;
+    populate(*book, next_id, total, rng);
+
+    // Cancel in a shuffled order so the id index and levels are hit randomly
+    std::vector<uint64_t> ids(total);
+    for (size_t i = 0; i < total; ++i) ids[i] = i + 1;
+    for (size_t i = total - 1; i > 0; --i) std::swap(ids[i], ids[rng.next() % (i + 1)]);
+
+    std::string counts = measure(*ctx.counters, ctx.iterations / 10, ctx.iterations, [&](size_t i, bool timed) {
+        uint64_t start = read_cycles();
+        book->cancel_order(ids[i]);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+    });
+    stats.report("cancel", ctx.cycles_per_ns, ctx.overhead, counts);
+}
+
+void bench_amend(const BenchContext& ctx, LatencyStats& stats, bool change_price) {
+    auto book = ctx.make_book();
+    Lcg rng{3};
+    uint64_t next_id = 1;
+    size_t total = 20000;
+    // Amends keep each order on its own side: all resting ids are known buys below the touch
+    for (size_t i = 0; i < total; ++i) {
+        book->add_order(Order{next_id++, true, bid_price(rng.next()), 1000, 1}, false);
+    }
+
+    std::string counts = measure(*ctx.counters, ctx.iterations / 10, ctx.iterations, [&](size_t i, bool timed) {
+        uint64_t id = 1 + rng.next() % total;
+        double price = change_price ? bid_price(rng.next()) : 0.0;
+        if (!change_price) price = price_of(*book, id);  // Quantity-only amends keep the price
+        uint64_t quantity = 1 + (1000 - i % 1000);
+        uint64_t start = read_cycles();
+        book->amend_order(id, price, quantity);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+    });
+    stats.report(change_price ? "amend (price)" : "amend (quantity)", ctx.cycles_per_ns, ctx.overhead, counts);
+}
+
+void bench_sweep(const BenchContext& ctx, LatencyStats& stats, size_t levels) {
+    auto book = ctx.make_book();
+    uint64_t next_id = 1;
+    size_t iterations = ctx.iterations / 10;
+
+    std::string counts = measure(*ctx.counters, iterations / 10, iterations, [&](size_t, bool timed) {
+        // Untimed: lay `levels` asks of 2 orders each above the mid
+        if (timed) ctx.counters->pause();
+        for (size_t level = 0; level < levels; ++level) {
+            double price = MID + TICK * static_cast<double>(level + 1);
+            book->add_order(Order{next_id++, false, price, 50, 1}, false);
+            book->add_order(Order{next_id++, false, price, 50, 1}, false);
+        }
+        Order sweep{next_id++, true, MID + TICK * static_cast<double>(levels), 100 * levels, 1};
+        if (timed) ctx.counters->resume();
+        uint64_t start = read_cycles();
+        book->add_order(sweep);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+    });
+    stats.report("sweep " + std::to_string(levels) + " levels", ctx.cycles_per_ns, ctx.overhead, counts);
+}
+
+// Four popular asks 15000 orders deep, with cancels scattered through
+// the queues and freed nodes reused all over the store; each aggressive order
+// fills 20 resting orders from the front of the best level
+void bench_deep_queue(const BenchContext& ctx, LatencyStats& stats) {
+    auto book = ctx.make_book();
+    Lcg rng{6};
+    uint64_t next_id = 1;
+    auto add_ask = [&] {
+        book->add_order(Order{next_id++, false, MID + TICK * static_cast<double>(1 + rng.next() % 4), 10, 1}, false);
+    };
+    for (size_t i = 0; i < 100000; ++i) add_ask();
+    for (size_t i = 0; i < 40000; ++i) book->cancel_order(1 + rng.next() % (next_id - 1));
+
+    size_t iterations = ctx.iterations / 10;
+    std::string counts = measure(*ctx.counters, iterations / 10, iterations, [&](size_t, bool timed) {
+        Order sweep{next_id++, true, MID + 4 * TICK, 200, 1};
+        uint64_t start = read_cycles();
+        book->add_order(sweep);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+        // Untimed: put back what was filled, and cancel as much again
+        if (timed) ctx.counters->pause();
+        for (size_t i = 0; i < 20; ++i) {
+            add_ask();
+            book->cancel_order(1 + rng.next() % (next_id - 1));
+            add_ask();
+        }
+        if (timed) ctx.counters->resume();
+    });
+    stats.report("deep queue: fill 20", ctx.cycles_per_ns, ctx.overhead, counts);
+}
+
+void bench_snapshot(const BenchContext& ctx, LatencyStats& stats) {
+    auto book = ctx.make_book();
+    Lcg rng{4};
+    uint64_t next_id = 1;
+    populate(*book, next_id, 10000, rng);
+    std::vector<PriceLevel> bids, asks;
+    bids.reserve(64);
+    asks.reserve(64);
+
+    // Alternate a book update with the read, as a strategy polling after every update would
+    std::string counts = measure(*ctx.counters, ctx.iterations / 10, ctx.iterations, [&](size_t i, bool timed) {
+        bool is_buy = (i & 1) == 0;
+        book->add_order(Order{next_id++, is_buy, is_buy ? bid_price(rng.next()) : ask_price(rng.next()), 10, 1}, false);
+        uint64_t start = read_cycles();
+        book->get_snapshot(10, bids, asks);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+    });
+    stats.report("snapshot depth 10", ctx.cycles_per_ns, ctx.overhead, counts);
+
+    DepthSnapshot depth;
+    counts = measure(*ctx.counters, ctx.iterations / 10, ctx.iterations, [&](size_t i, bool timed) {
+        bool is_buy = (i & 1) == 0;
+        book->add_order(Order{next_id++, is_buy, is_buy ? bid_price(rng.next()) : ask_price(rng.next()), 10, 1}, false);
+        uint64_t start = read_cycles();
+        book->get_depth(depth);
+        uint64_t end = read_cycles();
+        if (timed) stats.record(end - start);
+    });
+    stats.report("get_depth (cached)", ctx.cycles_per_ns, ctx.overhead, counts);
+}
+
+// Replays a realistic mix: 45% add, 40% cancel, 10% amend, 5% aggressive
+void bench_mix(const BenchContext& ctx, LatencyStats& stats) {
+    auto book = ctx.make_book();
+    Lcg rng{5};
+    uint64_t next_id = 1;
+    populate(*book, next_id, 10000, rng);
+
+    // Ids of resting orders, so cancels and amends mostly hit live orders
+    std::vector<uint64_t> live;
+    live.reserve(10000 + ctx.iterations);
+    for (uint64_t id = 1; id < next_id; ++id) live.push_back(id);
+
+    LatencyStats add_stats(ctx.iterations), cancel_stats(ctx.iterations), amend_stats(ctx.iterations),
+        aggressive_stats(ctx.iterations);
+    std::string counts = measure(*ctx.counters, ctx.iterations / 10, ctx.iterations, [&](size_t, bool timed) {
+        uint64_t action = rng.next() % 100;
+        uint64_t start = 0, end = 0;
+        LatencyStats* bucket = &add_stats;
+        if (action < 45 || live.empty()) {
+            bool is_buy = rng.next() % 2 == 0;
+            Order order{next_id++, is_buy, is_buy ? bid_price(rng.next()) : ask_price(rng.next()), 1 + rng.next() % 100, 1};
+            start = read_cycles();
+            book->add_order(order);
+            end = read_cycles();
+            live.push_back(order.order_id);
+        } else if (action < 85) {
+            size_t slot = rng.next() % live.size();
+            uint64_t id = live[slot];
+            live[slot] = live.back();
+            live.pop_back();
+            start = read_cycles();
+            book->cancel_order(id);
+            end = read_cycles();
+            bucket = &cancel_stats;
+        } else if (action < 95) {
+            uint64_t id = live[rng.next() % live.size()];
+            if (!book->order_exists(id)) return;
+            uint64_t quantity = 1 + rng.next() % 100;
+            double price = price_of(*book, id);
+            start = read_cycles();
+            book->amend_order(id, price, quantity);
+            end = read_cycles();
+            bucket = &amend_stats;
+        } else {
+            bool is_buy = rng.next() % 2 == 0;
+            Order order{next_id++, is_buy, is_buy ? MID + 5 * TICK : MID - 5 * TICK, 200, 1};
+            start = read_cycles();
+            book->add_order(order);
+            end = read_cycles();
+            live.push_back(order.order_id);
+            bucket = &aggressive_stats;
+        }
+        if (timed) {
+            bucket->record(end - start);
+            stats.record(end - start);
+        }
+    });
+    stats.report("mix: all messages", ctx.cycles_per_ns, ctx.overhead, counts);
+    add_stats.report("mix: add", ctx.cycles_per_ns, ctx.overhead);
+    cancel_stats.report("mix: cancel", ctx.cycles_per_ns, ctx.overhead);
+    amend_stats.report("mix: amend", ctx.cycles_per_ns, ctx.overhead);
+    aggressive_stats.report("mix: aggressive", ctx.cycles_per_ns, ctx.overhead);
+}
+
+void run_suite(const BenchContext& ctx) {
+    std::cout << "\n=== " << ctx.mode << " ===" << std::endl;
+    std::cout << std::left << std::setw(34) << "operation" << std::right
+              << std::setw(9) << "count" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(12) << "max (ns)" << perf_header() << "  (per op)"
+              << std::endl;
+
+    LatencyStats stats(ctx.iterations);
+    bench_add(ctx, stats);
+    bench_cancel(ctx, stats);
+    bench_amend(ctx, stats, false);
+    bench_amend(ctx, stats, true);
+    for (size_t levels : {1, 5, 10, 50}) {
+        bench_sweep(ctx, stats, levels);
+    }
+    bench_deep_queue(ctx, stats);
+    bench_snapshot(ctx, stats);
+    bench_mix(ctx, stats);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    double cycles_per_ns = calibrate_cycles_per_ns();
+    uint64_t overhead = timer_overhead_cycles();
+    std::cout << "=== ORDER BOOK LATENCY BENCHMARK ===" << std::endl;
+    report_clock(std::cout);
+    PerfCounters counters;
+    if (!counters.available()) {
+        std::cout << "Hardware counters unavailable (no PMU or perf_event_paranoid), shown as n/a" << std::endl;
+    }
+    std::cout << "Timer overhead " << overhead << " cycles (subtracted), " << iterations << " iterations per case"
+              << std::endl;
+
+    for (QueueLayout layout : {QueueLayout::Linked, QueueLayout::Ring}) {
+        std::string queues = layout == QueueLayout::Ring ? ", ring queues" : ", linked queues";
+        run_suite(BenchContext{"std::map levels" + queues, [layout] {
+                                   auto book = std::make_unique<OrderBook>();
+                                   book->set_queue_layout(layout);
+                                   return book;
+                               }, cycles_per_ns, overhead, iterations, &counters});
+        run_suite(BenchContext{"tick ladder" + queues, [layout] {
+                                   auto book = std::make_unique<OrderBook>(TickLadderConfig{TICK, 50.0, 150.0});
+                                   book->set_queue_layout(layout);
+                                   return book;
+                               }, cycles_per_ns, overhead, iterations, &counters});
+    }
+    return 0;
+}
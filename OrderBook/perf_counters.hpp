@@ -0,0 +1,215 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Hardware counters for benchmarks: cycles, instructions, L1d, LLC and dTLB
+// read misses and branch misses of the calling thread, user space only.
+//
+// The events are opened as one perf_event_open group, so they are counted
+// over exactly the same instructions and one read() returns them all. A
+// kernel that multiplexes the group reports how long it actually ran, and
+// counts are scaled up to the whole interval. Events the CPU or kernel
+// cannot count (no PMU in a VM, perf_event_paranoid > 2) read as
+// unavailable rather than failing the benchmark.
+//
+//   PerfCounters counters;
+//   counters.start();
+//   ... work ...
+//   PerfReading reading = counters.stop();
+//   std::cout << perf_per_op(reading, operations);
+//
+// pause() and resume() leave untimed setup out of a measured loop. Each is
+// an ioctl, so keep them out of per-operation paths.
+
+enum class PerfEvent : uint8_t {
+    Cycles,
+    Instructions,
+    L1dMisses,
+    LlcMisses,
+    BranchMisses,
+    DtlbMisses,
+};
+
+constexpr size_t perf_event_count = 6;
+
+constexpr std::array<const char*, perf_event_count> perf_event_names = {
+    "cycles", "instr", "L1d miss", "LLC miss", "br miss", "dTLB miss"};
+
+struct PerfReading {
+    std::array<uint64_t, perf_event_count> values{};
+    std::array<bool, perf_event_count> valid{};
+
+    uint64_t operator[](PerfEvent event) const { return values[static_cast<size_t>(event)]; }
+    bool has(PerfEvent event) const { return valid[static_cast<size_t>(event)]; }
+
+    // Counts of two threads over the same run; an event is valid only if both counted it
+    PerfReading& operator+=(const PerfReading& other) {
+        for (size_t i = 0; i < perf_event_count; ++i) {
+            values[i] += other.values[i];
+            valid[i] = valid[i] && other.valid[i];
+        }
+        return *this;
+    }
+};
+
+class PerfCounters {
+public:
+    PerfCounters() {
+        for (size_t i = 0; i < perf_event_count; ++i) {
+            fds_[i] = open_event(static_cast<PerfEvent>(i));
+            if (fds_[i] >= 0) {
+                ids_[i] = event_id(fds_[i]);
+                if (leader_ < 0) leader_ = fds_[i];
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+
+    bool available() const { return leader_ >= 0; }
+
+    void start() {
+        if (leader_ < 0) return;
+        ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void pause() {
+        if (leader_ >= 0) ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void resume() {
+        if (leader_ >= 0) ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Counts since start(), scaled for multiplexing; the counters keep running
+    PerfReading read() const {
+        PerfReading reading;
+        if (leader_ < 0) return reading;
+
+        // PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING | ID layout
+        struct {
+            uint64_t nr;
+            uint64_t time_enabled;
+            uint64_t time_running;
+            struct {
+                uint64_t value;
+                uint64_t id;
+            } events[perf_event_count];
+        } group{};
+        if (::read(leader_, &group, sizeof(group)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return reading;
+        if (group.time_running == 0) return reading;
+        double scale = static_cast<double>(group.time_enabled) / static_cast<double>(group.time_running);
+
+        for (uint64_t n = 0; n < group.nr && n < perf_event_count; ++n) {
+            for (size_t i = 0; i < perf_event_count; ++i) {
+                if (fds_[i] >= 0 && ids_[i] == group.events[n].id) {
+                    reading.values[i] = static_cast<uint64_t>(static_cast<double>(group.events[n].value) * scale + 0.5);
+                    reading.valid[i] = true;
+                }
+            }
+        }
+        return reading;
+    }
+
+    PerfReading stop() {
+        pause();
+        return read();
+    }
+
+private:
+    static perf_event_attr attributes(PerfEvent event) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        auto cache = [&attr](uint64_t cache_id) {
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        switch (event) {
+            case PerfEvent::Cycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::Instructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::L1dMisses:
+                cache(PERF_COUNT_HW_CACHE_L1D);
+                break;
+            case PerfEvent::LlcMisses:
+                cache(PERF_COUNT_HW_CACHE_LL);
+                break;
+            case PerfEvent::BranchMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case PerfEvent::DtlbMisses:
+                cache(PERF_COUNT_HW_CACHE_DTLB);
+                break;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING |
+                           PERF_FORMAT_ID;
+        return attr;
+    }
+
+    // The first event that opens leads the group, the rest join it
+    int open_event(PerfEvent event) const {
+        perf_event_attr attr = attributes(event);
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+    }
+
+    static uint64_t event_id(int fd) {
+        uint64_t id = 0;
+        ::ioctl(fd, PERF_EVENT_IOC_ID, &id);
+        return id;
+    }
+
+    std::array<int, perf_event_count> fds_{};
+    std::array<uint64_t, perf_event_count> ids_{};
+    int leader_ = -1;
+};
+
+// Column headings matching perf_per_op(), each `width` wide
+inline std::string perf_header(int width = 10) {
+    std::ostringstream out;
+    for (const char* name : perf_event_names) out << std::setw(width) << name;
+    return out.str();
+}
+
+// Every event divided by `operations`, "n/a" where it was not counted
+inline std::string perf_per_op(const PerfReading& reading, uint64_t operations, int width = 10) {
+    std::ostringstream out;
+    out << std::fixed;
+    for (size_t i = 0; i < perf_event_count; ++i) {
+        out << std::setw(width);
+        if (!reading.valid[i] || operations == 0) {
+            out << "n/a";
+            continue;
+        }
+        double per_op = static_cast<double>(reading.values[i]) / static_cast<double>(operations);
+        out << std::setprecision(per_op < 10 ? 3 : 1) << per_op;
+    }
+    return out.str();
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tsc_clock.hpp"
+
+// Scoped latency probes for hot-path sections, cheap enough to leave on in
+// production and free when compiled out.
+//
+//   void process_matching() {
+//       PROBE_SCOPE("process_matching");
+//       ...
+//   }
+//
+// With ENABLE_PROBES defined, PROBE_SCOPE takes a bare rdtsc on entry and on
+// exit and adds the interval to the calling thread's histogram for that
+// name; without it, the macro expands to nothing. Recording touches only
+// thread-owned memory: no locks, no atomic read-modify-writes, no shared
+// cache lines. A ProbeReporter thread reads every thread's histograms and
+// prints per-interval count, p50, p99, p99.9 and max.
+//
+// Histograms are HDR-style log-linear: exact below 64 cycles, then every
+// power of two split into 32 linear buckets, so any value is reported to
+// within 1/32 (3%) and the whole uint64 range fits in 1920 buckets.
+
+class LatencyHistogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 6;
+    static constexpr uint64_t sub_bucket_count = uint64_t{1} << sub_bucket_bits;
+    static constexpr uint64_t half_count = sub_bucket_count / 2;
+    static constexpr size_t bucket_count = sub_bucket_count + (64 - sub_bucket_bits) * half_count;
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < sub_bucket_count) return static_cast<size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - sub_bucket_bits;
+        return static_cast<size_t>(sub_bucket_count + (shift - 1) * half_count + ((value >> shift) - half_count));
+    }
+
+    // Largest value that lands in `bucket`
+    static uint64_t bucket_high(size_t bucket) {
+        if (bucket < sub_bucket_count) return bucket;
+        uint64_t k = bucket - sub_bucket_count;
+        unsigned shift = static_cast<unsigned>(k / half_count) + 1;
+        uint64_t top = k % half_count + half_count;
+        return ((top + 1) << shift) - 1;
+    }
+
+    void record(uint64_t value) {
+        counts_[bucket_of(value)]++;
+        total_++;
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < bucket_count; ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    // What was recorded since `earlier`, a snapshot of the same histogram.
+    // The max is the top of the highest bucket with new samples.
+    LatencyHistogram since(const LatencyHistogram& earlier) const {
+        LatencyHistogram delta;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            delta.counts_[i] = counts_[i] - earlier.counts_[i];
+            if (delta.counts_[i]) delta.max_ = std::min(bucket_high(i), max_);
+        }
+        delta.total_ = total_ - earlier.total_;
+        return delta;
+    }
+
+    // Smallest recorded value v such that a `quantile` share of samples is <= v,
+    // to bucket precision
+    uint64_t percentile(double quantile) const {
+        if (total_ == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(quantile * static_cast<double>(total_) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(bucket_high(i), max_);
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+    uint64_t bucket(size_t index) const { return counts_[index]; }
+
+    void set_bucket(size_t index, uint64_t count) { counts_[index] = count; }
+    void set_totals(uint64_t total, uint64_t max) { total_ = total; max_ = max; }
+
+private:
+    std::array<uint64_t, bucket_count> counts_{};
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+};
+
+// One thread's histogram for one probe. Only the owning thread writes, so a
+// relaxed load and store replace a locked increment; a reader on another
+// thread sees every bucket move forward, possibly a few samples behind.
+class ProbeHistogram {
+public:
+    void record(uint64_t cycles) {
+        bump(counts_[LatencyHistogram::bucket_of(cycles)]);
+        if (cycles > max_.load(std::memory_order_relaxed)) max_.store(cycles, std::memory_order_relaxed);
+    }
+
+    // The count is summed from the buckets read, so it always matches them
+    void snapshot(LatencyHistogram& out) const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+            uint64_t count = counts_[i].load(std::memory_order_relaxed);
+            out.set_bucket(i, count);
+            total += count;
+        }
+        out.set_totals(total, max_.load(std::memory_order_relaxed));
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, LatencyHistogram::bucket_count> counts_{};
+    std::atomic<uint64_t> max_{0};
+};
+
+constexpr uint32_t max_probes = 64;
+
+// A thread's histograms, one per probe id, allocated on the thread's first
+// sample for that probe. Owned by the registry, so a thread's samples
+// outlive it and still show in reports.
+struct alignas(64) ProbeThreadLog {
+    std::array<std::atomic<ProbeHistogram*>, max_probes> histograms{};
+    std::vector<std::unique_ptr<ProbeHistogram>> owned;   // Written by the owning thread only
+
+    ProbeHistogram& histogram(uint32_t id) {
+        ProbeHistogram* histogram = histograms[id].load(std::memory_order_relaxed);
+        if (!histogram) {
+            owned.push_back(std::make_unique<ProbeHistogram>());
+            histogram = owned.back().get();
+            histograms[id].store(histogram, std::memory_order_release);
+        }
+        return *histogram;
+    }
+};
+
+class ProbeRegistry {
+public:
+    // Same name, same id; names beyond max_probes share the last id
+    uint32_t register_probe(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t id = 0; id < names_.size(); ++id) {
+            if (names_[id] == name) return id;
+        }
+        if (names_.size() == max_probes) return max_probes - 1;
+        names_.push_back(name);
+        return static_cast<uint32_t>(names_.size() - 1);
+    }
+
+    ProbeThreadLog* attach_thread() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        logs_.push_back(std::make_unique<ProbeThreadLog>());
+        return logs_.back().get();
+    }
+
+    // Every thread's samples for each probe, merged, with the probe names
+    void collect(std::vector<std::string>& names, std::vector<LatencyHistogram>& merged) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        names = names_;
+        merged.assign(names_.size(), LatencyHistogram{});
+        LatencyHistogram one;
+        for (const auto& log : logs_) {
+            for (uint32_t id = 0; id < names_.size(); ++id) {
+                const ProbeHistogram* histogram = log->histograms[id].load(std::memory_order_acquire);
+                if (!histogram) continue;
+                histogram->snapshot(one);
+                merged[id].merge(one);
+            }
+        }
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::string> names_;
+    std::vector<std::unique_ptr<ProbeThreadLog>> logs_;
+};
+
+inline ProbeRegistry& probe_registry() {
+    static ProbeRegistry registry;
+    return registry;
+}
+
+inline uint32_t probe_register(const char* name) { return probe_registry().register_probe(name); }
+
+inline ProbeThreadLog& probe_thread_log() {
+    thread_local ProbeThreadLog* log = probe_registry().attach_thread();
+    return *log;
+}
+
+// Times its own lifetime into probe `id` of the calling thread
+class ScopedProbe {
+public:
+    explicit ScopedProbe(uint32_t id) : id_(id), start_(tsc_read<TscFence::None>()) {}
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+    ~ScopedProbe() { probe_thread_log().histogram(id_).record(tsc_read<TscFence::None>() - start_); }
+
+private:
+    uint32_t id_;
+    uint64_t start_;
+};
+
+// Prints one table of every probe: count, p50, p99, p99.9 and max in ns
+inline void print_probes(std::ostream& out, const std::vector<std::string>& names,
+                         const std::vector<LatencyHistogram>& histograms) {
+    if (std::none_of(histograms.begin(), histograms.end(), [](const LatencyHistogram& h) { return h.count() > 0; })) {
+        return;
+    }
+    const TscClock& clock = tsc_clock();
+    out << std::left << std::setw(32) << "probe" << std::right << std::setw(12) << "count" << std::setw(10) << "p50"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max (ns)" << "\n";
+    for (size_t id = 0; id < names.size(); ++id) {
+        const LatencyHistogram& h = histograms[id];
+        if (h.count() == 0) continue;
+        out << std::left << std::setw(32) << names[id] << std::right << std::setw(12) << h.count()
+            << std::setw(10) << clock.to_ns(h.percentile(0.50)) << std::setw(10) << clock.to_ns(h.percentile(0.99))
+            << std::setw(10) << clock.to_ns(h.percentile(0.999)) << std::setw(12) << clock.to_ns(h.max()) << "\n";
+    }
+    out.flush();
+}
+
+// Background thread that prints what every probe recorded in each interval,
+// and a last interval when it is destroyed
+class ProbeReporter {
+public:
+    ProbeReporter(std::ostream& out, std::chrono::milliseconds interval)
+        : out_(out), interval_(interval), stop_(false) {
+        tsc_clock();
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ProbeReporter(const ProbeReporter&) = delete;
+    ProbeReporter& operator=(const ProbeReporter&) = delete;
+
+    ~ProbeReporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+private:
+    void run() {
+        std::vector<std::string> names;
+        std::vector<LatencyHistogram> previous, current, delta;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (bool last = false; !last;) {
+            last = wake_.wait_for(lock, interval_, [this] { return stop_; });
+            probe_registry().collect(names, current);
+            previous.resize(current.size());
+            delta.clear();
+            for (size_t id = 0; id < current.size(); ++id) {
+                delta.push_back(current[id].since(previous[id]));
+            }
+            print_probes(out_, names, delta);
+            previous.swap(current);
+        }
+    }
+
+    std::ostream& out_;
+    std::chrono::milliseconds interval_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_;
+    std::thread thread_;
+};
+
+#define PROBE_CONCAT_INNER(a, b) a##b
+#define PROBE_CONCAT(a, b) PROBE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROBES
+#define PROBE_SCOPE(name)                                                                  \
+    static const uint32_t PROBE_CONCAT(probe_id_, __LINE__) = probe_register(name);       \
+    ScopedProbe PROBE_CONCAT(probe_, __LINE__)(PROBE_CONCAT(probe_id_, __LINE__))
+#else
+#define PROBE_SCOPE(name) static_assert(true, "")
+#endif
@@ -0,0 +1,281 @@
+// Cost of the pre-trade risk check with several gateway threads sharing
+// accounts, against the mutex-protected map it replaces.
+//
+//   gateway threads:  random order flow -> RiskGate::check_add -> Fifo3 push
+//   matcher thread:   Fifo3 pops -> RiskLedger::apply -> BasicOrderBook<RiskTradeSink>
+//
+// Every check is timed with the TSC on its gateway thread. The baseline runs
+// the same flow through one std::mutex and an unordered_map of account state,
+// releasing each accepted order at once so it never stops at a limit.
+//
+//   g++ -std=c++20 -O2 -pthread risk_bench.cpp -o risk_bench
+//   ./risk_bench [gateways [orders_per_gateway [accounts]]]
+//
+// Gateways run as the "gateway.N" roles and the matcher as "matcher.0", so
+// THREAD_ROLES places them (see thread_runtime.hpp); unpinned threads yield
+// while waiting, so it also runs on one core.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "order_book.hpp"
+#include "latency.hpp"
+#include "risk_gate.hpp"
+#include "thread_runtime.hpp"
+#include "../SPSC_QUEUES/spsc_q3.cpp"
+
+namespace {
+
+struct Lcg {
+    uint64_t state;
+    uint64_t next() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state >> 33;
+    }
+};
+
+struct BenchConfig {
+    uint32_t gateways = 2;
+    uint64_t orders = 1000000;   // Per gateway
+    uint32_t accounts = 64;
+};
+
+const RiskLimits bench_limits{20000, 500000.0, 100, 50000};
+
+// Adds around 100.0 with cancels of recent ones, as a gateway would forward them
+struct OrderFlow {
+    Lcg rng;
+    uint64_t next_id;
+    uint32_t accounts;
+    std::vector<std::pair<uint32_t, uint64_t>> recent;   // Accepted (account, id), for cancels
+
+    bool next_is_cancel() { return !recent.empty() && rng.next() % 100 < 40; }
+
+    std::pair<uint32_t, uint64_t> take_cancel() {
+        size_t pick = rng.next() % recent.size();
+        auto cancel = recent[pick];
+        recent[pick] = recent.back();
+        recent.pop_back();
+        return cancel;
+    }
+
+    std::pair<uint32_t, Order> next_add() {
+        bool is_buy = rng.next() % 2;
+        double offset = 0.01 * static_cast<double>(rng.next() % 20) - 0.02;   // Some cross
+        Order order{next_id++, is_buy, is_buy ? 100.0 - offset : 100.0 + offset, 1 + rng.next() % 120, 0};
+        return {static_cast<uint32_t>(rng.next() % accounts), order};
+    }
+
+    void accepted(uint32_t account, uint64_t id) {
+        if (recent.size() < 4096) recent.emplace_back(account, id);
+    }
+};
+
+// What a lock-based gate looks like: one map of account state behind a mutex
+class MutexRiskGate {
+public:
+    explicit MutexRiskGate(const RiskLimits& limits) : limits_(limits) {}
+
+    RiskDecision check_add(uint32_t account, const Order& order, uint64_t now_ns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        State& state = accounts_[account];
+        if (order.quantity == 0 || order.quantity > limits_.max_order_quantity) return RiskDecision::QuantityLimit;
+        int64_t quantity = static_cast<int64_t>(order.quantity);
+        int64_t working = (order.is_buy ? state.open_buy : state.open_sell) + quantity;
+        if ((order.is_buy ? state.position + working : working - state.position) > limits_.max_position) {
+            return RiskDecision::PositionLimit;
+        }
+        double notional = order.price * static_cast<double>(order.quantity);
+        if (state.open_notional + notional > limits_.max_open_notional) return RiskDecision::NotionalLimit;
+        uint64_t window = now_ns / 1'000'000'000;
+        if (window != state.window) {
+            state.window = window;
+            state.orders = 0;
+        }
+        if (state.orders >= limits_.max_orders_per_window) return RiskDecision::RateLimit;
+        ++state.orders;
+        (order.is_buy ? state.open_buy : state.open_sell) = working;
+        state.open_notional += notional;
+        return RiskDecision::Accepted;
+    }
+
+    void release(uint32_t account, const Order& order) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        State& state = accounts_[account];
+        (order.is_buy ? state.open_buy : state.open_sell) -= static_cast<int64_t>(order.quantity);
+        state.open_notional -= order.price * static_cast<double>(order.quantity);
+    }
+
+private:
+    struct State {
+        int64_t position = 0;
+        int64_t open_buy = 0;
+        int64_t open_sell = 0;
+        double open_notional = 0.0;
+        uint64_t window = 0;
+        uint32_t orders = 0;
+    };
+
+    RiskLimits limits_;
+    std::mutex mutex_;
+    std::unordered_map<uint32_t, State> accounts_;
+};
+
+// Gateways through the lock-free gate into the book
+void run_pipeline(const BenchConfig& config, ThreadRuntime& runtime) {
+    RiskGate gate(config.accounts);
+    for (uint32_t a = 0; a < config.accounts; ++a) gate.set_limits(a, bench_limits);
+    RiskLedger ledger(gate, 1 << 16);
+    BasicOrderBook<RiskTradeSink> book{RiskTradeSink{&ledger}};
+    book.reserve_orders(1 << 16);
+
+    std::vector<std::unique_ptr<Fifo3<RiskedCommand>>> queues;
+    std::vector<std::unique_ptr<LatencyStats>> checks;
+    for (uint32_t g = 0; g < config.gateways; ++g) {
+        queues.push_back(std::make_unique<Fifo3<RiskedCommand>>(65536));
+        checks.push_back(std::make_unique<LatencyStats>(config.orders));
+    }
+    std::vector<uint64_t> rejects(config.gateways, 0);
+    std::atomic<uint32_t> finished{0};
+    uint64_t applied = 0;
+    uint64_t book_rejects = 0;
+
+    std::thread matcher = runtime.spawn("matcher.0", [&] {
+        bool pinned = runtime.placement("matcher.0").core >= 0;
+        RiskedCommand command;
+        for (uint32_t misses = 0;;) {
+            bool done = finished.load(std::memory_order_acquire) == config.gateways;
+            bool popped = false;
+            for (auto& queue : queues) {
+                while (queue->pop(command)) {
+                    popped = true;
+                    ++applied;
+                    if (ledger.apply(book, command) != CommandStatus::Accepted) ++book_rejects;
+                }
+            }
+            if (popped) continue;
+            if (done) break;
+            _mm_pause();
+            if (!pinned && (++misses & 63) == 0) std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> gateways;
+    for (uint32_t g = 0; g < config.gateways; ++g) {
+        std::string role = "gateway." + std::to_string(g);
+        gateways.push_back(runtime.spawn(role, [&, g, pinned = runtime.placement(role).core >= 0] {
+            OrderFlow flow{{g + 1}, (uint64_t(g) + 1) << 40, config.accounts, {}};
+            Fifo3<RiskedCommand>& queue = *queues[g];
+            LatencyStats& stats = *checks[g];
+            auto push = [&](const RiskedCommand& command) {
+                for (uint32_t misses = 0; !queue.push(command); ++misses) {
+                    _mm_pause();
+                    if (!pinned && (misses & 63) == 63) std::this_thread::yield();
+                }
+            };
+            for (uint64_t i = 0; i < config.orders; ++i) {
+                if (flow.next_is_cancel()) {
+                    auto [account, id] = flow.take_cancel();
+                    push(RiskedCommand::cancel(account, id));
+                    continue;
+                }
+                auto [account, order] = flow.next_add();
+                uint64_t now_ns = tsc_clock().to_epoch_ns(read_cycles());
+                uint64_t start = read_cycles();
+                RiskDecision decision = gate.check_add(account, order, now_ns);
+                stats.record(read_cycles() - start);
+                if (decision != RiskDecision::Accepted) {
+                    ++rejects[g];
+                    continue;
+                }
+                push(RiskedCommand::add(account, order));
+                flow.accepted(account, order.order_id);
+            }
+            finished.fetch_add(1, std::memory_order_release);
+        }));
+    }
+    for (const PlacementResult& result : runtime.results()) {
+        if (!result.ok()) std::cerr << "warning: " << result.role << " thread: " << result.error << std::endl;
+    }
+    for (auto& gateway : gateways) gateway.join();
+    matcher.join();
+
+    double cycles_per_ns = calibrate_cycles_per_ns();
+    uint64_t overhead = timer_overhead_cycles();
+    uint64_t rejected = 0;
+    for (uint64_t r : rejects) rejected += r;
+    std::cout << applied << " commands applied (" << book_rejects << " refused by the book), " << rejected
+              << " refused by the gate, " << ledger.working() << " orders working, " << book.trade_sink().trades
+              << " trades\n";
+    for (uint32_t g = 0; g < config.gateways; ++g) {
+        checks[g]->report("RiskGate::check_add gateway." + std::to_string(g), cycles_per_ns, overhead);
+    }
+}
+
+// Same flows through the mutex gate; accepted orders are released at once
+void run_mutex_baseline(const BenchConfig& config) {
+    MutexRiskGate gate(bench_limits);
+    std::vector<std::unique_ptr<LatencyStats>> checks;
+    for (uint32_t g = 0; g < config.gateways; ++g) checks.push_back(std::make_unique<LatencyStats>(config.orders));
+
+    std::vector<std::thread> gateways;
+    for (uint32_t g = 0; g < config.gateways; ++g) {
+        gateways.emplace_back([&, g] {
+            OrderFlow flow{{g + 1}, (uint64_t(g) + 1) << 40, config.accounts, {}};
+            LatencyStats& stats = *checks[g];
+            for (uint64_t i = 0; i < config.orders; ++i) {
+                if (flow.next_is_cancel()) {
+                    flow.take_cancel();
+                    continue;
+                }
+                auto [account, order] = flow.next_add();
+                uint64_t now_ns = tsc_clock().to_epoch_ns(read_cycles());
+                uint64_t start = read_cycles();
+                RiskDecision decision = gate.check_add(account, order, now_ns);
+                stats.record(read_cycles() - start);
+                if (decision == RiskDecision::Accepted) {
+                    gate.release(account, order);
+                    flow.accepted(account, order.order_id);
+                }
+            }
+        });
+    }
+    for (auto& gateway : gateways) gateway.join();
+
+    double cycles_per_ns = calibrate_cycles_per_ns();
+    uint64_t overhead = timer_overhead_cycles();
+    for (uint32_t g = 0; g < config.gateways; ++g) {
+        checks[g]->report("mutex + unordered_map gateway." + std::to_string(g), cycles_per_ns, overhead);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (argc > 1) config.gateways = static_cast<uint32_t>(std::atoi(argv[1]));
+    if (argc > 2) config.orders = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 3) config.accounts = static_cast<uint32_t>(std::atoi(argv[3]));
+    if (config.gateways == 0 || config.accounts == 0) {
+        std::cerr << "usage: risk_bench [gateways [orders_per_gateway [accounts]]]\n";
+        return 1;
+    }
+
+    report_clock(std::cout);
+    ThreadRuntime runtime = ThreadRuntime::from_env();
+    std::cout << std::left << std::setw(34) << "check" << std::right
+              << std::setw(9) << "count" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(12) << "max (ns)" << std::endl;
+    run_pipeline(config, runtime);
+    run_mutex_baseline(config);
+    return 0;
+}
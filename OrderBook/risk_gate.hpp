@@ -0,0 +1,349 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "order_book.hpp"
+
+// Pre-trade risk checks in front of the book, callable from any number of
+// gateway threads at once without a lock:
+//
+//   gateway threads:  RiskGate::check_add() -> Fifo3<RiskedCommand> push
+//   book thread:      pop -> RiskLedger::apply(book, command)
+//                     fills -> RiskTradeSink -> RiskLedger -> RiskGate
+//
+// Each account's counters sit alone on one cache line, so gateways working
+// different accounts never share a line and a check costs a few atomic
+// read-modify-writes on one line already owned by the checking core. A
+// check reserves the order's quantity and notional with fetch_add, then
+// compares the result with the limit and gives the reservation back if it
+// is over; two gateways racing for the last of a limit can both be refused,
+// never both accepted. The book thread returns reservations as orders fill
+// or leave the book.
+//
+// Limits per account:
+//   position   filled position plus every working order on the same side,
+//              so a fill can never take the account past it
+//   notional   price * quantity summed over working orders
+//   quantity   per order
+//   rate       orders accepted per window of window_ns, a fixed window
+//
+// Amends do not go through the gate: send a cancel and a fresh add.
+
+constexpr int64_t risk_notional_scale = 10000;   // Notional is held in units of 1 / scale
+
+struct RiskLimits {
+    int64_t max_position = 0;           // Absolute, in quantity
+    double max_open_notional = 0.0;
+    uint64_t max_order_quantity = 0;
+    uint32_t max_orders_per_window = 0; // Below 2^24
+};
+
+enum class RiskDecision : uint8_t {
+    Accepted,
+    UnknownAccount,
+    QuantityLimit,
+    PositionLimit,
+    NotionalLimit,
+    RateLimit
+};
+
+// Live exposure of one account, as last seen by one thread
+struct RiskExposure {
+    int64_t position;
+    int64_t open_buy;
+    int64_t open_sell;
+    double open_notional;
+    uint32_t rejects;
+};
+
+class RiskGate {
+public:
+    explicit RiskGate(size_t accounts, uint64_t window_ns = 1'000'000'000)
+        : accounts_(accounts), limits_(accounts), window_ns_(window_ns ? window_ns : 1) {}
+
+    RiskGate(const RiskGate&) = delete;
+    RiskGate& operator=(const RiskGate&) = delete;
+
+    // Setup only: not safe while gateways check the account
+    void set_limits(uint32_t account, const RiskLimits& limits) {
+        if (account >= limits_.size()) {
+            throw std::runtime_error("RiskGate: unknown account " + std::to_string(account));
+        }
+        if (limits.max_orders_per_window >= (1u << rate_count_bits)) {
+            throw std::runtime_error("RiskGate: order rate limit must be below 2^24 per window");
+        }
+        limits_[account] = Limits{limits.max_position, to_notional(limits.max_open_notional, 1),
+                                  limits.max_order_quantity, limits.max_orders_per_window};
+    }
+
+    // Any thread. On Accepted the order's quantity and notional stay reserved
+    // until the book thread fills or releases them, so an accepted order must
+    // reach the book (or be handed back with release()).
+    RiskDecision check_add(uint32_t account, const Order& order, uint64_t now_ns) {
+        if (account >= accounts_.size()) return RiskDecision::UnknownAccount;
+        const Limits& limits = limits_[account];
+        AccountRisk& risk = accounts_[account];
+        if (order.quantity == 0 || order.quantity > limits.max_order_quantity) {
+            return reject(risk, RiskDecision::QuantityLimit);
+        }
+
+        int64_t quantity = static_cast<int64_t>(order.quantity);
+        std::atomic<int64_t>& open = order.is_buy ? risk.open_buy : risk.open_sell;
+        int64_t notional = to_notional(order.price, order.quantity);
+        // Plain loads first: an account at a limit is refused without writing its line
+        if (RiskDecision early = precheck(risk, limits, order.is_buy, quantity, notional, now_ns);
+            early != RiskDecision::Accepted) {
+            return reject(risk, early);
+        }
+
+        // Acquire pairs with the book thread's release in fill(): a fill that
+        // lowered `open` has already moved `position`
+        int64_t working = open.fetch_add(quantity, std::memory_order_acquire) + quantity;
+        int64_t position = risk.position.load(std::memory_order_relaxed);
+        int64_t worst = order.is_buy ? position + working : working - position;
+        if (worst > limits.max_position) {
+            open.fetch_sub(quantity, std::memory_order_relaxed);
+            return reject(risk, RiskDecision::PositionLimit);
+        }
+
+        if (risk.open_notional.fetch_add(notional, std::memory_order_relaxed) + notional > limits.max_open_notional) {
+            risk.open_notional.fetch_sub(notional, std::memory_order_relaxed);
+            open.fetch_sub(quantity, std::memory_order_relaxed);
+            return reject(risk, RiskDecision::NotionalLimit);
+        }
+
+        if (!take_rate_slot(risk, limits, now_ns)) {
+            risk.open_notional.fetch_sub(notional, std::memory_order_relaxed);
+            open.fetch_sub(quantity, std::memory_order_relaxed);
+            return reject(risk, RiskDecision::RateLimit);
+        }
+        return RiskDecision::Accepted;
+    }
+
+    // Book thread: `quantity` of an order reserved at `order_price` traded
+    void fill(uint32_t account, bool is_buy, double order_price, uint64_t quantity) {
+        AccountRisk& risk = accounts_[account];
+        int64_t signed_quantity = static_cast<int64_t>(quantity);
+        risk.position.fetch_add(is_buy ? signed_quantity : -signed_quantity, std::memory_order_relaxed);
+        (is_buy ? risk.open_buy : risk.open_sell).fetch_sub(signed_quantity, std::memory_order_release);
+        risk.open_notional.fetch_sub(to_notional(order_price, quantity), std::memory_order_relaxed);
+    }
+
+    // `quantity` of an order reserved at `order_price` left the book unfilled
+    void release(uint32_t account, bool is_buy, double order_price, uint64_t quantity) {
+        AccountRisk& risk = accounts_[account];
+        (is_buy ? risk.open_buy : risk.open_sell).fetch_sub(static_cast<int64_t>(quantity), std::memory_order_relaxed);
+        risk.open_notional.fetch_sub(to_notional(order_price, quantity), std::memory_order_relaxed);
+    }
+
+    RiskExposure exposure(uint32_t account) const {
+        const AccountRisk& risk = accounts_.at(account);
+        return RiskExposure{risk.position.load(std::memory_order_relaxed),
+                            risk.open_buy.load(std::memory_order_relaxed),
+                            risk.open_sell.load(std::memory_order_relaxed),
+                            static_cast<double>(risk.open_notional.load(std::memory_order_relaxed)) /
+                                risk_notional_scale,
+                            risk.rejects.load(std::memory_order_relaxed)};
+    }
+
+    size_t accounts() const { return accounts_.size(); }
+
+    static int64_t to_notional(double price, uint64_t quantity) {
+        return std::llround(price * static_cast<double>(quantity) * risk_notional_scale);
+    }
+
+private:
+    static constexpr unsigned rate_count_bits = 24;   // Low bits of AccountRisk::rate; the window index above
+
+    // Hot counters of one account; written by its gateways and the book thread
+    struct alignas(64) AccountRisk {
+        std::atomic<int64_t> position{0};        // Signed filled quantity
+        std::atomic<int64_t> open_buy{0};        // Working and reserved buy quantity
+        std::atomic<int64_t> open_sell{0};
+        std::atomic<int64_t> open_notional{0};   // In 1 / risk_notional_scale
+        std::atomic<uint64_t> rate{0};           // Window index << 24 | orders accepted in it
+        std::atomic<uint32_t> rejects{0};
+    };
+    static_assert(sizeof(AccountRisk) == 64, "one account per cache line");
+
+    // Read-only once trading starts, so lines here are shared, not contended
+    struct Limits {
+        int64_t max_position = 0;
+        int64_t max_open_notional = 0;
+        uint64_t max_order_quantity = 0;
+        uint32_t max_orders_per_window = 0;
+    };
+
+    // Refusals visible without reserving; check_add() still decides with the reservation
+    RiskDecision precheck(const AccountRisk& risk, const Limits& limits, bool is_buy, int64_t quantity,
+                          int64_t notional, uint64_t now_ns) const {
+        int64_t working = (is_buy ? risk.open_buy : risk.open_sell).load(std::memory_order_relaxed) + quantity;
+        int64_t position = risk.position.load(std::memory_order_relaxed);
+        if ((is_buy ? position + working : working - position) > limits.max_position) {
+            return RiskDecision::PositionLimit;
+        }
+        if (risk.open_notional.load(std::memory_order_relaxed) + notional > limits.max_open_notional) {
+            return RiskDecision::NotionalLimit;
+        }
+        uint64_t rate = risk.rate.load(std::memory_order_relaxed);
+        if ((rate >> rate_count_bits) == window_of(now_ns) &&
+            (rate & ((1u << rate_count_bits) - 1)) >= limits.max_orders_per_window) {
+            return RiskDecision::RateLimit;
+        }
+        return RiskDecision::Accepted;
+    }
+
+    // Window index as kept in AccountRisk::rate: only its low 40 bits fit above
+    // the count. Epoch timestamps in short windows run past 2^40, so both sides
+    // of every comparison are cut to the same bits; indices alias 2^40 windows apart.
+    uint64_t window_of(uint64_t now_ns) const {
+        return (now_ns / window_ns_) & ((uint64_t{1} << (64 - rate_count_bits)) - 1);
+    }
+
+    bool take_rate_slot(AccountRisk& risk, const Limits& limits, uint64_t now_ns) {
+        uint64_t window = window_of(now_ns);
+        uint64_t current = risk.rate.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t next;
+            if ((current >> rate_count_bits) != window) {
+                next = (window << rate_count_bits) | 1;   // First order of a new window
+            } else if ((current & ((1u << rate_count_bits) - 1)) < limits.max_orders_per_window) {
+                next = current + 1;
+            } else {
+                return false;
+            }
+            if (limits.max_orders_per_window == 0) return false;
+            if (risk.rate.compare_exchange_weak(current, next, std::memory_order_relaxed)) return true;
+        }
+    }
+
+    static RiskDecision reject(AccountRisk& risk, RiskDecision decision) {
+        risk.rejects.fetch_add(1, std::memory_order_relaxed);
+        return decision;
+    }
+
+    std::vector<AccountRisk> accounts_;
+    std::vector<Limits> limits_;
+    uint64_t window_ns_;
+};
+
+// An order-entry message from a gateway, after check_add() accepted it
+struct RiskedCommand {
+    uint32_t account;
+    OrderCommand command;
+
+    static RiskedCommand add(uint32_t account, const Order& order) { return {account, OrderCommand::add(order)}; }
+    static RiskedCommand cancel(uint32_t account, uint64_t order_id) {
+        return {account, OrderCommand::cancel(order_id)};
+    }
+};
+
+// Book-thread side of the gate: remembers each working order's account,
+// side, price and unfilled quantity, and hands reservations back as the
+// book fills or drops them. Single-threaded, like the book.
+class RiskLedger {
+public:
+    explicit RiskLedger(RiskGate& gate, size_t expected_orders = 1024) : gate_(gate), index_(expected_orders) {
+        entries_.reserve(expected_orders);
+    }
+
+    // Applies one command to the book; the returned status is the book's
+    template<typename Book>
+    CommandStatus apply(Book& book, const RiskedCommand& risked) {
+        const OrderCommand& command = risked.command;
+        const Order& order = command.order;
+        CommandStatus status = CommandStatus::Accepted;
+        switch (command.type) {
+        case CommandType::Add:
+            if (index_.contains(order.order_id)) {
+                // The book rejects it too; the reservation belongs to this add, not the live order
+                gate_.release(risked.account, order.is_buy, order.price, order.quantity);
+                return CommandStatus::DuplicateOrderId;
+            }
+            track(risked.account, order);   // Before the book runs: the add may fill at once
+            book.apply_batch(std::span<const OrderCommand>(&command, 1), std::span<CommandStatus>(&status, 1));
+            if (status != CommandStatus::Accepted) release(order.order_id);
+            break;
+        case CommandType::Cancel:
+            book.apply_batch(std::span<const OrderCommand>(&command, 1), std::span<CommandStatus>(&status, 1));
+            if (status == CommandStatus::Accepted) release(order.order_id);
+            break;
+        case CommandType::Amend:
+            throw std::runtime_error("RiskLedger: amends go through the gate as a cancel and an add");
+        }
+        return status;
+    }
+
+    // From the book's trade sink
+    void on_trade(const TradeEvent& event) {
+        fill(event.buy_order_id, event.quantity);
+        fill(event.sell_order_id, event.quantity);
+    }
+
+    size_t working() const { return index_.size(); }
+
+private:
+    struct Entry {
+        uint32_t account;
+        bool is_buy;
+        double price;
+        uint64_t remaining;
+    };
+
+    void track(uint32_t account, const Order& order) {
+        uint32_t slot;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+            entries_[slot] = Entry{account, order.is_buy, order.price, order.quantity};
+        } else {
+            slot = static_cast<uint32_t>(entries_.size());
+            entries_.push_back(Entry{account, order.is_buy, order.price, order.quantity});
+        }
+        index_.insert(order.order_id, slot + 1);   // FlatIdMap reserves 0 for empty slots
+    }
+
+    void fill(uint64_t order_id, uint64_t quantity) {
+        uint32_t slot = index_.find(order_id);
+        if (!slot) return;   // Not entered through the gate
+        Entry& entry = entries_[slot - 1];
+        gate_.fill(entry.account, entry.is_buy, entry.price, quantity);
+        entry.remaining -= quantity;
+        if (entry.remaining == 0) forget(order_id, slot);
+    }
+
+    void release(uint64_t order_id) {
+        uint32_t slot = index_.find(order_id);
+        if (!slot) return;
+        const Entry& entry = entries_[slot - 1];
+        gate_.release(entry.account, entry.is_buy, entry.price, entry.remaining);
+        forget(order_id, slot);
+    }
+
+    void forget(uint64_t order_id, uint32_t slot) {
+        index_.erase(order_id);
+        free_.push_back(slot - 1);
+    }
+
+    RiskGate& gate_;
+    FlatIdMap<uint32_t> index_;      // Order id -> entry index + 1
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> free_;
+};
+
+// Trade sink of a book behind the gate: BasicOrderBook<RiskTradeSink>
+struct RiskTradeSink {
+    RiskLedger* ledger = nullptr;
+    uint64_t trades = 0;
+
+    void on_trade(const TradeEvent& event) {
+        ledger->on_trade(event);
+        ++trades;
+    }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../SPSC_QUEUES/cache_line.hpp"
+
+
+/// Single-writer sequence lock publishing a trivially copyable T to any number
+/// of readers. Readers never write shared state, so they cannot bounce the
+/// writer's cache lines; they retry if the writer raced with their copy.
+/// The payload is copied as relaxed atomic words so concurrent access is not
+/// a data race; on x86 these compile to plain moves.
+template<typename T>
+class SeqLock
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(sizeof(T) % sizeof(uint64_t) == 0, "payload is copied in 64-bit words");
+
+    SeqLock() noexcept {
+        for (auto& word : words_) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// Publish a new value. Must only be called from the single writer thread.
+    void store(T const& value) noexcept {
+        uint64_t words[word_count];
+        std::memcpy(words, &value, sizeof(T));
+
+        auto seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < word_count; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    /// Copy out the latest value, spinning while a write is in progress.
+    void load(T& value) const noexcept {
+        while (not try_load(value)) {
+        }
+    }
+
+    /// Single attempt at a consistent copy.
+    /// @return `true` if `value` holds a consistent snapshot; `false` if a write raced.
+    bool try_load(T& value) const noexcept {
+        auto before = seq_.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        uint64_t words[word_count];
+        for (size_t i = 0; i < word_count; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+        std::memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    /// Number of completed stores
+    uint64_t generation() const noexcept { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t word_count = sizeof(T) / sizeof(uint64_t);
+
+    /// Stored by the writer; loaded by readers
+    alignas(cache_line_size) std::atomic<uint64_t> seq_{0};
+
+    /// Payload starts on its own line so the sequence word is not shared with it
+    alignas(cache_line_size) std::atomic<uint64_t> words_[word_count];
+
+    // Padding to avoid false sharing with adjacent objects
+    char padding_[cache_line_size];
+};
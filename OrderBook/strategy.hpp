@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+#include "order_book.hpp"
+
+// Strategy hosting without virtual calls. A strategy derives from
+// Strategy<Self> and hides the handlers it cares about:
+//
+//   struct Quoter : Strategy<Quoter> {
+//       static constexpr const char* name = "quoter";
+//       template<typename Book> void on_book_update(const LevelDelta&, const Book&);
+//       void on_trade(const TradeEvent&);
+//   };
+//
+// StrategyHost<A, B, ...> holds its strategies by value in a tuple and calls
+// each handler directly on the concrete type, so every call can be inlined
+// and nothing is allocated per event. It is also a trade sink, so
+// BasicOrderBook<StrategyHost<...>> hands fills to the strategies from the
+// matching path; level deltas come from the book's delta ring via poll().
+//
+// RuntimeStrategyHost<A, B, ...> is the fallback when the set of strategies
+// comes from configuration: it keeps a Vector of std::variant<A, B, ...>
+// chosen by name, inline for up to four strategies, and dispatches with
+// std::visit, a jump table instead of a virtual call, with the same
+// handlers and no per-event allocation.
+
+template<typename Derived>
+struct Strategy {
+    // Default handlers ignore the event
+    template<typename Book>
+    void on_book_update(const LevelDelta&, const Book&) {}
+    void on_trade(const TradeEvent&) {}
+    // Deltas were overwritten before poll() read them; rebuild from the book
+    template<typename Book>
+    void on_book_gap(const Book&) {}
+
+    Derived& self() { return static_cast<Derived&>(*this); }
+    const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+template<typename T>
+concept StrategyType = std::is_base_of_v<Strategy<T>, T>;
+
+// Reads new level deltas from a book through a private cursor and passes
+// them to Host::on_book_update(), in batches copied to the stack
+template<typename Host>
+class StrategyDeltaReader {
+public:
+    // Delivers every delta published since the last poll; returns the count
+    template<typename Book>
+    size_t poll(const Book& book) {
+        Host& host = static_cast<Host&>(*this);
+        std::array<LevelDelta, 64> batch;
+        size_t delivered = 0;
+        while (true) {
+            bool gap = false;
+            size_t count = book.level_deltas().read(cursor_, std::span<LevelDelta>(batch), gap);
+            if (gap) host.on_book_gap(book);
+            for (size_t i = 0; i < count; ++i) {
+                host.on_book_update(batch[i], book);
+            }
+            delivered += count;
+            if (count < batch.size()) return delivered;
+        }
+    }
+
+private:
+    uint64_t cursor_ = 1;
+};
+
+template<StrategyType... Strategies>
+class StrategyHost : public StrategyDeltaReader<StrategyHost<Strategies...>> {
+public:
+    StrategyHost() = default;
+    explicit StrategyHost(Strategies... strategies) : strategies_(std::move(strategies)...) {}
+
+    template<typename Book>
+    void on_book_update(const LevelDelta& delta, const Book& book) {
+        std::apply([&](auto&... strategy) { (strategy.on_book_update(delta, book), ...); }, strategies_);
+    }
+
+    void on_trade(const TradeEvent& event) {
+        std::apply([&](auto&... strategy) { (strategy.on_trade(event), ...); }, strategies_);
+    }
+
+    template<typename Book>
+    void on_book_gap(const Book& book) {
+        std::apply([&](auto&... strategy) { (strategy.on_book_gap(book), ...); }, strategies_);
+    }
+
+    template<typename T>
+    T& get() { return std::get<T>(strategies_); }
+    template<typename T>
+    const T& get() const { return std::get<T>(strategies_); }
+
+private:
+    std::tuple<Strategies...> strategies_;
+};
+
+template<StrategyType... Strategies>
+class RuntimeStrategyHost : public StrategyDeltaReader<RuntimeStrategyHost<Strategies...>> {
+public:
+    using Slot = std::variant<Strategies...>;
+
+    // Appends a default-constructed strategy whose T::name matches
+    void add(std::string_view name) {
+        bool found = ((name == Strategies::name ? (strategies_.emplace_back(std::in_place_type<Strategies>), true)
+                                                : false) || ...);
+        if (!found) {
+            throw std::runtime_error("Unknown strategy: " + std::string(name));
+        }
+    }
+
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        return std::get<T>(strategies_.emplace_back(std::in_place_type<T>, std::forward<Args>(args)...));
+    }
+
+    template<typename Book>
+    void on_book_update(const LevelDelta& delta, const Book& book) {
+        for (Slot& slot : strategies_) {
+            std::visit([&](auto& strategy) { strategy.on_book_update(delta, book); }, slot);
+        }
+    }
+
+    void on_trade(const TradeEvent& event) {
+        for (Slot& slot : strategies_) {
+            std::visit([&](auto& strategy) { strategy.on_trade(event); }, slot);
+        }
+    }
+
+    template<typename Book>
+    void on_book_gap(const Book& book) {
+        for (Slot& slot : strategies_) {
+            std::visit([&](auto& strategy) { strategy.on_book_gap(book); }, slot);
+        }
+    }
+
+    size_t size() const { return strategies_.size(); }
+    Slot& operator[](size_t i) { return strategies_[i]; }
+    const Slot& operator[](size_t i) const { return strategies_[i]; }
+
+private:
+    Vector<Slot, 4> strategies_;
+};
@@ -0,0 +1,287 @@
+// Cost of delivering book deltas and trades to strategies: the naive
+// virtual shape (a heap-allocated event object per message, dispatched
+// through a Strategy base with virtual handlers, as in L6/inhertiance2.cpp),
+// plain virtual calls, the variant/visit runtime host, and the CRTP host.
+//
+// The event stream is recorded once from a book running a random order mix,
+// then replayed into each host holding the same three strategies. Each row is
+// the best of several replays, in ns per event, with hardware counters per
+// event where the kernel provides them.
+//
+//   g++ -std=c++20 -O2 -pthread strategy_bench.cpp -o strategy_bench
+//   ./strategy_bench [orders]
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "order_book.hpp"
+#include "latency.hpp"
+#include "perf_counters.hpp"
+#include "strategy.hpp"
+
+namespace {
+
+struct Lcg {
+    uint64_t state;
+    uint64_t next() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state >> 33;
+    }
+};
+
+// Level totals published per side, a crude depth pressure from the deltas alone
+struct PressureStrategy : Strategy<PressureStrategy> {
+    static constexpr const char* name = "pressure";
+    uint64_t bid_pressure = 0;
+    uint64_t ask_pressure = 0;
+
+    template<typename Book>
+    void on_book_update(const LevelDelta& delta, const Book&) {
+        (delta.is_buy ? bid_pressure : ask_pressure) += delta.quantity;
+    }
+
+    uint64_t checksum() const { return bid_pressure * 31 + ask_pressure; }
+};
+
+// Running traded volume and notional
+struct VwapStrategy : Strategy<VwapStrategy> {
+    static constexpr const char* name = "vwap";
+    uint64_t volume = 0;
+    double notional = 0.0;
+
+    void on_trade(const TradeEvent& event) {
+        volume += event.quantity;
+        notional += event.price * static_cast<double>(event.quantity);
+    }
+
+    uint64_t checksum() const { return volume ^ static_cast<uint64_t>(notional); }
+};
+
+// Counts levels emptied on either side, and trades that follow one
+struct SweepStrategy : Strategy<SweepStrategy> {
+    static constexpr const char* name = "sweep";
+    uint64_t deletes = 0;
+    uint64_t after_delete = 0;
+    bool armed = false;
+
+    template<typename Book>
+    void on_book_update(const LevelDelta& delta, const Book&) {
+        if (delta.action == LevelAction::Delete) {
+            ++deletes;
+            armed = true;
+        }
+    }
+
+    void on_trade(const TradeEvent&) {
+        after_delete += armed;
+        armed = false;
+    }
+
+    uint64_t checksum() const { return deletes * 1000003 + after_delete; }
+};
+
+// The virtual-dispatch baseline, wrapping the same strategy code
+struct VirtualStrategy {
+    virtual ~VirtualStrategy() = default;
+    virtual void on_book_update(const LevelDelta& delta, const OrderBook& book) = 0;
+    virtual void on_trade(const TradeEvent& event) = 0;
+    virtual uint64_t checksum() const = 0;
+};
+
+template<typename S>
+struct VirtualAdapter final : VirtualStrategy {
+    S strategy;
+    void on_book_update(const LevelDelta& delta, const OrderBook& book) override { strategy.on_book_update(delta, book); }
+    void on_trade(const TradeEvent& event) override { strategy.on_trade(event); }
+    uint64_t checksum() const override { return strategy.checksum(); }
+};
+
+struct VirtualHost {
+    std::vector<std::unique_ptr<VirtualStrategy>> strategies;
+
+    void on_book_update(const LevelDelta& delta, const OrderBook& book) {
+        for (auto& strategy : strategies) strategy->on_book_update(delta, book);
+    }
+    void on_trade(const TradeEvent& event) {
+        for (auto& strategy : strategies) strategy->on_trade(event);
+    }
+};
+
+// Polymorphic event objects, one allocation per message
+struct BookMessage {
+    virtual ~BookMessage() = default;
+    virtual void deliver(VirtualHost& host, const OrderBook& book) const = 0;
+};
+
+struct DeltaMessage final : BookMessage {
+    LevelDelta delta;
+    explicit DeltaMessage(const LevelDelta& d) : delta(d) {}
+    void deliver(VirtualHost& host, const OrderBook& book) const override { host.on_book_update(delta, book); }
+};
+
+struct TradeMessage final : BookMessage {
+    TradeEvent event;
+    explicit TradeMessage(const TradeEvent& e) : event(e) {}
+    void deliver(VirtualHost& host, const OrderBook&) const override { host.on_trade(event); }
+};
+
+struct AllocatingHost {
+    VirtualHost& host;
+
+    void on_book_update(const LevelDelta& delta, const OrderBook& book) {
+        std::unique_ptr<BookMessage> message(new DeltaMessage(delta));
+        message->deliver(host, book);
+    }
+    void on_trade(const TradeEvent& event, const OrderBook& book) {
+        std::unique_ptr<BookMessage> message(new TradeMessage(event));
+        message->deliver(host, book);
+    }
+};
+
+struct Recording {
+    std::vector<LevelDelta> deltas;
+    std::vector<TradeEvent> trades;
+    size_t events() const { return deltas.size() + trades.size(); }
+};
+
+// Level deltas and fills of a 45% add, 40% cancel, 15% aggressive order mix
+Recording record(size_t orders) {
+    constexpr double mid = 100.0, tick = 0.01;
+    BasicOrderBook<TradeRecorder> book{TradeRecorder(orders)};
+    book.enable_level_deltas(4 * orders);
+    Lcg rng{7};
+    std::vector<uint64_t> live;
+    uint64_t next_id = 1;
+    for (size_t i = 0; i < orders; ++i) {
+        uint64_t action = rng.next() % 100;
+        bool is_buy = rng.next() % 2 == 0;
+        if (action < 40 && !live.empty()) {
+            size_t slot = rng.next() % live.size();
+            book.cancel_order(live[slot]);
+            live[slot] = live.back();
+            live.pop_back();
+        } else if (action < 85 || live.empty()) {
+            double offset = tick * static_cast<double>(1 + rng.next() % 50);
+            book.add_order(Order{next_id, is_buy, is_buy ? mid - offset : mid + offset, 1 + rng.next() % 100, 1});
+            live.push_back(next_id++);
+        } else {
+            book.add_order(Order{next_id++, is_buy, is_buy ? mid + 5 * tick : mid - 5 * tick, 150, 1});
+        }
+    }
+
+    Recording recording;
+    recording.deltas.resize(book.level_deltas().next_sequence() - 1);
+    uint64_t cursor = 1;
+    bool gap = false;
+    recording.deltas.resize(book.level_deltas().read(cursor, recording.deltas, gap));
+    for (size_t i = 0; i < book.trade_sink().size(); ++i) recording.trades.push_back(book.trade_sink()[i]);
+    return recording;
+}
+
+// Replays the recording into the two handlers, spreading the trades evenly between
+// the deltas; returns the best ns per event of `rounds` replays
+template<typename DeliverDelta, typename DeliverTrade>
+double replay(const Recording& recording, PerfCounters& counters, PerfReading& best_counts,
+              DeliverDelta&& on_delta, DeliverTrade&& on_trade, int rounds = 5) {
+    const size_t deltas = recording.deltas.size(), trades = recording.trades.size();
+    double best = 1e30;
+    for (int round = 0; round < rounds; ++round) {
+        counters.start();
+        uint64_t start = read_cycles();
+        size_t t = 0;
+        for (size_t i = 0; i < deltas; ++i) {
+            on_delta(recording.deltas[i]);
+            while (t < trades && t * deltas < (i + 1) * trades) on_trade(recording.trades[t++]);
+        }
+        uint64_t end = tsc_read<TscFence::Rdtscp>();
+        PerfReading counts = counters.stop();
+        double ns = static_cast<double>(tsc_clock().to_ns(end - start)) / static_cast<double>(recording.events());
+        if (ns < best) {
+            best = ns;
+            best_counts = counts;
+        }
+    }
+    return best;
+}
+
+void print_row(const std::string& name, double ns, const PerfReading& counts, size_t events, uint64_t checksum) {
+    std::cout << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << ns << perf_per_op(counts, events) << "   " << std::hex << checksum << std::dec
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t orders = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    Recording recording = record(orders);
+    OrderBook book;  // Handlers receive a book; these strategies do not read it
+    PerfCounters counters;
+    PerfReading counts;
+
+    std::cout << "=== STRATEGY DISPATCH BENCHMARK ===" << std::endl;
+    report_clock(std::cout);
+    std::cout << recording.deltas.size() << " level deltas and " << recording.trades.size()
+              << " trades to 3 strategies" << std::endl;
+    if (!counters.available()) {
+        std::cout << "Hardware counters unavailable (no PMU or perf_event_paranoid), shown as n/a" << std::endl;
+    }
+    std::cout << "\n" << std::left << std::setw(30) << "host" << std::right << std::setw(10) << "ns/event"
+              << perf_header() << "   checksum" << std::endl;
+
+    auto make_virtual = [] {
+        VirtualHost host;
+        host.strategies.push_back(std::make_unique<VirtualAdapter<PressureStrategy>>());
+        host.strategies.push_back(std::make_unique<VirtualAdapter<VwapStrategy>>());
+        host.strategies.push_back(std::make_unique<VirtualAdapter<SweepStrategy>>());
+        return host;
+    };
+    auto virtual_checksum = [](const VirtualHost& host) {
+        uint64_t sum = 0;
+        for (const auto& strategy : host.strategies) sum = sum * 31 + strategy->checksum();
+        return sum;
+    };
+
+    {
+        VirtualHost host = make_virtual();
+        AllocatingHost allocating{host};
+        double ns = replay(recording, counters, counts,
+                           [&](const LevelDelta& delta) { allocating.on_book_update(delta, book); },
+                           [&](const TradeEvent& event) { allocating.on_trade(event, book); });
+        print_row("virtual, new event per message", ns, counts, recording.events(), virtual_checksum(host));
+    }
+    {
+        VirtualHost host = make_virtual();
+        double ns = replay(recording, counters, counts,
+                           [&](const LevelDelta& delta) { host.on_book_update(delta, book); },
+                           [&](const TradeEvent& event) { host.on_trade(event); });
+        print_row("virtual", ns, counts, recording.events(), virtual_checksum(host));
+    }
+    {
+        RuntimeStrategyHost<PressureStrategy, VwapStrategy, SweepStrategy> host;
+        for (const char* name : {"pressure", "vwap", "sweep"}) host.add(name);
+        double ns = replay(recording, counters, counts,
+                           [&](const LevelDelta& delta) { host.on_book_update(delta, book); },
+                           [&](const TradeEvent& event) { host.on_trade(event); });
+        uint64_t sum = 0;
+        for (size_t i = 0; i < host.size(); ++i) {
+            sum = sum * 31 + std::visit([](const auto& strategy) { return strategy.checksum(); }, host[i]);
+        }
+        print_row("variant + visit", ns, counts, recording.events(), sum);
+    }
+    {
+        StrategyHost<PressureStrategy, VwapStrategy, SweepStrategy> host;
+        double ns = replay(recording, counters, counts,
+                           [&](const LevelDelta& delta) { host.on_book_update(delta, book); },
+                           [&](const TradeEvent& event) { host.on_trade(event); });
+        uint64_t sum = host.get<PressureStrategy>().checksum();
+        sum = sum * 31 + host.get<VwapStrategy>().checksum();
+        sum = sum * 31 + host.get<SweepStrategy>().checksum();
+        print_row("CRTP host", ns, counts, recording.events(), sum);
+    }
+    return 0;
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Placement of the pipeline's threads by role. Each role (feed, matcher.0,
+// matcher.1, logger, publisher, ...) may name a core, a SCHED_FIFO priority
+// and a NUMA node; a thread spawned for the role applies them to itself
+// before its body runs:
+//
+//   ThreadRuntime runtime(parse_thread_roles("feed=2:50,matcher.0=3:80,logger=0"));
+//   std::thread feed = runtime.spawn("feed", [&] { run_feed(...); });
+//
+// Applying the placement inside the new thread, and waiting for it before
+// spawn() returns, means nothing of the body ever runs on another core, and
+// the first allocation the body makes is already NUMA-local: the thread's
+// memory policy prefers its node, and an Arena built there binds to that
+// node by default (see L5/arena.hpp). Build each role's arenas and queues in
+// the role's thread wherever the design allows.
+//
+// Pinning only stops migration; to keep other tasks off the core too, boot
+// with isolcpus= (or a cpuset) and name those cores here. Placements on
+// cores outside /sys/devices/system/cpu/isolated are reported as not
+// isolated. SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit, and a FIFO
+// thread that spins can starve kernel work on its core, so give it a core of
+// its own. Failures are reported, not fatal, unless the runtime is strict.
+
+struct ThreadPlacement {
+    int core = -1;            // -1: wherever the scheduler puts it
+    int fifo_priority = 0;    // 1-99 for SCHED_FIFO; 0 keeps SCHED_OTHER
+    int numa_node = -1;       // -1: the node of `core`, if pinned
+};
+
+// What applying a placement achieved; `error` explains anything that failed
+struct PlacementResult {
+    std::string role;
+    ThreadPlacement placement;
+    bool pinned = false;
+    bool isolated = false;
+    bool realtime = false;
+    int numa_node = -1;       // Node the thread's memory policy prefers; -1 if none was set
+    std::string error;
+
+    bool ok() const { return error.empty(); }
+};
+
+// Parses a Linux cpulist such as "2-5,8"
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cores;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int core = first; core <= last; ++core) cores.push_back(core);
+    }
+    return cores;
+}
+
+// Cores taken out of general scheduling with isolcpus=; empty if none
+inline std::vector<int> isolated_cores() {
+    std::ifstream file("/sys/devices/system/cpu/isolated");
+    std::string list;
+    std::getline(file, list);
+    return parse_cpu_list(list);
+}
+
+// NUMA node of a core from sysfs; 0 on machines without NUMA topology
+inline int numa_node_of_core(int core) {
+    std::error_code error;
+    std::filesystem::path cpu = "/sys/devices/system/cpu/cpu" + std::to_string(core);
+    for (const auto& entry : std::filesystem::directory_iterator(cpu, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4) return std::stoi(name.substr(4));
+    }
+    return 0;
+}
+
+// Moves `bytes` at `p` to `node`, including pages already touched, for
+// memory that had to be allocated before its owning thread existed
+inline bool bind_memory_to_node(void* p, size_t bytes, int node) {
+    if (node < 0 || node >= 64 || bytes == 0) return false;
+    uintptr_t page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(p) + bytes;
+    unsigned long mask = 1ul << node;
+    return ::syscall(SYS_mbind, reinterpret_cast<void*>(start), end - start, MPOL_BIND, &mask, 64,
+                     MPOL_MF_MOVE) == 0;
+}
+
+// Applies `placement` to the calling thread and names it after `role`
+// (truncated to the kernel's 15 characters)
+inline PlacementResult apply_thread_placement(const std::string& role, const ThreadPlacement& placement) {
+    PlacementResult result;
+    result.role = role;
+    result.placement = placement;
+    auto fail = [&result](const std::string& what, int code) {
+        if (!result.error.empty()) result.error += "; ";
+        result.error += what + ": " + std::strerror(code);
+    };
+
+    pthread_setname_np(pthread_self(), role.substr(0, 15).c_str());
+
+    if (placement.core >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(placement.core, &cpus);
+        int status = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (status == 0) {
+            result.pinned = true;
+            for (int core : isolated_cores()) result.isolated |= core == placement.core;
+        } else {
+            fail("pin to core " + std::to_string(placement.core), status);
+        }
+    }
+
+    if (placement.fifo_priority > 0) {
+        sched_param param{};
+        param.sched_priority = placement.fifo_priority;
+        int status = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (status == 0) {
+            result.realtime = true;
+        } else {
+            fail("SCHED_FIFO priority " + std::to_string(placement.fifo_priority), status);
+        }
+    }
+
+    int node = placement.numa_node >= 0 ? placement.numa_node
+                                         : result.pinned ? numa_node_of_core(placement.core) : -1;
+    if (node >= 0 && node < 64) {
+        // Preferred rather than bound: a full node falls back instead of failing allocations
+        unsigned long mask = 1ul << node;
+        if (::syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, 64) == 0) {
+            result.numa_node = node;
+        } else {
+            fail("prefer NUMA node " + std::to_string(node), errno);
+        }
+    }
+    return result;
+}
+
+// Spawns fn() on a thread that first applies `placement`; `result` is
+// filled in before this returns. With `abort_on_failure`, a failed placement
+// ends the thread without running fn and an empty std::thread is returned.
+template<typename Fn>
+std::thread spawn_placed_thread(const std::string& role, const ThreadPlacement& placement, Fn&& fn,
+                                PlacementResult& result, bool abort_on_failure = false) {
+    std::promise<PlacementResult> placed;
+    std::future<PlacementResult> applied = placed.get_future();
+    std::promise<bool> proceed;
+    std::future<bool> go = proceed.get_future();
+    std::thread thread([role, placement, placed = std::move(placed), go = std::move(go),
+                        fn = std::forward<Fn>(fn)]() mutable {
+        placed.set_value(apply_thread_placement(role, placement));
+        if (go.get()) fn();
+    });
+    result = applied.get();
+    bool run = result.ok() || !abort_on_failure;
+    proceed.set_value(run);
+    if (!run) thread.join();
+    return thread;
+}
+
+// Role placements, e.g. "feed=2:50,matcher.0=3:80,logger=0": role=core with
+// an optional SCHED_FIFO priority, and a NUMA node after '@' when it should
+// differ from the core's ("publisher=6@1")
+inline std::map<std::string, ThreadPlacement> parse_thread_roles(const std::string& spec) {
+    std::map<std::string, ThreadPlacement> roles;
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string entry = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (entry.empty()) continue;
+        size_t equals = entry.find('=');
+        if (equals == std::string::npos || equals == 0) {
+            throw std::runtime_error("Thread role entry must be role=core[:priority][@node]: " + entry);
+        }
+        ThreadPlacement placement;
+        std::string value = entry.substr(equals + 1);
+        try {
+            size_t at = value.find('@');
+            if (at != std::string::npos) {
+                placement.numa_node = std::stoi(value.substr(at + 1));
+                value = value.substr(0, at);
+            }
+            size_t colon = value.find(':');
+            placement.core = std::stoi(value.substr(0, colon));
+            if (colon != std::string::npos) placement.fifo_priority = std::stoi(value.substr(colon + 1));
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Thread role entry must be role=core[:priority][@node]: " + entry);
+        }
+        if (placement.fifo_priority < 0 || placement.fifo_priority > 99) {
+            throw std::runtime_error("SCHED_FIFO priority must be 1-99: " + entry);
+        }
+        roles[entry.substr(0, equals)] = placement;
+    }
+    return roles;
+}
+
+// Spawns threads by role with their configured placement and keeps what
+// each placement achieved. spawn() is meant for startup, from one thread.
+class ThreadRuntime {
+public:
+    ThreadRuntime() = default;
+    explicit ThreadRuntime(std::map<std::string, ThreadPlacement> roles, bool strict = false)
+        : roles_(std::move(roles)), strict_(strict) {}
+
+    // Roles from an environment variable in parse_thread_roles() form; none if unset
+    static ThreadRuntime from_env(const char* variable = "THREAD_ROLES", bool strict = false) {
+        const char* spec = std::getenv(variable);
+        return ThreadRuntime(spec ? parse_thread_roles(spec) : std::map<std::string, ThreadPlacement>{}, strict);
+    }
+
+    // Placement of `role`: "matcher.3" falls back to "matcher" if only that is
+    // configured; unconfigured roles run unpinned
+    ThreadPlacement placement(const std::string& role) const {
+        auto it = roles_.find(role);
+        if (it == roles_.end()) {
+            size_t dot = role.rfind('.');
+            if (dot != std::string::npos) it = roles_.find(role.substr(0, dot));
+        }
+        return it != roles_.end() ? it->second : ThreadPlacement{};
+    }
+
+    void set_placement(const std::string& role, const ThreadPlacement& placement) { roles_[role] = placement; }
+
+    // Starts fn() on a new thread placed for `role`, once the placement is
+    // applied. Strict runtimes throw if any of it failed, after joining the
+    // thread, which then never runs fn.
+    template<typename Fn>
+    std::thread spawn(const std::string& role, Fn&& fn) {
+        PlacementResult result;
+        std::thread thread = spawn_placed_thread(role, placement(role), std::forward<Fn>(fn), result, strict_);
+        results_.push_back(result);
+        if (!thread.joinable()) {
+            throw std::runtime_error("Thread role " + role + " placement failed: " + result.error);
+        }
+        return thread;
+    }
+
+    // One entry per spawn(), in order
+    const std::vector<PlacementResult>& results() const { return results_; }
+
+private:
+    std::map<std::string, ThreadPlacement> roles_;
+    bool strict_ = false;
+    std::vector<PlacementResult> results_;
+};
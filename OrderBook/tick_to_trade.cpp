@@ -0,0 +1,290 @@
+// Reference tick-to-trade pipeline with a per-stage latency breakdown.
+//
+//   feed thread:  receive -> sequence -> Fifo4 push
+//   book thread:  Fifo4 pop -> apply to the instrument's book -> strategy
+//
+// Each stage boundary is stamped with the TSC, and the stamps travel with
+// the message through the queue, so every sample is measured on the book
+// thread after the fact and nothing on the hot path is shared. The TSC is
+// invariant and synchronised across cores on current x86, so stamps from
+// the two threads can be subtracted directly. Exchange to receive is on the
+// wall clock, since the exchange stamps messages with CLOCK_REALTIME: the
+// receive stamp is converted with tsc_clock(), which is calibrated against it.
+//
+// Receive stamps are taken once per receive() batch: everything the kernel
+// had queued arrives at the same instant, and later records in a batch
+// show the cost of waiting behind earlier ones as sequencing time.
+//
+// Drive it with market_sim:
+//   g++ -std=c++20 -O2 -pthread tick_to_trade.cpp -o tick_to_trade
+//   ../L1/mocks/market_sim --rate=200000 --count=1000000 &
+//   ./tick_to_trade [feed_core book_core [messages [recv|uring]]]
+//
+// Cores default to -1 (unpinned); unpinned threads yield while polling so
+// the pipeline still runs on a single core. The threads run as the "feed"
+// and "matcher.0" roles of thread_runtime.hpp, so THREAD_ROLES can also
+// place them, with SCHED_FIFO and a NUMA node, e.g.
+// THREAD_ROLES=feed=2:50,matcher.0=3:80; cores given as arguments win. Build with -DENABLE_PROBES to
+// also get the book's probed sections (submit_order, process_matching, ...)
+// on stderr once a second.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "order_book.hpp"
+#include "book_manager.hpp"
+#include "latency.hpp"
+#include "thread_runtime.hpp"
+#include "../L1/mocks/feed_receiver.hpp"
+#include "../L1/mocks/feed_sequencer.hpp"
+#include "../L1/mocks/uring_feed_receiver.hpp"
+#include "../L1/mocks/wire_format.hpp"
+
+namespace {
+
+struct PipelineConfig {
+    int feed_core = -1;
+    int book_core = -1;
+    uint64_t messages = 1000000;
+    uint32_t instruments = 1024;  // Books preallocated; must cover market_sim --instruments
+    std::string backend = "recv";
+};
+
+// One sequenced message and the stamps taken on the feed thread
+struct TickEvent {
+    WireMessage message;
+    uint64_t rx_cycles;
+    uint64_t sequenced_cycles;
+    uint64_t rx_wall_ns;
+};
+
+// Busy-polls with a pause, yielding every 1024 misses when not pinned
+template<typename Op>
+void spin_until(Op&& op, bool pinned) {
+    for (uint32_t misses = 0; !op(); ++misses) {
+        _mm_pause();
+        if (!pinned && (misses & 1023) == 1023) std::this_thread::yield();
+    }
+}
+
+void report_placement(const PlacementResult& result) {
+    if (!result.ok()) {
+        std::cerr << "warning: " << result.role << " thread: " << result.error << std::endl;
+    } else if (result.pinned && !result.isolated) {
+        std::cerr << "note: " << result.role << " thread is pinned to core " << result.placement.core
+                  << ", which is not isolated" << std::endl;
+    }
+}
+
+// Example strategy: quotes inside the spread whenever a book update leaves it
+// at least `min_spread` wide. Stands in for real signal code; only counts.
+struct SpreadStrategy {
+    double min_spread = 0.0010;
+    uint64_t decisions = 0;
+    uint64_t orders = 0;
+
+    void on_book_update(uint32_t, const WireMessage&, const OrderBook& book) {
+        ++decisions;
+        double bid = book.get_best_bid();
+        double ask = book.get_best_ask();
+        if (bid > 0.0 && ask > 0.0 && ask - bid >= min_spread) ++orders;
+    }
+};
+
+// Sequenced messages from the feed thread into the queue; recovery requests are
+// only counted, as in MarketFeed
+struct QueueHandler {
+    Fifo4<TickEvent>& queue;
+    bool pinned;
+    uint64_t rx_cycles = 0;
+    uint64_t rx_wall_ns = 0;
+    uint64_t full_stalls = 0;
+    uint64_t recovery_requests = 0;
+
+    void on_sequenced(const WireMessage& message) {
+        TickEvent event{message, rx_cycles, read_cycles(), rx_wall_ns};
+        if (!queue.push(event)) {
+            ++full_stalls;  // Backpressure: the book thread is behind
+            spin_until([&] { return queue.push(event); }, pinned);
+        }
+    }
+
+    void on_replay_request(uint16_t, uint64_t, uint64_t) { ++recovery_requests; }
+    void on_snapshot_request(uint16_t, uint64_t) { ++recovery_requests; }
+};
+
+// Market-by-order update for one book; matching is the exchange's job, so
+// orders rest as published and trades reduce the resting order hit
+void apply(OrderBook& book, const WireMessage& message) {
+    switch (message.header.type) {
+    case MessageType::AddOrder:
+        book.add_order(Order{message.order_id, message.side == WireSide::Buy, message.price_as_double(),
+                             message.quantity, message.header.timestamp_ns},
+                       false);
+        break;
+    case MessageType::CancelOrder:
+        book.cancel_order(message.order_id);
+        break;
+    case MessageType::Trade: {
+        Order resting;
+        if (!book.get_order(message.order_id, resting)) break;
+        if (message.quantity >= resting.quantity) {
+            book.cancel_order(message.order_id);
+        } else {
+            book.amend_order(message.order_id, resting.price, resting.quantity - message.quantity, false);
+        }
+        break;
+    }
+    case MessageType::Heartbeat:
+    case MessageType::LevelUpdate:  // Market-by-price channels are not applied to these books
+    case MessageType::BookClear:
+    case MessageType::SnapshotEnd:
+        break;
+    }
+}
+
+template<typename Feed>
+void run_feed(Feed& feed, FeedSequencer<QueueHandler>& sequencer, QueueHandler& handler,
+              const PipelineConfig& config, std::atomic<bool>& done) {
+    uint64_t count = 0;
+    while (count < config.messages && !feed.closed()) {
+        auto records = feed.receive();
+        if (records.empty()) {
+            feed.wait(1);
+            continue;
+        }
+        handler.rx_cycles = read_cycles();
+        handler.rx_wall_ns = tsc_clock().to_epoch_ns(handler.rx_cycles);
+        for (const WireMessage& message : records) {
+            if (message.header.version != wire_version) continue;
+            sequencer.on_message(message);
+            if (++count == config.messages) break;
+        }
+    }
+    done.store(true, std::memory_order_release);
+}
+
+template<typename Feed, typename Strategy>
+void run_pipeline(Feed& feed, Strategy& strategy, const PipelineConfig& config, ThreadRuntime& runtime) {
+    Fifo4<TickEvent> queue(65536);
+    QueueHandler handler{queue, runtime.placement("feed").core >= 0};
+    FeedSequencer<QueueHandler> sequencer(handler, 16, {.window = 1024});
+
+    std::vector<std::unique_ptr<OrderBook>> books;
+    books.reserve(config.instruments);
+    for (uint32_t i = 0; i < config.instruments; ++i) {
+        books.push_back(std::make_unique<OrderBook>());
+        books.back()->reserve_orders(4096);
+    }
+
+    size_t capacity = config.messages;
+    LatencyStats wire(capacity), sequence(capacity), hop(capacity), update(capacity), decide(capacity),
+        total(capacity);
+    std::atomic<bool> done{false};
+    uint64_t processed = 0;
+    uint64_t rejected = 0;
+
+    std::thread book_thread = runtime.spawn("matcher.0", [&] {
+        bool pinned = runtime.placement("matcher.0").core >= 0;
+        TickEvent event;
+        for (uint32_t misses = 0;;) {
+            if (!queue.pop(event)) {
+                if (done.load(std::memory_order_acquire) && !queue.pop(event)) break;
+                _mm_pause();
+                if (!pinned && (++misses & 1023) == 0) std::this_thread::yield();
+                continue;
+            }
+            uint64_t dequeued = read_cycles();
+            const WireMessage& message = event.message;
+            if (message.header.instrument >= books.size()) {
+                ++rejected;
+                continue;
+            }
+            OrderBook& book = *books[message.header.instrument];
+            try {
+                apply(book, message);
+            } catch (const std::runtime_error&) {
+                ++rejected;  // Inconsistent with the book, e.g. after a lost snapshot
+                continue;
+            }
+            uint64_t updated = read_cycles();
+            strategy.on_book_update(message.header.instrument, message, book);
+            uint64_t decided = read_cycles();
+
+            ++processed;
+            if (event.rx_wall_ns > message.header.timestamp_ns) {
+                wire.record(event.rx_wall_ns - message.header.timestamp_ns);
+            }
+            sequence.record(event.sequenced_cycles - event.rx_cycles);
+            hop.record(dequeued - event.sequenced_cycles);
+            update.record(updated - dequeued);
+            decide.record(decided - updated);
+            total.record(decided - event.rx_cycles);
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread feed_thread = runtime.spawn("feed", [&] { run_feed(feed, sequencer, handler, config, done); });
+    for (const PlacementResult& result : runtime.results()) report_placement(result);
+    feed_thread.join();
+    book_thread.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    double cycles_per_ns = calibrate_cycles_per_ns();
+    uint64_t overhead = timer_overhead_cycles();
+    std::cout << processed << " messages in " << elapsed.count() << " us, " << feed.syscalls()
+              << " syscalls, " << rejected << " rejected, " << handler.full_stalls << " queue full stalls, "
+              << handler.recovery_requests << " recovery requests\n";
+    std::cout << "strategy: " << strategy.decisions << " decisions, " << strategy.orders << " orders\n\n";
+    std::cout << std::left << std::setw(34) << "stage" << std::right
+              << std::setw(9) << "count" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(12) << "max (ns)" << std::endl;
+    wire.report("exchange -> receive (wall clock)", 1.0, 0);
+    sequence.report("receive -> sequenced", cycles_per_ns, overhead);
+    hop.report("sequenced -> dequeued (Fifo4)", cycles_per_ns, overhead);
+    update.report("dequeued -> book updated", cycles_per_ns, overhead);
+    decide.report("book updated -> decision", cycles_per_ns, overhead);
+    total.report("receive -> decision", cycles_per_ns, overhead);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    PipelineConfig config;
+    if (argc > 2) {
+        config.feed_core = std::atoi(argv[1]);
+        config.book_core = std::atoi(argv[2]);
+    }
+    if (argc > 3) {
+        config.messages = std::strtoull(argv[3], nullptr, 10);
+    }
+    if (argc > 4) {
+        config.backend = argv[4];
+    }
+
+    // Calibrates the clock before any stamp is taken
+    report_clock(std::cout);
+#ifdef ENABLE_PROBES
+    ProbeReporter probes(std::cerr, std::chrono::seconds(1));
+#endif
+    ThreadRuntime runtime = ThreadRuntime::from_env();
+    if (config.feed_core >= 0) runtime.set_placement("feed", ThreadPlacement{config.feed_core});
+    if (config.book_core >= 0) runtime.set_placement("matcher.0", ThreadPlacement{config.book_core});
+    SpreadStrategy strategy;
+    int sock = connect_feed("localhost", 5555);
+    if (config.backend == "uring") {
+        UringFeedReceiver<WireMessage> feed(sock);
+        run_pipeline(feed, strategy, config, runtime);
+    } else {
+        FeedReceiver<WireMessage> feed(sock);
+        run_pipeline(feed, strategy, config, runtime);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Invariant-TSC clock for order stamps and latency instrumentation: a TSC
+// read and a multiply instead of a clock_gettime() call, with resolution
+// below a nanosecond.
+//
+// TscClock is calibrated against CLOCK_REALTIME, so now_ns() is nanoseconds
+// since the Unix epoch like the exchange's stamps and the system clock the
+// book used before. Conversion is Linux's cyc2ns: ns = cycles * mult >> shift
+// with a 128-bit product. The rate is good to about a part per million from a
+// 50 ms window, so stamps drift from the system clock by up to a microsecond
+// per second; they do not follow NTP slews either. Recalibrate long-running
+// processes if wall-clock agreement matters, not just intervals.
+//
+// The TSC must be invariant (constant rate through P- and C-states) and
+// synchronised across cores, which current x86 servers are. tsc_invariant()
+// checks the first, check_cores() measures the second. Off x86, reads fall
+// back to steady_clock ticks and the conversion is the identity.
+
+enum class TscFence : uint8_t {
+    None,     // Bare rdtsc: cheapest, may execute out of order with nearby work
+    LFence,   // lfence; rdtsc; lfence: earlier loads finished, later work not started
+    Rdtscp    // rdtscp; lfence: every earlier instruction finished, as at the end of a timed region
+};
+
+template<TscFence Fence = TscFence::LFence>
+inline uint64_t tsc_read() {
+#if defined(__x86_64__) || defined(__i386__)
+    if constexpr (Fence == TscFence::None) {
+        return __rdtsc();
+    } else if constexpr (Fence == TscFence::LFence) {
+        _mm_lfence();
+        uint64_t tsc = __rdtsc();
+        _mm_lfence();
+        return tsc;
+    } else {
+        unsigned aux;
+        uint64_t tsc = __rdtscp(&aux);
+        _mm_lfence();
+        return tsc;
+    }
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// CPUID 0x80000007 EDX bit 8: the TSC ticks at a constant rate in every state
+inline bool tsc_invariant() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+inline uint64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Worst TSC disagreement between the cores this thread may run on
+struct TscCoreCheck {
+    int cpus = 0;
+    int worst_cpu = -1;
+    double max_offset_ns = 0.0;   // Against the calibrating core, within the measurement error
+    double error_ns = 0.0;        // Widest clock_gettime() bracket used
+};
+
+class TscClock {
+public:
+    // Measures the TSC rate against CLOCK_REALTIME over `window`
+    static TscClock calibrate(std::chrono::milliseconds window = std::chrono::milliseconds(50)) {
+        TscClock clock;
+#if defined(__x86_64__) || defined(__i386__)
+        Anchor start = anchor();
+        std::this_thread::sleep_for(window);
+        Anchor end = anchor();
+        double cycles_per_ns = static_cast<double>(end.tsc - start.tsc) / static_cast<double>(end.ns - start.ns);
+        clock.cycles_per_ns_ = cycles_per_ns;
+        clock.mult_ = static_cast<uint64_t>(static_cast<double>(uint64_t{1} << shift) / cycles_per_ns + 0.5);
+        clock.base_tsc_ = end.tsc;
+        clock.base_ns_ = end.ns;
+#else
+        (void)window;
+        clock.cycles_per_ns_ = 1.0;
+        clock.mult_ = uint64_t{1} << shift;
+        clock.base_tsc_ = tsc_read<TscFence::None>();
+        clock.base_ns_ = realtime_ns();
+#endif
+        return clock;
+    }
+
+    // Cycles to nanoseconds, for differences of tsc_read() stamps
+    uint64_t to_ns(uint64_t cycles) const {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(cycles) * mult_) >> shift);
+    }
+
+    // Nanoseconds since the Unix epoch for a stamp taken after calibration
+    uint64_t to_epoch_ns(uint64_t tsc) const { return base_ns_ + to_ns(tsc - base_tsc_); }
+
+    uint64_t now_ns() const { return to_epoch_ns(tsc_read<TscFence::None>()); }
+
+    double cycles_per_ns() const { return cycles_per_ns_; }
+
+    // Runs on every CPU in the thread's affinity mask in turn and compares
+    // its TSC, converted to wall time, with CLOCK_REALTIME. The thread's
+    // affinity is restored afterwards.
+    TscCoreCheck check_cores() const {
+        TscCoreCheck result;
+        cpu_set_t original;
+        if (pthread_getaffinity_np(pthread_self(), sizeof(original), &original) != 0) return result;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (!CPU_ISSET(cpu, &original)) continue;
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(one), &one) != 0) continue;
+            Anchor sample = anchor();
+            double offset = std::abs(static_cast<double>(to_epoch_ns(sample.tsc)) - static_cast<double>(sample.ns));
+            result.cpus++;
+            result.error_ns = std::max(result.error_ns, static_cast<double>(sample.error_cycles) / cycles_per_ns_);
+            if (result.worst_cpu < 0 || offset > result.max_offset_ns) {
+                result.max_offset_ns = offset;
+                result.worst_cpu = cpu;
+            }
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(original), &original);
+        return result;
+    }
+
+private:
+    static constexpr unsigned shift = 32;
+
+    struct Anchor {
+        uint64_t tsc;
+        uint64_t ns;
+        uint64_t error_cycles;
+    };
+
+    // A (TSC, wall clock) pair from the tightest of a few bracketed reads,
+    // with the TSC taken as the middle of its bracket
+    static Anchor anchor() {
+        Anchor best{0, 0, UINT64_MAX};
+        for (int i = 0; i < 64; ++i) {
+            uint64_t before = tsc_read<TscFence::LFence>();
+            uint64_t ns = realtime_ns();
+            uint64_t after = tsc_read<TscFence::LFence>();
+            uint64_t half_width = (after - before) / 2;
+            if (half_width < best.error_cycles) {
+                best = Anchor{before + half_width, ns, half_width};
+            }
+        }
+        return best;
+    }
+
+    double cycles_per_ns_ = 1.0;
+    uint64_t mult_ = uint64_t{1} << shift;
+    uint64_t base_tsc_ = 0;
+    uint64_t base_ns_ = 0;
+};
+
+// Process-wide clock, calibrated on first use (50 ms). Call it once at
+// startup so the calibration does not land on the first order.
+inline const TscClock& tsc_clock() {
+    static const TscClock clock = TscClock::calibrate();
+    return clock;
+}
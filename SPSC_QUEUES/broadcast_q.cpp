@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "cache_line.hpp"
+
+
+/// What the writer does when the slowest reader is a full ring behind
+enum class BroadcastOverflow
+{
+    Block,      ///< push() fails until the slowest reader catches up
+    Overwrite,  ///< push() always succeeds; lapped readers skip ahead and count the loss
+};
+
+/// Outcome of BroadcastRing::pop()
+enum class BroadcastRead
+{
+    Value,   ///< `value` holds the next object
+    Empty,   ///< Reader is up to date
+    Lapped,  ///< Writer overwrote unread objects; the reader now resumes at the oldest one kept
+};
+
+/// Single-producer, multi-consumer broadcast ring (disruptor style).
+/// Every object is written once and read by each of `readers` consumers
+/// through its own padded cursor, so fan-out costs no extra copies in the ring.
+/// The writer gates on the slowest reader (Block) or overwrites (Overwrite),
+/// in which case every slot carries a sequence number so a reader can tell it
+/// raced with the writer. Slots are copied as relaxed atomic words, as in
+/// SeqLock, so T must be trivially copyable.
+template<typename T, typename Alloc = std::allocator<T>>
+class BroadcastRing
+{
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    using CursorType = std::atomic<std::uint64_t>;
+    static_assert(CursorType::is_always_lock_free);
+
+    struct Slot {
+        /// Cursor + 1 of the object held; 0 while the writer is replacing it
+        CursorType sequence{0};
+        std::atomic<std::uint64_t> words[word_count];
+    };
+
+    /// One line per reader: the writer only ever loads `cursor`
+    struct alignas(cache_line_size) ReaderState {
+        CursorType cursor{0};
+        std::uint64_t writeCursorCached = 0;
+        std::uint64_t lost = 0;
+    };
+
+    using SlotAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Slot>;
+    using ReaderAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<ReaderState>;
+
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    using value_type = T;
+    using size_type = std::uint64_t;
+
+    /// `capacity` is rounded up to the next power of two
+    BroadcastRing(size_type capacity, std::size_t readers, BroadcastOverflow overflow = BroadcastOverflow::Block,
+                  Alloc const& alloc = Alloc{})
+        : slotAlloc_{alloc}
+        , readerAlloc_{alloc}
+        , capacity_{std::bit_ceil(capacity < 1 ? size_type{1} : capacity)}
+        , mask_{capacity_ - 1}
+        , readerCount_{readers}
+        , overflow_{overflow}
+    {
+        slots_ = std::allocator_traits<SlotAlloc>::allocate(slotAlloc_, capacity_);
+        for (size_type i = 0; i < capacity_; ++i) {
+            std::allocator_traits<SlotAlloc>::construct(slotAlloc_, &slots_[i]);
+        }
+        readers_ = std::allocator_traits<ReaderAlloc>::allocate(readerAlloc_, readerCount_);
+        for (std::size_t i = 0; i < readerCount_; ++i) {
+            std::allocator_traits<ReaderAlloc>::construct(readerAlloc_, &readers_[i]);
+        }
+    }
+
+    BroadcastRing(BroadcastRing const&) = delete;
+    BroadcastRing& operator=(BroadcastRing const&) = delete;
+
+    ~BroadcastRing() {
+        std::allocator_traits<ReaderAlloc>::deallocate(readerAlloc_, readers_, readerCount_);
+        std::allocator_traits<SlotAlloc>::deallocate(slotAlloc_, slots_, capacity_);
+    }
+
+
+    /// Returns the number of objects that can be held in the ring
+    auto capacity() const noexcept { return capacity_; }
+
+    /// Returns the number of readers fixed at construction
+    auto readers() const noexcept { return readerCount_; }
+
+    /// Returns the number of objects published so far
+    auto published() const noexcept { return writeCursor_.load(std::memory_order_relaxed); }
+
+    /// Returns how many objects `reader` has yet to read (may exceed capacity when lapped)
+    auto backlog(std::size_t reader) const noexcept {
+        return published() - readers_[reader].cursor.load(std::memory_order_relaxed);
+    }
+
+    /// Returns how many objects `reader` has skipped after being lapped; call from that reader's thread
+    auto lost(std::size_t reader) const noexcept { return readers_[reader].lost; }
+
+
+    /// Publish one object to every reader. Must only be called from the writer thread.
+    /// @return `true` if the operation is successful; `false` if blocking and the slowest reader is a ring behind.
+    auto push(T const& value) {
+        auto writeCursor = writeCursor_.load(std::memory_order_relaxed);
+        if (overflow_ == BroadcastOverflow::Block and writeCursor - slowestReaderCached_ == capacity_) {
+            slowestReaderCached_ = slowest_reader();
+            if (writeCursor - slowestReaderCached_ == capacity_) {
+                return false;
+            }
+        }
+
+        std::uint64_t words[word_count] = {};
+        std::memcpy(words, &value, sizeof(T));
+        Slot& slot = slots_[writeCursor & mask_];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < word_count; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(writeCursor + 1, std::memory_order_release);
+        writeCursor_.store(writeCursor + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Read the next object for `reader`. Each reader index must be used by one thread only.
+    auto pop(std::size_t reader, T& value) {
+        ReaderState& state = readers_[reader];
+        auto cursor = state.cursor.load(std::memory_order_relaxed);
+        if (cursor == state.writeCursorCached) {
+            state.writeCursorCached = writeCursor_.load(std::memory_order_acquire);
+            if (cursor == state.writeCursorCached) {
+                return BroadcastRead::Empty;
+            }
+        }
+        if (state.writeCursorCached - cursor > capacity_) {
+            return skip_ahead(state, cursor);
+        }
+
+        Slot& slot = slots_[cursor & mask_];
+        std::uint64_t words[word_count];
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != cursor + 1) {
+            // Overwritten while we copied; only possible with BroadcastOverflow::Overwrite
+            state.writeCursorCached = writeCursor_.load(std::memory_order_acquire);
+            return skip_ahead(state, cursor);
+        }
+        std::memcpy(&value, words, sizeof(T));
+        state.cursor.store(cursor + 1, std::memory_order_release);
+        return BroadcastRead::Value;
+    }
+
+private:
+    auto slowest_reader() const noexcept {
+        auto slowest = writeCursor_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < readerCount_; ++i) {
+            slowest = std::min(slowest, readers_[i].cursor.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+    /// Move a lapped reader to the oldest object the writer will not touch next
+    auto skip_ahead(ReaderState& state, size_type cursor) noexcept {
+        auto resume = state.writeCursorCached - capacity_ + 1;
+        state.lost += resume - cursor;
+        state.cursor.store(resume, std::memory_order_release);
+        return BroadcastRead::Lapped;
+    }
+
+private:
+    [[no_unique_address]] SlotAlloc slotAlloc_;
+    [[no_unique_address]] ReaderAlloc readerAlloc_;
+    size_type capacity_;
+    size_type mask_;
+    std::size_t readerCount_;
+    BroadcastOverflow overflow_;
+    Slot* slots_;
+    ReaderState* readers_;
+
+    /// Loaded and stored by the writer; loaded by every reader
+    alignas(cache_line_size) CursorType writeCursor_{0};
+
+    /// Exclusive to the writer
+    alignas(cache_line_size) size_type slowestReaderCached_{0};
+
+    // Padding to avoid false sharing with adjacent objects
+    char padding_[cache_line_size - sizeof(size_type)];
+};
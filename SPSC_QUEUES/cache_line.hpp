@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+
+/// Cache line size used to keep independently written state on separate lines.
+///
+/// N.B. std::hardware_destructive_interference_size is not used directly
+/// error: use of ‘std::hardware_destructive_interference_size’ [-Werror=interference-size]
+/// note: its value can vary between compiler versions or with different ‘-mtune’ or ‘-mcpu’ flags
+/// note: if this use is part of a public ABI, change it to instead use a constant variable you define
+/// note: the default value for the current CPU tuning is 64 bytes
+/// note: you can stabilize this value with ‘--param hardware_destructive_interference_size=64’, or disable this warning with ‘-Wno-interference-size’
+inline constexpr std::size_t cache_line_size = 64;
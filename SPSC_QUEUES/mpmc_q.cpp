@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "cache_line.hpp"
+
+
+/// Bounded lock-free multi-producer multi-consumer FIFO (Vyukov).
+/// Every slot carries a sequence number saying whose turn it is: a producer
+/// may fill slot `pos` once its sequence equals `pos`, a consumer may empty it
+/// once the sequence equals `pos + 1`. Neither side ever reads the other's
+/// cursor, and threads on the same side only contend on their own cursor's CAS.
+template<typename T, typename Alloc = std::allocator<T>>
+class MpmcFifo : private Alloc
+{
+public:
+    using value_type = T;
+    using allocator_traits = std::allocator_traits<Alloc>;
+    using size_type = typename allocator_traits::size_type;
+
+    /// `capacity` is rounded up to a power of two and at least 2, which the
+    /// sequence scheme needs to tell a full slot from an empty one
+    explicit MpmcFifo(size_type capacity, Alloc const& alloc = Alloc{})
+        : Alloc{alloc}
+        , capacity_{std::bit_ceil(std::max(capacity, size_type{2}))}
+        , mask_{capacity_ - 1}
+    {
+        SlotAlloc slotAlloc{*this};
+        slots_ = slot_traits::allocate(slotAlloc, capacity_);
+        for (size_type i = 0; i < capacity_; ++i) {
+            slot_traits::construct(slotAlloc, &slots_[i], i);
+        }
+    }
+
+    MpmcFifo(MpmcFifo const&) = delete;
+    MpmcFifo& operator=(MpmcFifo const&) = delete;
+
+    ~MpmcFifo() {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        for (auto cursor = popCursor_.load(std::memory_order_relaxed); cursor != pushCursor; ++cursor) {
+            slots_[cursor & mask_].element()->~T();
+        }
+        SlotAlloc slotAlloc{*this};
+        for (size_type i = 0; i < capacity_; ++i) {
+            slot_traits::destroy(slotAlloc, &slots_[i]);
+        }
+        slot_traits::deallocate(slotAlloc, slots_, capacity_);
+    }
+
+
+    /// Returns the number of elements in the fifo; only a hint while threads are active
+    auto size() const noexcept {
+        // Pop first: the push cursor read afterwards can only be larger
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+
+        assert(popCursor <= pushCursor);
+        return pushCursor - popCursor;
+    }
+
+    /// Returns whether the container has no elements
+    auto empty() const noexcept { return size() == 0; }
+
+    /// Returns whether the container has capacity_() elements
+    auto full() const noexcept { return size() >= capacity(); }
+
+    /// Returns the number of elements that can be held in the fifo
+    auto capacity() const noexcept { return capacity_; }
+
+
+    /// Push one object onto the fifo. Safe from any number of threads.
+    /// @return `true` if the operation is successful; `false` if fifo is full.
+    auto push(T const& value) {
+        return emplace(value);
+    }
+
+    /// Construct one object in place at the back of the fifo. Safe from any number of threads.
+    /// @return `true` if the operation is successful; `false` if fifo is full.
+    template<typename... Args>
+    auto emplace(Args&&... args) {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pushCursor & mask_];
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::intptr_t>(sequence - pushCursor);
+            if (lag == 0) {
+                if (pushCursor_.compare_exchange_weak(pushCursor, pushCursor + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;  // Slot still holds the element from one lap ago
+            } else {
+                pushCursor = pushCursor_.load(std::memory_order_relaxed);
+            }
+        }
+        new (slot->element()) T(std::forward<Args>(args)...);
+        slot->sequence.store(pushCursor + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Pop one object from the fifo. Safe from any number of threads.
+    /// @return `true` if the pop operation is successful; `false` if fifo is empty.
+    auto pop(T& value) {
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[popCursor & mask_];
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::intptr_t>(sequence - (popCursor + 1));
+            if (lag == 0) {
+                if (popCursor_.compare_exchange_weak(popCursor, popCursor + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;  // Slot not yet filled
+            } else {
+                popCursor = popCursor_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(*slot->element());
+        slot->element()->~T();
+        slot->sequence.store(popCursor + capacity_, std::memory_order_release);
+        return true;
+    }
+
+private:
+    using CursorType = std::atomic<size_type>;
+    static_assert(CursorType::is_always_lock_free);
+
+    /// One cache line per slot so neighbouring producers and consumers do not false-share
+    struct alignas(cache_line_size) Slot {
+        explicit Slot(size_type initial) : sequence{initial} {}
+
+        T* element() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+
+        CursorType sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    using SlotAlloc = typename allocator_traits::template rebind_alloc<Slot>;
+    using slot_traits = std::allocator_traits<SlotAlloc>;
+
+    size_type capacity_;
+    size_type mask_;
+    Slot* slots_;
+
+    /// Claimed by push threads
+    alignas(cache_line_size) CursorType pushCursor_{0};
+
+    /// Claimed by pop threads
+    alignas(cache_line_size) CursorType popCursor_{0};
+
+    // Padding to avoid false sharing with adjacent objects
+    char padding_[cache_line_size - sizeof(size_type)];
+};
@@ -0,0 +1,147 @@
+// Throughput of many producers feeding one consumer:
+// one Fifo4 per producer polled round-robin, against a shared MpscFifo and MpmcFifo.
+// Every consumer checks that each producer's messages arrive in order.
+//
+//   g++ -std=c++20 -O2 -pthread mpsc_bench.cpp -o mpsc_bench
+//   ./mpsc_bench [producers] [messages per producer]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_q4.cpp"
+#include "mpsc_q.cpp"
+#include "mpmc_q.cpp"
+
+namespace {
+
+constexpr std::size_t queue_capacity = 4096;
+
+// Producer id in the top bits, per-producer sequence in the rest
+std::uint64_t encode(std::size_t producer, std::uint64_t sequence) { return (std::uint64_t(producer) << 48) | sequence; }
+std::size_t producer_of(std::uint64_t message) { return message >> 48; }
+std::uint64_t sequence_of(std::uint64_t message) { return message & ((std::uint64_t(1) << 48) - 1); }
+
+// Tracks the next expected sequence of every producer seen by one consumer
+class OrderCheck {
+public:
+    explicit OrderCheck(std::size_t producers) : next_(producers, 0) {}
+
+    void on_message(std::uint64_t message) {
+        auto& next = next_[producer_of(message)];
+        if (sequence_of(message) < next) {
+            throw std::runtime_error("Message from producer " + std::to_string(producer_of(message)) + " reordered");
+        }
+        next = sequence_of(message) + 1;
+        received_++;
+    }
+
+    std::uint64_t received() const { return received_; }
+
+private:
+    std::vector<std::uint64_t> next_;
+    std::uint64_t received_ = 0;
+};
+
+void report(const std::string& name, std::uint64_t messages, std::chrono::steady_clock::duration elapsed) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << messages / seconds / 1e6 << " Mmsg/s"
+              << std::setw(10) << seconds * 1e9 / messages << " ns/msg" << std::endl;
+}
+
+// Today's layout: a private Fifo4 per producer and a consumer polling them all
+void run_spsc_per_producer(std::size_t producers, std::uint64_t messages) {
+    std::vector<std::unique_ptr<Fifo4<std::uint64_t>>> queues;
+    for (std::size_t p = 0; p < producers; ++p) {
+        queues.push_back(std::make_unique<Fifo4<std::uint64_t>>(queue_capacity));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (std::uint64_t i = 0; i < messages; ) {
+                if (queues[p]->push(encode(p, i))) ++i; else std::this_thread::yield();
+            }
+        });
+    }
+    OrderCheck check(producers);
+    std::uint64_t message;
+    while (check.received() < producers * messages) {
+        bool any = false;
+        for (auto& queue : queues) {
+            while (queue->pop(message)) {
+                check.on_message(message);
+                any = true;
+            }
+        }
+        if (not any) std::this_thread::yield();
+    }
+    for (auto& thread : threads) thread.join();
+    report(std::to_string(producers) + " x Fifo4, polled", producers * messages, std::chrono::steady_clock::now() - start);
+}
+
+template<typename Queue>
+void run_shared(const std::string& name, std::size_t producers, std::size_t consumers, std::uint64_t messages) {
+    Queue queue(queue_capacity);
+    std::atomic<std::uint64_t> received{0};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (std::uint64_t i = 0; i < messages; ) {
+                if (queue.push(encode(p, i))) ++i; else std::this_thread::yield();
+            }
+        });
+    }
+    for (std::size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            OrderCheck check(producers);
+            std::uint64_t message;
+            while (received.load(std::memory_order_relaxed) < producers * messages) {
+                if (queue.pop(message)) {
+                    check.on_message(message);
+                    received.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    if (received.load() != producers * messages || not queue.empty()) {
+        throw std::runtime_error(name + ": lost or duplicated messages");
+    }
+    report(name, producers * messages, std::chrono::steady_clock::now() - start);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t producers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    std::uint64_t messages = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    if (producers == 0) return 1;
+
+    std::cout << "=== " << producers << " producers, " << messages << " messages each, capacity "
+              << queue_capacity << " (" << std::thread::hardware_concurrency() << " cpus) ===" << std::endl;
+    try {
+        run_spsc_per_producer(producers, messages);
+        run_shared<MpscFifo<std::uint64_t>>("MpscFifo, 1 consumer", producers, 1, messages);
+        run_shared<MpmcFifo<std::uint64_t>>("MpmcFifo, 1 consumer", producers, 1, messages);
+        run_shared<MpmcFifo<std::uint64_t>>("MpmcFifo, 2 consumers", producers, 2, messages);
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Feed handler and strategy as separate processes sharing one ShmFifo.
+// The parent creates the segment and publishes quotes; a forked child attaches
+// and consumes them, so a crash in either side cannot corrupt the other's heap.
+//
+//   g++ -std=c++20 -O2 shm_spsc_demo.cpp -o shm_spsc_demo   (add -lrt on older glibc)
+//   ./shm_spsc_demo [messages]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "shm_spsc_q.cpp"
+
+struct Quote {
+    std::uint64_t sequence;
+    double bid;
+    double ask;
+};
+
+int main(int argc, char** argv) {
+    std::uint64_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::string name = "/shm_spsc_demo_" + std::to_string(::getpid());
+
+    auto fifo = ShmFifo<Quote>::create(name, 4096);
+    pid_t child = ::fork();
+    if (child < 0) {
+        fifo.unlink();
+        return 1;
+    }
+    if (child == 0) {
+        // A real consumer would run in its own binary; attaching here shows the same path
+        auto consumer = ShmFifo<Quote>::attach(name);
+        Quote quote;
+        for (std::uint64_t expected = 0; expected < messages; ) {
+            if (not consumer.pop(quote)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (quote.sequence != expected++ || quote.ask - quote.bid != 0.5) {
+                std::cerr << "consumer: corrupt quote at " << quote.sequence << std::endl;
+                std::_Exit(1);
+            }
+        }
+        std::_Exit(0);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < messages; ) {
+        if (fifo.push(Quote{i, 100.0, 100.5})) ++i; else std::this_thread::yield();
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fifo.unlink();
+
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    std::cout << messages << " quotes across processes in " << elapsed * 1e3 << " ms ("
+              << elapsed * 1e9 / static_cast<double>(messages) << " ns/quote): "
+              << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cache_line.hpp"
+
+
+/// Fifo4's algorithm with the ring and its cursors placed in a named shared
+/// memory segment, so a producer and a consumer in different processes can
+/// exchange objects with no copies beyond the ring itself.
+///
+/// One process calls create(), which sizes and initialises the segment; the
+/// other calls attach() once create() has returned. Each side keeps its cached
+/// copy of the other's cursor in its own handle, not in shared memory.
+/// Objects are copied bytewise between address spaces, so T must be trivially
+/// copyable and hold no pointers.
+///
+/// Segments live in /dev/shm (shm_open), or with `huge_pages` in a hugetlbfs
+/// mount (default /dev/hugepages), which needs pages reserved via
+/// /proc/sys/vm/nr_hugepages.
+template<typename T>
+class ShmFifo
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= 64, "the ring starts on a cache line boundary");
+
+    using value_type = T;
+    using size_type = std::uint64_t;
+
+    static constexpr auto huge_page_size = std::size_t{2} << 20;
+
+    /// Create and initialise segment `name` (e.g. "/md_feed"); fails if it already exists.
+    /// `capacity` is rounded up to the next power of two.
+    static ShmFifo create(std::string const& name, size_type capacity, bool huge_pages = false,
+                          std::string const& huge_page_dir = "/dev/hugepages") {
+        capacity = std::bit_ceil(capacity < 1 ? size_type{1} : capacity);
+        auto bytes = sizeof(Header) + capacity * sizeof(T);
+        if (huge_pages) {
+            bytes = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+        }
+
+        auto path = huge_pages ? huge_page_dir + name : name;
+        int fd = huge_pages ? ::open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)
+                            : ::shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "ShmFifo: cannot create " + path);
+        }
+        ShmFifo fifo(path, huge_pages);
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            auto error = errno;
+            ::close(fd);
+            fifo.unlink();
+            throw std::system_error(error, std::generic_category(), "ShmFifo: cannot size " + path);
+        }
+        try {
+            fifo.map(fd, bytes);
+        } catch (...) {
+            fifo.unlink();
+            throw;
+        }
+        auto header = new (fifo.base_) Header{};
+        header->capacity = capacity;
+        header->elementSize = sizeof(T);
+        header->magic.store(Header::expected_magic, std::memory_order_release);
+        fifo.bind();
+        return fifo;
+    }
+
+    /// Map a segment made by create() in another process.
+    static ShmFifo attach(std::string const& name, bool huge_pages = false,
+                          std::string const& huge_page_dir = "/dev/hugepages") {
+        auto path = huge_pages ? huge_page_dir + name : name;
+        int fd = huge_pages ? ::open(path.c_str(), O_RDWR) : ::shm_open(path.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "ShmFifo: cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+            ::close(fd);
+            throw std::runtime_error("ShmFifo: " + path + " is not initialised");
+        }
+
+        ShmFifo fifo(path, huge_pages);
+        fifo.map(fd, static_cast<std::size_t>(info.st_size));
+        auto header = static_cast<Header*>(fifo.base_);
+        if (header->magic.load(std::memory_order_acquire) != Header::expected_magic) {
+            throw std::runtime_error("ShmFifo: " + path + " is not initialised");
+        }
+        if (header->elementSize != sizeof(T) ||
+            sizeof(Header) + header->capacity * sizeof(T) > fifo.bytes_) {
+            throw std::runtime_error("ShmFifo: " + path + " holds a different element type or size");
+        }
+        fifo.bind();
+        return fifo;
+    }
+
+    ShmFifo(ShmFifo const&) = delete;
+    ShmFifo& operator=(ShmFifo const&) = delete;
+
+    ShmFifo(ShmFifo&& other) noexcept { swap(other); }
+    ShmFifo& operator=(ShmFifo&& other) noexcept {
+        ShmFifo moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    /// Unmaps the segment; it persists until unlink() is called by either side
+    ~ShmFifo() {
+        if (base_) {
+            ::munmap(base_, bytes_);
+        }
+    }
+
+    /// Remove the segment's name; mappings stay valid until both sides are destroyed
+    void unlink() noexcept {
+        if (hugePages_) {
+            ::unlink(path_.c_str());
+        } else {
+            ::shm_unlink(path_.c_str());
+        }
+    }
+
+
+    /// Returns the number of elements in the fifo
+    auto size() const noexcept {
+        auto pushCursor = header_->pushCursor.load(std::memory_order_relaxed);
+        auto popCursor = header_->popCursor.load(std::memory_order_relaxed);
+
+        assert(popCursor <= pushCursor);
+        return pushCursor - popCursor;
+    }
+
+    /// Returns whether the container has no elements
+    auto empty() const noexcept { return size() == 0; }
+
+    /// Returns whether the container has capacity_() elements
+    auto full() const noexcept { return size() == capacity(); }
+
+    /// Returns the number of elements that can be held in the fifo
+    auto capacity() const noexcept { return capacity_; }
+
+
+    /// Push one object onto the fifo. Only one process may push.
+    /// @return `true` if the operation is successful; `false` if fifo is full.
+    auto push(T const& value) {
+        auto pushCursor = header_->pushCursor.load(std::memory_order_relaxed);
+        if (full(pushCursor, popCursorCached_)) {
+            popCursorCached_ = header_->popCursor.load(std::memory_order_acquire);
+            if (full(pushCursor, popCursorCached_)) {
+                return false;
+            }
+        }
+        std::memcpy(static_cast<void*>(element(pushCursor)), &value, sizeof(T));
+        header_->pushCursor.store(pushCursor + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Pop one object from the fifo. Only one process may pop.
+    /// @return `true` if the pop operation is successful; `false` if fifo is empty.
+    auto pop(T& value) {
+        auto popCursor = header_->popCursor.load(std::memory_order_relaxed);
+        if (empty(pushCursorCached_, popCursor)) {
+            pushCursorCached_ = header_->pushCursor.load(std::memory_order_acquire);
+            if (empty(pushCursorCached_, popCursor)) {
+                return false;
+            }
+        }
+        std::memcpy(&value, element(popCursor), sizeof(T));
+        header_->popCursor.store(popCursor + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    using CursorType = std::atomic<size_type>;
+    // Lock-free atomics are address-free, so they work across processes
+    static_assert(CursorType::is_always_lock_free);
+
+    /// Start of the segment; the ring follows it
+    struct Header {
+        static constexpr size_type expected_magic = 0x5350534346494630ull;  // "SPSCFIF0"
+
+        /// Stored last by create(), so attach() never sees a half-built header
+        CursorType magic{0};
+        size_type capacity = 0;
+        size_type elementSize = 0;
+
+        /// Loaded and stored by the push process; loaded by the pop process
+        alignas(cache_line_size) CursorType pushCursor{0};
+
+        /// Loaded and stored by the pop process; loaded by the push process
+        alignas(cache_line_size) CursorType popCursor{0};
+
+        /// Keeps the ring off the pop cursor's line
+        alignas(cache_line_size) char ring[1];
+    };
+
+    ShmFifo(std::string path, bool huge_pages) : path_{std::move(path)}, hugePages_{huge_pages} {}
+
+    void map(int fd, std::size_t bytes) {
+        // Files in a hugetlbfs mount are backed by huge pages without MAP_HUGETLB
+        auto base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        auto error = errno;
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "ShmFifo: cannot map " + path_);
+        }
+        base_ = base;
+        bytes_ = bytes;
+    }
+
+    void bind() noexcept {
+        header_ = static_cast<Header*>(base_);
+        capacity_ = header_->capacity;
+        mask_ = capacity_ - 1;
+        ring_ = reinterpret_cast<T*>(header_->ring);
+        popCursorCached_ = header_->popCursor.load(std::memory_order_acquire);
+        pushCursorCached_ = header_->pushCursor.load(std::memory_order_acquire);
+    }
+
+    void swap(ShmFifo& other) noexcept {
+        std::swap(path_, other.path_);
+        std::swap(hugePages_, other.hugePages_);
+        std::swap(base_, other.base_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(header_, other.header_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(mask_, other.mask_);
+        std::swap(ring_, other.ring_);
+        std::swap(popCursorCached_, other.popCursorCached_);
+        std::swap(pushCursorCached_, other.pushCursorCached_);
+    }
+
+    auto full(size_type pushCursor, size_type popCursor) const noexcept {
+        return (pushCursor - popCursor) == capacity_;
+    }
+    static auto empty(size_type pushCursor, size_type popCursor) noexcept {
+        return pushCursor == popCursor;
+    }
+    auto element(size_type cursor) noexcept {
+        return &ring_[cursor & mask_];
+    }
+
+private:
+    std::string path_;
+    bool hugePages_ = false;
+    void* base_ = nullptr;
+    std::size_t bytes_ = 0;
+
+    Header* header_ = nullptr;
+    size_type capacity_ = 0;
+    size_type mask_ = 0;
+    T* ring_ = nullptr;
+
+    /// Private to this handle: only the push side uses popCursorCached_, only the pop side pushCursorCached_
+    size_type popCursorCached_ = 0;
+    size_type pushCursorCached_ = 0;
+};
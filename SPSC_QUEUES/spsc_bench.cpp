@@ -0,0 +1,306 @@
+// Throughput and round-trip latency of Fifo1..Fifo4 across element sizes and capacities.
+//
+//   g++ -std=c++20 -O2 -pthread spsc_bench.cpp -o spsc_bench
+//   ./spsc_bench [producer_core consumer_core [operations]]
+//
+// Cores default to -1 (unpinned). Threads busy-poll with a pause, yielding
+// every 1024 failed polls so an unpinned pair sharing one core still makes
+// progress. Per-operation cycles, instructions and cache, branch and dTLB
+// misses come from a perf_event_open group on each thread, summed over
+// producer and consumer, and show as n/a where the kernel or CPU does not
+// provide them (see perf_event_paranoid; most VMs expose no PMU).
+// Fifo1 is not threadsafe, so it only runs the single-threaded case.
+//
+// BroadcastRing runs one writer against several readers, unpinned, in both
+// overflow modes. Every reader checks what it gets: in Block mode each
+// sequence in order, in Overwrite mode each value matching its cursor, that
+// is, values read plus values lost. It aborts on any mismatch.
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_q1.cpp"
+#include "spsc_q2.cpp"
+#include "spsc_q3.cpp"
+#include "spsc_q4.cpp"
+#include "broadcast_q.cpp"
+#include "wait_strategy.cpp"
+#include "../OrderBook/perf_counters.hpp"
+#include "../OrderBook/thread_runtime.hpp"
+#include "../OrderBook/tsc_clock.hpp"
+
+namespace {
+
+struct Config {
+    int producerCore = -1;
+    int consumerCore = -1;
+    std::uint64_t operations = 4'000'000;
+};
+
+void pin(int core, char const* role) {
+    if (core < 0) return;
+    auto result = apply_thread_placement(role, ThreadPlacement{core});
+    if (!result.ok()) {
+        std::cerr << "warning: " << role << ": " << result.error << std::endl;
+    }
+}
+
+template<std::size_t Bytes>
+struct Payload {
+    std::uint64_t sequence;
+    char bytes[Bytes - sizeof(std::uint64_t)];
+};
+
+/// Poll until `op` succeeds
+template<typename Op>
+void spin_until(Op&& op) {
+    for (unsigned attempt = 1; not op(); ++attempt) {
+        if (attempt % 1024 == 0) {
+            std::this_thread::yield();
+        } else {
+            cpu_relax();
+        }
+    }
+}
+
+void print_row(std::string const& name, std::size_t bytes, std::size_t capacity, double mops,
+               PerfReading const& counters, std::uint64_t operations) {
+    std::cout << std::left << std::setw(8) << name << std::right
+              << std::setw(6) << bytes << std::setw(9) << capacity
+              << std::fixed << std::setprecision(1) << std::setw(10) << mops
+              << perf_per_op(counters, operations) << std::endl;
+}
+
+/// Push then pop on one thread: the cost of the fifo logic with no sharing at all
+template<template<typename...> class Fifo, std::size_t Bytes>
+void single_thread(std::string const& name, std::size_t capacity, Config const& config) {
+    using T = Payload<Bytes>;
+    Fifo<T> fifo(capacity);
+    T value{};
+    pin(config.producerCore, "producer");
+    PerfCounters counters;
+    counters.start();
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < config.operations; ++i) {
+        value.sequence = i;
+        fifo.push(value);
+        fifo.pop(value);
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    print_row(name, Bytes, capacity, config.operations / seconds / 1e6, counters.stop(), config.operations);
+}
+
+/// Producer streams `operations` objects; consumer checks the sequence
+template<template<typename...> class Fifo, std::size_t Bytes>
+void throughput(std::string const& name, std::size_t capacity, Config const& config) {
+    using T = Payload<Bytes>;
+    Fifo<T> fifo(capacity);
+    PerfReading consumerCounts;
+
+    std::thread consumer([&] {
+        pin(config.consumerCore, "consumer");
+        PerfCounters counters;
+        counters.start();
+        T value;
+        for (std::uint64_t i = 0; i < config.operations; ++i) {
+            spin_until([&] { return fifo.pop(value); });
+            if (value.sequence != i) {
+                std::cerr << name << ": out of order at " << i << std::endl;
+                std::abort();
+            }
+        }
+        consumerCounts = counters.stop();
+    });
+
+    pin(config.producerCore, "producer");
+    PerfCounters counters;
+    counters.start();
+    auto start = std::chrono::steady_clock::now();
+    T value{};
+    for (std::uint64_t i = 0; i < config.operations; ++i) {
+        value.sequence = i;
+        spin_until([&] { return fifo.push(value); });
+    }
+    PerfReading counts = counters.stop();
+    consumer.join();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    counts += consumerCounts;
+    print_row(name, Bytes, capacity, config.operations / seconds / 1e6, counts, config.operations);
+}
+
+/// One object bounces between two fifos; each round trip is timed on the producer
+template<template<typename...> class Fifo, std::size_t Bytes>
+void ping_pong(std::string const& name, std::size_t capacity, Config const& config) {
+    using T = Payload<Bytes>;
+    Fifo<T> ping(capacity), pong(capacity);
+    auto rounds = std::max<std::uint64_t>(config.operations / 20, 1000);
+
+    std::thread echo([&] {
+        pin(config.consumerCore, "consumer");
+        T value;
+        for (std::uint64_t i = 0; i < rounds; ++i) {
+            spin_until([&] { return ping.pop(value); });
+            spin_until([&] { return pong.push(value); });
+        }
+    });
+
+    pin(config.producerCore, "producer");
+    std::vector<std::uint64_t> samples;
+    samples.reserve(rounds);
+    T value{};
+    for (std::uint64_t i = 0; i < rounds; ++i) {
+        value.sequence = i;
+        auto start = tsc_read();
+        spin_until([&] { return ping.push(value); });
+        spin_until([&] { return pong.pop(value); });
+        auto end = tsc_read<TscFence::Rdtscp>();
+        samples.push_back(end - start);
+    }
+    echo.join();
+    for (auto& sample : samples) {
+        sample = tsc_clock().to_ns(sample);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double quantile) { return samples[std::min(samples.size() - 1, static_cast<std::size_t>(quantile * samples.size()))]; };
+    std::cout << std::left << std::setw(8) << name << std::right << std::setw(6) << Bytes
+              << std::setw(10) << at(0.50) << std::setw(10) << at(0.99) << std::setw(10) << at(0.999)
+              << std::setw(12) << samples.back() << "   ";
+
+    // Power-of-two histogram: "2^k:n" counts round trips in [2^k, 2^(k+1)) ns
+    std::size_t buckets[64] = {};
+    for (auto sample : samples) {
+        buckets[std::bit_width(sample)]++;
+    }
+    for (std::size_t k = 1; k < 64; ++k) {
+        if (buckets[k]) std::cout << " 2^" << k - 1 << ":" << buckets[k];
+    }
+    std::cout << std::endl;
+}
+
+/// One writer, `readers` readers; reports the writer's rate and what readers skipped
+template<std::size_t Bytes>
+void broadcast(BroadcastOverflow overflow, std::size_t readers, std::size_t capacity, Config const& config) {
+    using T = Payload<Bytes>;
+    BroadcastRing<T> ring(capacity, readers, overflow);
+    std::vector<std::uint64_t> lost(readers, 0);
+    char const* mode = overflow == BroadcastOverflow::Block ? "block" : "overwrite";
+
+    std::vector<std::thread> threads;
+    for (std::size_t r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            T value;
+            std::uint64_t seen = 0;
+            while (seen + ring.lost(r) < config.operations) {
+                BroadcastRead read;
+                spin_until([&] { return (read = ring.pop(r, value)) != BroadcastRead::Empty; });
+                if (read == BroadcastRead::Lapped) {
+                    if (overflow == BroadcastOverflow::Block) {
+                        std::cerr << "broadcast " << mode << ": reader " << r << " lapped" << std::endl;
+                        std::abort();
+                    }
+                    continue;
+                }
+                // The cursor only moves by reads and skips, so this is the sequence due
+                if (value.sequence != seen + ring.lost(r)) {
+                    std::cerr << "broadcast " << mode << ": reader " << r << " got " << value.sequence
+                              << ", expected " << seen + ring.lost(r) << std::endl;
+                    std::abort();
+                }
+                ++seen;
+            }
+            lost[r] = ring.lost(r);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    T value{};
+    for (std::uint64_t i = 0; i < config.operations; ++i) {
+        value.sequence = i;
+        spin_until([&] { return ring.push(value); });
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (auto& thread : threads) thread.join();
+
+    std::uint64_t total_lost = 0;
+    for (std::uint64_t l : lost) total_lost += l;
+    if (overflow == BroadcastOverflow::Block and total_lost != 0) {
+        std::cerr << "broadcast block: readers lost " << total_lost << std::endl;
+        std::abort();
+    }
+    std::cout << std::left << std::setw(10) << mode << std::right << std::setw(8) << readers
+              << std::setw(6) << Bytes << std::setw(9) << ring.capacity()
+              << std::fixed << std::setprecision(1) << std::setw(10) << config.operations / seconds / 1e6
+              << std::setw(12) << total_lost << std::endl;
+}
+
+template<std::size_t Bytes>
+void run_broadcast(Config const& config) {
+    for (auto overflow : {BroadcastOverflow::Block, BroadcastOverflow::Overwrite}) {
+        broadcast<Bytes>(overflow, 1, 1024, config);
+        broadcast<Bytes>(overflow, 3, 1024, config);
+    }
+}
+
+template<std::size_t Bytes>
+void run_throughput(Config const& config) {
+    for (std::size_t capacity : {std::size_t{64}, std::size_t{1024}, std::size_t{65536}}) {
+        single_thread<Fifo1, Bytes>("Fifo1 1T", capacity, config);
+        throughput<Fifo2, Bytes>("Fifo2", capacity, config);
+        throughput<Fifo3, Bytes>("Fifo3", capacity, config);
+        throughput<Fifo4, Bytes>("Fifo4", capacity, config);
+    }
+}
+
+// Only one object is ever in flight, so capacity does not matter here
+template<std::size_t Bytes>
+void run_latency(Config const& config) {
+    ping_pong<Fifo2, Bytes>("Fifo2", 1024, config);
+    ping_pong<Fifo3, Bytes>("Fifo3", 1024, config);
+    ping_pong<Fifo4, Bytes>("Fifo4", 1024, config);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (argc > 2) {
+        config.producerCore = std::atoi(argv[1]);
+        config.consumerCore = std::atoi(argv[2]);
+    }
+    if (argc > 3) {
+        config.operations = std::strtoull(argv[3], nullptr, 10);
+    }
+
+    std::cout << "producer core " << config.producerCore << ", consumer core " << config.consumerCore
+              << ", " << config.operations << " operations per run, "
+              << std::thread::hardware_concurrency() << " cpus" << std::endl;
+    std::cout << "\n=== throughput ===\n" << std::left << std::setw(8) << "fifo" << std::right << std::setw(6) << "bytes"
+              << std::setw(9) << "capacity" << std::setw(10) << "Mops/s" << perf_header()
+              << "  (per op)" << std::endl;
+    run_throughput<8>(config);
+    run_throughput<64>(config);
+    run_throughput<256>(config);
+
+    std::cout << "\n=== ping-pong round trip (ns) ===\n" << std::left << std::setw(8) << "fifo" << std::right << std::setw(6) << "bytes"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max"
+              << "    histogram" << std::endl;
+    run_latency<8>(config);
+    run_latency<64>(config);
+    run_latency<256>(config);
+
+    std::cout << "\n=== broadcast, one writer ===\n" << std::left << std::setw(10) << "mode" << std::right
+              << std::setw(8) << "readers" << std::setw(6) << "bytes" << std::setw(9) << "capacity"
+              << std::setw(10) << "Mops/s" << std::setw(12) << "lost" << std::endl;
+    run_broadcast<8>(config);
+    run_broadcast<64>(config);
+    return 0;
+}
@@ -2,12 +2,39 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <memory>
 #include <new>
 
+#include "cache_line.hpp"
+
+// Probes live with the order book; only probed builds depend on it. The
+// fallback matches probes.hpp's own, so including both is fine.
+#ifdef ENABLE_PROBES
+#include "../OrderBook/probes.hpp"
+#elif !defined(PROBE_SCOPE)
+#define PROBE_SCOPE(name) static_assert(true, "")
+#endif
+
+
+/// Capacity passed to the constructor
+struct DynamicCapacity {
+    static constexpr bool fixed = false;
+    std::size_t value;
+};
+
+/// Capacity fixed at compile time. A power of two, so the index math in
+/// element() folds to a mask and full() compares against a constant.
+template<std::size_t N>
+struct FixedCapacity {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "fixed capacity must be a power of two");
+    static constexpr bool fixed = true;
+    static constexpr std::size_t value = N;
+};
+
 
 /// Threadsafe, efficient circular FIFO
-template<typename T, typename Alloc = std::allocator<T>>
+template<typename T, typename Alloc = std::allocator<T>, typename Capacity = DynamicCapacity>
 class Fifo3 : private Alloc
 {
 public:
@@ -15,18 +42,23 @@ public:
     using allocator_traits = std::allocator_traits<Alloc>;
     using size_type = typename allocator_traits::size_type;
 
-    explicit Fifo3(size_type capacity, Alloc const& alloc = Alloc{})
+    explicit Fifo3(size_type capacity, Alloc const& alloc = Alloc{}) requires(!Capacity::fixed)
         : Alloc{alloc}
         , capacity_{capacity}
         , ring_{allocator_traits::allocate(*this, capacity)}
     {}
 
+    explicit Fifo3(Alloc const& alloc = Alloc{}) requires(Capacity::fixed)
+        : Alloc{alloc}
+        , ring_{allocator_traits::allocate(*this, Capacity::value)}
+    {}
+
     ~Fifo3() {
         while(not empty()) {
             element(popCursor_)->~T();
             ++popCursor_;
         }
-        allocator_traits::deallocate(*this, ring_, capacity_);
+        allocator_traits::deallocate(*this, ring_, capacity());
     }
 
 
@@ -46,12 +78,13 @@ public:
     auto full() const noexcept { return size() == capacity(); }
 
     /// Returns the number of elements that can be held in the fifo
-    auto capacity() const noexcept { return capacity_; }
+    size_type capacity() const noexcept { return capacity_.value; }
 
 
     /// Push one object onto the fifo.
     /// @return `true` if the operation is successful; `false` if fifo is full.
     auto push(T const& value) {
+        PROBE_SCOPE("Fifo3::push");
         auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
         auto popCursor = popCursor_.load(std::memory_order_acquire);
         if (full(pushCursor, popCursor)) {
@@ -78,36 +111,28 @@ public:
 
 private:
     auto full(size_type pushCursor, size_type popCursor) const noexcept {
-        return (pushCursor - popCursor) == capacity_;
+        return (pushCursor - popCursor) == capacity();
     }
     static auto empty(size_type pushCursor, size_type popCursor) noexcept {
         return pushCursor == popCursor;
     }
     auto element(size_type cursor) noexcept {
-        return &ring_[cursor % capacity_];
+        return &ring_[cursor % capacity()];
     }
 
 private:
-    size_type capacity_;
+    [[no_unique_address]] Capacity capacity_;
     T* ring_;
 
     using CursorType = std::atomic<size_type>;
     static_assert(CursorType::is_always_lock_free);
 
-    // N.B. std::hardware_destructive_interference_size is not used directly
-    // error: use of ‘std::hardware_destructive_interference_size’ [-Werror=interference-size]
-    // note: its value can vary between compiler versions or with different ‘-mtune’ or ‘-mcpu’ flags
-    // note: if this use is part of a public ABI, change it to instead use a constant variable you define
-    // note: the default value for the current CPU tuning is 64 bytes
-    // note: you can stabilize this value with ‘--param hardware_destructive_interference_size=64’, or disable this warning with ‘-Wno-interference-size’
-    static constexpr auto hardware_destructive_interference_size = size_type{64};
-
     /// Loaded and stored by the push thread; loaded by the pop thread
-    alignas(hardware_destructive_interference_size) CursorType pushCursor_;
+    alignas(cache_line_size) CursorType pushCursor_;
 
     /// Loaded and stored by the pop thread; loaded by the push thread
-    alignas(hardware_destructive_interference_size) CursorType popCursor_;
+    alignas(cache_line_size) CursorType popCursor_;
 
     // Padding to avoid false sharing with adjacent objects
-    char padding_[hardware_destructive_interference_size - sizeof(size_type)];
+    char padding_[cache_line_size - sizeof(size_type)];
 };
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+#include "cache_line.hpp"
+
+
+/// Threadsafe, efficient circular FIFO with a power-of-two ring and cached cursors.
+/// Each side keeps a private copy of the other side's cursor and only reloads
+/// the shared one when the queue looks full (push) or empty (pop), so in steady
+/// state neither thread pulls the other's cache line on every operation.
+template<typename T, typename Alloc = std::allocator<T>>
+class Fifo4 : private Alloc
+{
+public:
+    using value_type = T;
+    using allocator_traits = std::allocator_traits<Alloc>;
+    using size_type = typename allocator_traits::size_type;
+
+    /// `capacity` is rounded up to the next power of two so slots are found with a mask
+    explicit Fifo4(size_type capacity, Alloc const& alloc = Alloc{})
+        : Alloc{alloc}
+        , capacity_{std::bit_ceil(capacity < 1 ? size_type{1} : capacity)}
+        , mask_{capacity_ - 1}
+        , ring_{allocator_traits::allocate(*this, capacity_)}
+    {}
+
+    Fifo4(Fifo4 const&) = delete;
+    Fifo4& operator=(Fifo4 const&) = delete;
+
+    ~Fifo4() {
+        while(not empty()) {
+            element(popCursor_)->~T();
+            ++popCursor_;
+        }
+        allocator_traits::deallocate(*this, ring_, capacity_);
+    }
+
+
+    /// Returns the number of elements in the fifo
+    auto size() const noexcept {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+
+        assert(popCursor <= pushCursor);
+        return pushCursor - popCursor;
+    }
+
+    /// Returns whether the container has no elements
+    auto empty() const noexcept { return size() == 0; }
+
+    /// Returns whether the container has capacity_() elements
+    auto full() const noexcept { return size() == capacity(); }
+
+    /// Returns the number of elements that can be held in the fifo
+    auto capacity() const noexcept { return capacity_; }
+
+
+    /// Push one object onto the fifo.
+    /// @return `true` if the operation is successful; `false` if fifo is full.
+    auto push(T const& value) {
+        return emplace(value);
+    }
+
+    /// Construct one object in place at the back of the fifo.
+    /// @return `true` if the operation is successful; `false` if fifo is full.
+    template<typename... Args>
+    auto emplace(Args&&... args) {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        if (full(pushCursor, popCursorCached_)) {
+            popCursorCached_ = popCursor_.load(std::memory_order_acquire);
+            if (full(pushCursor, popCursorCached_)) {
+                return false;
+            }
+        }
+        new (element(pushCursor)) T(std::forward<Args>(args)...);
+        pushCursor_.store(pushCursor + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Push as many of `values` as fit, published with a single cursor store.
+    /// @return the number of objects pushed; 0 if fifo is full.
+    auto try_push_n(std::span<T const> values) {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        auto count = std::min<size_type>(values.size(), free_slots(pushCursor, values.size()));
+        for (size_type i = 0; i < count; ++i) {
+            new (element(pushCursor + i)) T(values[i]);
+        }
+        if (count) {
+            pushCursor_.store(pushCursor + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /// Claim up to `count` contiguous free slots so the producer can build objects
+    /// directly in the ring. The region stops at the end of the ring, so it may be
+    /// shorter than the free space. Slots are raw storage: construct each one that
+    /// will be committed with placement new, then call commit_push().
+    /// @return the claimed slots; empty if fifo is full.
+    auto claim_push(size_type count) {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        auto offset = pushCursor & mask_;
+        count = std::min({count, free_slots(pushCursor, count), capacity_ - offset});
+        return std::span<T>{ring_ + offset, count};
+    }
+
+    /// Publish the first `count` slots of the last claim_push(), which must all be constructed.
+    void commit_push(size_type count) {
+        auto pushCursor = pushCursor_.load(std::memory_order_relaxed);
+        pushCursor_.store(pushCursor + count, std::memory_order_release);
+    }
+
+    /// Pop one object from the fifo.
+    /// @return `true` if the pop operation is successful; `false` if fifo is empty.
+    auto pop(T& value) {
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+        if (empty(pushCursorCached_, popCursor)) {
+            pushCursorCached_ = pushCursor_.load(std::memory_order_acquire);
+            if (empty(pushCursorCached_, popCursor)) {
+                return false;
+            }
+        }
+        value = std::move(*element(popCursor));
+        element(popCursor)->~T();
+        popCursor_.store(popCursor + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Pop up to `values.size()` objects, released with a single cursor store.
+    /// @return the number of objects popped; 0 if fifo is empty.
+    auto try_pop_n(std::span<T> values) {
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+        auto count = std::min<size_type>(values.size(), used_slots(popCursor, values.size()));
+        for (size_type i = 0; i < count; ++i) {
+            values[i] = std::move(*element(popCursor + i));
+            element(popCursor + i)->~T();
+        }
+        if (count) {
+            popCursor_.store(popCursor + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /// Claim up to `count` contiguous objects at the front so the consumer can read
+    /// them in place. The region stops at the end of the ring, so it may be shorter
+    /// than the number of queued objects. Call commit_pop() to release them.
+    /// @return the claimed objects; empty if fifo is empty.
+    auto claim_pop(size_type count) {
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+        auto offset = popCursor & mask_;
+        count = std::min({count, used_slots(popCursor, count), capacity_ - offset});
+        return std::span<T>{ring_ + offset, count};
+    }
+
+    /// Destroy the first `count` objects of the last claim_pop() and hand their slots back.
+    void commit_pop(size_type count) {
+        auto popCursor = popCursor_.load(std::memory_order_relaxed);
+        for (size_type i = 0; i < count; ++i) {
+            element(popCursor + i)->~T();
+        }
+        popCursor_.store(popCursor + count, std::memory_order_release);
+    }
+
+private:
+    auto full(size_type pushCursor, size_type popCursor) const noexcept {
+        return (pushCursor - popCursor) == capacity_;
+    }
+    static auto empty(size_type pushCursor, size_type popCursor) noexcept {
+        return pushCursor == popCursor;
+    }
+
+    /// Free slots seen by the push thread; reloads the pop cursor only if fewer than `wanted`
+    auto free_slots(size_type pushCursor, size_type wanted) noexcept {
+        auto free = capacity_ - (pushCursor - popCursorCached_);
+        if (free < wanted) {
+            popCursorCached_ = popCursor_.load(std::memory_order_acquire);
+            free = capacity_ - (pushCursor - popCursorCached_);
+        }
+        return free;
+    }
+
+    /// Queued objects seen by the pop thread; reloads the push cursor only if fewer than `wanted`
+    auto used_slots(size_type popCursor, size_type wanted) noexcept {
+        auto used = pushCursorCached_ - popCursor;
+        if (used < wanted) {
+            pushCursorCached_ = pushCursor_.load(std::memory_order_acquire);
+            used = pushCursorCached_ - popCursor;
+        }
+        return used;
+    }
+
+    auto element(size_type cursor) noexcept {
+        return &ring_[cursor & mask_];
+    }
+
+private:
+    size_type capacity_;
+    size_type mask_;
+    T* ring_;
+
+    using CursorType = std::atomic<size_type>;
+    static_assert(CursorType::is_always_lock_free);
+
+    /// Loaded and stored by the push thread; loaded by the pop thread
+    alignas(cache_line_size) CursorType pushCursor_{0};
+
+    /// Exclusive to the push thread
+    alignas(cache_line_size) size_type popCursorCached_{0};
+
+    /// Loaded and stored by the pop thread; loaded by the push thread
+    alignas(cache_line_size) CursorType popCursor_{0};
+
+    /// Exclusive to the pop thread
+    alignas(cache_line_size) size_type pushCursorCached_{0};
+
+    // Padding to avoid false sharing with adjacent objects
+    char padding_[cache_line_size - sizeof(size_type)];
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "cache_line.hpp"
+
+
+/// Idling policies for consumers of the non-blocking fifos.
+/// A strategy object is shared by a consumer and its producers: the consumer
+/// calls idle() after every empty poll, producers call notify() after every
+/// successful push, and whoever shuts the consumer down calls wake_all().
+/// `attempt` counts consecutive empty polls, so strategies can back off.
+/// `ready` re-checks the queue (and any stop flag) and is only used when parking.
+
+/// Tells the core we are in a spin loop: saves power and frees the pipeline for a sibling hyperthread
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/// Lowest wake-up latency; burns the whole core
+struct BusySpinWait
+{
+    template<typename Ready>
+    void idle(unsigned, Ready&&) noexcept {}
+    void notify() noexcept {}
+    void wake_all() noexcept {}
+};
+
+/// Busy spin with a pause per poll
+struct SpinPauseWait
+{
+    template<typename Ready>
+    void idle(unsigned, Ready&&) noexcept { cpu_relax(); }
+    void notify() noexcept {}
+    void wake_all() noexcept {}
+};
+
+/// Spins for `spin_limit` polls, then yields the core to other runnable threads
+struct SpinYieldWait
+{
+    unsigned spin_limit = 64;
+
+    template<typename Ready>
+    void idle(unsigned attempt, Ready&&) noexcept {
+        if (attempt < spin_limit) {
+            cpu_relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    void notify() noexcept {}
+    void wake_all() noexcept {}
+};
+
+/// Spins for `spin_limit` polls, then sleeps in the kernel (futex) until notified.
+/// Producers only pay for a syscall when a consumer has flagged itself asleep;
+/// otherwise notify() is a fence and one load of an uncontended line.
+class ParkingWait
+{
+public:
+    explicit ParkingWait(unsigned spin_limit = 256) noexcept : spin_limit_{spin_limit} {}
+
+    ParkingWait(ParkingWait const&) = delete;
+    ParkingWait& operator=(ParkingWait const&) = delete;
+
+    template<typename Ready>
+    void idle(unsigned attempt, Ready&& ready) {
+        if (attempt < spin_limit_) {
+            cpu_relax();
+            return;
+        }
+        auto epoch = epoch_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in notify(): either the producer sees the sleeper
+        // or we see its push here, so a wake-up cannot be lost
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (not ready()) {
+            epoch_.wait(epoch, std::memory_order_acquire);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) != 0) {
+            wake_all();
+        }
+    }
+
+    void wake_all() noexcept {
+        epoch_.fetch_add(1, std::memory_order_release);
+        epoch_.notify_all();
+    }
+
+    /// Number of consumers currently parked or about to park
+    auto sleepers() const noexcept { return sleepers_.load(std::memory_order_relaxed); }
+
+private:
+    unsigned spin_limit_;
+
+    /// Bumped by every wake-up; consumers sleep on it
+    alignas(cache_line_size) std::atomic<std::uint32_t> epoch_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+
+    // Padding to avoid false sharing with adjacent objects
+    char padding_[cache_line_size - 2 * sizeof(std::uint32_t)];
+};
+
+
+/// Push and wake a parked consumer if needed.
+/// @return `true` if the operation is successful; `false` if fifo is full.
+template<typename Fifo, typename WaitStrategy>
+bool push_notify(Fifo& fifo, typename Fifo::value_type const& value, WaitStrategy& strategy) {
+    if (not fifo.push(value)) {
+        return false;
+    }
+    strategy.notify();
+    return true;
+}
+
+/// Pop, idling with `strategy` while the fifo is empty. Raise `stop` and call
+/// strategy.wake_all() to release a waiting consumer.
+/// @return `true` once an object is popped; `false` if `stop` was raised first.
+template<typename Fifo, typename WaitStrategy>
+bool pop_wait(Fifo& fifo, typename Fifo::value_type& value, WaitStrategy& strategy, std::atomic<bool> const& stop) {
+    for (unsigned attempt = 0; not fifo.pop(value); ++attempt) {
+        if (stop.load(std::memory_order_acquire)) {
+            return false;
+        }
+        strategy.idle(attempt, [&] { return not fifo.empty() or stop.load(std::memory_order_relaxed); });
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase-Lev work-stealing deque, with the C11 memory orders from Le, Pop,
+// Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (PPoPP 2013).
+//
+// The owner thread pushes and takes at the bottom without any
+// read-modify-write except when racing a thief for the last element; any
+// other thread may steal from the top with one CAS. T must be a lock-free
+// atomic type, normally a pointer to a task.
+//
+// The ring doubles when full. Old rings are kept until the deque is destroyed,
+// because a thief may still be reading one; growth is rare and logarithmic,
+// so this bounded "leak" stands in for a reclamation scheme.
+template<typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(size_t capacity = 64) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        rings_.push_back(std::make_unique<Ring>(size));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only
+    void push(T value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(ring->mask)) {
+            ring = grow(ring, top, bottom);
+        }
+        ring->put(bottom, value);
+        // The paper's release fence + relaxed store, as one release store
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Owner only; LIFO end. Returns false if empty or a thief won the last element.
+    bool take(T& value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        value = ring->get(bottom);
+        if (top == bottom) {
+            // Last element: race thieves for it through top
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread; FIFO end. Returns false if empty or another thread won the race.
+    bool steal(T& value) {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        Ring* ring = ring_.load(std::memory_order_acquire);
+        T candidate = ring->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        value = candidate;
+        return true;
+    }
+
+    // Racy estimate from any thread
+    size_t size() const {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Ring {
+        explicit Ring(size_t size) : mask(size - 1), slots(new std::atomic<T>[size]) {}
+
+        T get(int64_t index) const { return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed); }
+        void put(int64_t index, T value) { slots[static_cast<size_t>(index) & mask].store(value, std::memory_order_relaxed); }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+    static_assert(std::atomic<T>::is_always_lock_free);
+
+    Ring* grow(Ring* old, int64_t top, int64_t bottom) {
+        auto bigger = std::make_unique<Ring>((old->mask + 1) * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        Ring* ring = bigger.get();
+        rings_.push_back(std::move(bigger));  // Owner only, so no lock needed
+        ring_.store(ring, std::memory_order_release);
+        return ring;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};     // Stolen from by thieves
+    alignas(64) std::atomic<int64_t> bottom_{0};  // Owner's end
+    std::atomic<Ring*> ring_;
+    std::vector<std::unique_ptr<Ring>> rings_;    // Every ring ever used, see above
+};
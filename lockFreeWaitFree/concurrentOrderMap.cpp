@@ -0,0 +1,60 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "concurrentOrderMap.hpp"
+
+// Open quantity in the low 32 bits, a cancel-pending flag above it
+constexpr uint64_t cancel_pending = 1ull << 32;
+
+int main() {
+    const uint64_t sessions = 3, orders_per_session = 20000, quantity = 100;
+    ConcurrentOrderMap orders(sessions * orders_per_session);
+
+    // Each session owns a disjoint id range; it enters orders, then requests
+    // cancels, validating against state the matcher is filling concurrently
+    std::atomic<bool> entered{false};
+    std::atomic<uint64_t> cancels_accepted{0}, cancels_rejected{0};
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> sessions_done{0};
+    for (uint64_t s = 0; s < sessions; s++) {
+        threads.emplace_back([&, s]() {
+            uint64_t first = 1 + s * orders_per_session;
+            for (uint64_t id = first; id < first + orders_per_session; id++) orders.insert(id, quantity);
+            sessions_done++;
+            while (!entered.load()) std::this_thread::yield();
+            for (uint64_t id = first; id < first + orders_per_session; id++) {
+                bool accepted = orders.update(id, [](uint64_t state) {
+                    return (state & 0xffffffff) ? (state | cancel_pending) : state;
+                });
+                uint64_t state;
+                if (accepted && orders.find(id, state) && (state & cancel_pending)) cancels_accepted++;
+                else cancels_rejected++;
+            }
+        });
+    }
+
+    // Matcher: fills every other order completely, racing the cancels
+    threads.emplace_back([&]() {
+        while (sessions_done.load() < sessions) std::this_thread::yield();
+        entered = true;
+        for (uint64_t id = 1; id <= sessions * orders_per_session; id += 2) {
+            orders.update(id, [](uint64_t state) { return state & cancel_pending; });  // Open quantity -> 0
+        }
+    });
+    for (auto& thread : threads) thread.join();
+
+    uint64_t total = sessions * orders_per_session, filled = 0, pending = 0;
+    for (uint64_t id = 1; id <= total; id++) {
+        uint64_t state;
+        if (!orders.find(id, state)) continue;
+        if ((state & 0xffffffff) == 0) filled++;
+        if (state & cancel_pending) pending++;
+    }
+    bool ok = cancels_accepted + cancels_rejected == total && pending == cancels_accepted && filled == total / 2 &&
+              !orders.insert(1, quantity) && orders.erase(2) && !orders.contains(2) && orders.insert(2, quantity);
+    std::cout << "accepted " << cancels_accepted << ", rejected " << cancels_rejected << ", filled " << filled
+              << ", used slots " << orders.used_slots() << " of " << orders.capacity() << ": " << (ok ? "OK" : "MISMATCH") << "\n";
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// Fixed-capacity concurrent map from order id to one 64-bit state word
+// (e.g. open quantity and status packed together), shared by gateway session
+// threads and the matcher without locks.
+//
+// Linear probing over {key, value} slots. A key is claimed once with a CAS
+// and never moves or leaves, so a probe for an id can stop at the first empty
+// slot and find() is wait-free: at most capacity loads, no retries. Values
+// are published and replaced with CAS as well, so updates are lock-free.
+// Erasing leaves a tombstone (the key stays, the value becomes absent); size
+// the table for a full session of order ids and call reset() between sessions.
+class ConcurrentOrderMap {
+public:
+    static constexpr uint64_t empty_key = 0;         // Order id 0 is reserved
+    static constexpr uint64_t absent = UINT64_MAX;  // Value reserved for "not present"
+
+    explicit ConcurrentOrderMap(size_t capacity) {
+        capacity_ = 16;
+        while (capacity_ < capacity * 2) capacity_ <<= 1;  // Keep load <= 50% for short probes
+        mask_ = capacity_ - 1;
+        shift_ = 64 - static_cast<unsigned>(__builtin_ctzll(capacity_));
+        slots_ = std::make_unique<Slot[]>(capacity_);
+    }
+
+    ConcurrentOrderMap(const ConcurrentOrderMap&) = delete;
+    ConcurrentOrderMap& operator=(const ConcurrentOrderMap&) = delete;
+
+    // Returns false if the id is already present or the table is full
+    bool insert(uint64_t order_id, uint64_t value) {
+        if (order_id == empty_key || value == absent) {
+            throw std::runtime_error("ConcurrentOrderMap: reserved order id or value");
+        }
+        size_t index = home(order_id);
+        for (size_t probes = 0; probes < capacity_; ++probes, index = (index + 1) & mask_) {
+            Slot& slot = slots_[index];
+            uint64_t key = slot.key.load(std::memory_order_acquire);
+            if (key == empty_key) {
+                if (slot.key.compare_exchange_strong(key, order_id, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    used_.fetch_add(1, std::memory_order_relaxed);
+                    key = order_id;
+                }
+                // On failure `key` holds whoever claimed the slot first, possibly us by another thread
+            }
+            if (key == order_id) {
+                // Exactly one inserter wins, also against re-insertion after erase()
+                uint64_t expected = absent;
+                return slot.value.compare_exchange_strong(expected, value, std::memory_order_release, std::memory_order_relaxed);
+            }
+        }
+        return false;
+    }
+
+    // Wait-free; returns false if not present
+    bool find(uint64_t order_id, uint64_t& value) const {
+        const Slot* slot = locate(order_id);
+        if (!slot) return false;
+        value = slot->value.load(std::memory_order_acquire);
+        return value != absent;
+    }
+
+    bool contains(uint64_t order_id) const {
+        uint64_t value;
+        return find(order_id, value);
+    }
+
+    // Replaces the value only if it still equals `expected`; on failure `expected` holds the current value.
+    // Returns false also when the id is not present.
+    bool compare_exchange(uint64_t order_id, uint64_t& expected, uint64_t desired) {
+        if (desired == absent) {
+            throw std::runtime_error("ConcurrentOrderMap: reserved value");
+        }
+        Slot* slot = const_cast<Slot*>(locate(order_id));
+        if (!slot || expected == absent) {
+            expected = slot ? slot->value.load(std::memory_order_acquire) : absent;
+            return false;
+        }
+        return slot->value.compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+
+    // Applies `f(old) -> new` atomically; returns false if the id is not present
+    template<typename F>
+    bool update(uint64_t order_id, F&& f) {
+        uint64_t current;
+        if (!find(order_id, current)) return false;
+        while (!compare_exchange(order_id, current, f(current))) {
+            if (current == absent) return false;  // Erased meanwhile
+        }
+        return true;
+    }
+
+    // Returns false if the id was not present
+    bool erase(uint64_t order_id) {
+        Slot* slot = const_cast<Slot*>(locate(order_id));
+        return slot && slot->value.exchange(absent, std::memory_order_acq_rel) != absent;
+    }
+
+    // Clears every slot; only while no other thread uses the map
+    void reset() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].key.store(empty_key, std::memory_order_relaxed);
+            slots_[i].value.store(absent, std::memory_order_relaxed);
+        }
+        used_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // Slots holding a key, live or tombstone; a fill gauge, not a live-order count
+    size_t used_slots() const { return used_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> key{empty_key};
+        std::atomic<uint64_t> value{absent};
+    };
+
+    // Fibonacci hashing, as in OrderIdMap: sequential ids spread evenly
+    size_t home(uint64_t order_id) const { return static_cast<size_t>((order_id * 0x9E3779B97F4A7C15ull) >> shift_); }
+
+    const Slot* locate(uint64_t order_id) const {
+        if (order_id == empty_key) return nullptr;
+        size_t index = home(order_id);
+        for (size_t probes = 0; probes < capacity_; ++probes, index = (index + 1) & mask_) {
+            uint64_t key = slots_[index].key.load(std::memory_order_acquire);
+            if (key == order_id) return &slots_[index];
+            if (key == empty_key) return nullptr;
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+    size_t mask_;
+    unsigned shift_;
+    alignas(64) std::atomic<size_t> used_{0};
+};
@@ -1,42 +1,12 @@
 #include <atomic>
 #include <iostream>
 #include <thread>
+#include <vector>
 
-struct Node {
-    int value;
-    Node* next; // raw pointer is fine here
-    Node(int v) : value(v), next(nullptr) {}
-};
-
-class LockFreeList {
-    std::atomic<Node*> head;
-
-public:
-    LockFreeList() : head(nullptr) {}
-
-    void insert(int val) {
-        Node* newNode = new Node(val);
-        Node* oldHead;
-
-        // try until CAS succeeds
-        do {
-            oldHead = head.load();
-            newNode->next = oldHead;
-        } while (!head.compare_exchange_strong(oldHead, newNode));
-    }
-
-    void print() {
-        Node* curr = head.load();
-        while (curr) {
-            std::cout << curr->value << " ";
-            curr = curr->next;
-        }
-        std::cout << "\n";
-    }
-};
+#include "lockFreeList.hpp"
 
 int main() {
-    LockFreeList list;
+    LockFreeList<int> list(1024);
 
     std::thread t1([&]() {
         for (int i = 1; i <= 5; i++) list.insert(i * 10);
@@ -49,6 +19,32 @@ int main() {
     t1.join();
     t2.join();
 
-    list.print();
-}
+    list.for_each([](int value) { std::cout << value << " "; });
+    std::cout << "\n";
+
+    // Concurrent insert/pop churn: nodes are recycled through the pool, so a
+    // small list survives far more operations than it has nodes, without ABA
+    std::atomic<long long> popped_sum{0};
+    std::vector<std::thread> workers;
+    for (int w = 0; w < 4; w++) {
+        workers.emplace_back([&, w]() {
+            long long local = 0;
+            for (int i = 0; i < 100000; i++) {
+                while (!list.insert(w * 100000 + i)) std::this_thread::yield();
+                int value;
+                while (!list.pop(value)) std::this_thread::yield();
+                local += value;
+            }
+            popped_sum += local;
+        });
+    }
+    for (auto& worker : workers) worker.join();
 
+    int value;
+    long long remaining = 0;
+    while (list.pop(value)) remaining += value;
+
+    long long pushed = 10 * 15 + 100 * 15;  // The first ten inserts
+    for (int w = 0; w < 4; w++) pushed += 100000LL * w * 100000 + 100000LL * 99999 / 2;
+    std::cout << (popped_sum + remaining == pushed ? "churn OK" : "churn MISMATCH") << "\n";
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// Nodes live in one fixed array and are named by 32-bit index, so a list head
+// can pack {index, tag} into a single 64-bit word. Every successful CAS bumps
+// the tag, which defeats ABA: a thread that read head A -> B, slept while A
+// was popped, recycled and pushed back, sees a different tag and retries.
+// Nodes are recycled, never freed, so reading a stale node's `next` is safe;
+// the value read is simply discarded when the CAS fails.
+
+template<typename T>
+struct LockFreeNode {
+    T value{};
+    std::atomic<uint32_t> next{0};  // Racy reads from stale poppers are expected, hence atomic
+};
+
+// Treiber stack of node indices over an external node array
+template<typename T>
+class TaggedIndexStack {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit TaggedIndexStack(LockFreeNode<T>* nodes) : nodes_(nodes), head_(pack(npos, 0)) {}
+
+    void push(uint32_t index) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        do {
+            nodes_[index].next.store(index_of(head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head, pack(index, tag_of(head) + 1),
+                                              std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Returns npos if empty
+    uint32_t pop() {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (index_of(head) != npos) {
+            uint32_t next = nodes_[index_of(head)].next.load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, pack(next, tag_of(head) + 1),
+                                            std::memory_order_acquire, std::memory_order_acquire)) {
+                return index_of(head);
+            }
+        }
+        return npos;
+    }
+
+    // Racy snapshot unless the stack is quiescent
+    uint32_t top() const { return index_of(head_.load(std::memory_order_acquire)); }
+
+private:
+    static uint64_t pack(uint32_t index, uint32_t tag) { return (static_cast<uint64_t>(tag) << 32) | index; }
+    static uint32_t index_of(uint64_t word) { return static_cast<uint32_t>(word); }
+    static uint32_t tag_of(uint64_t word) { return static_cast<uint32_t>(word >> 32); }
+
+    LockFreeNode<T>* nodes_;
+    std::atomic<uint64_t> head_;
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+};
+
+// Fixed-capacity pool of nodes handed out and returned lock-free
+template<typename T>
+class LockFreeNodePool {
+public:
+    static constexpr uint32_t npos = TaggedIndexStack<T>::npos;
+
+    explicit LockFreeNodePool(uint32_t capacity)
+        : capacity_(capacity), nodes_(std::make_unique<LockFreeNode<T>[]>(capacity)), free_(nodes_.get()) {
+        if (capacity == npos) {
+            throw std::runtime_error("LockFreeNodePool capacity must be below 2^32 - 1");
+        }
+        for (uint32_t i = capacity; i > 0; --i) {
+            free_.push(i - 1);
+        }
+    }
+
+    // Returns npos when exhausted
+    uint32_t acquire() { return free_.pop(); }
+    void release(uint32_t index) { free_.push(index); }
+
+    LockFreeNode<T>& operator[](uint32_t index) { return nodes_[index]; }
+    const LockFreeNode<T>& operator[](uint32_t index) const { return nodes_[index]; }
+    LockFreeNode<T>* nodes() { return nodes_.get(); }
+    uint32_t capacity() const { return capacity_; }
+
+private:
+    uint32_t capacity_;
+    std::unique_ptr<LockFreeNode<T>[]> nodes_;
+    TaggedIndexStack<T> free_;
+};
+
+// Lock-free LIFO list: insert and pop at the head from any number of threads.
+// Popped nodes go back to the pool, so memory is bounded and never leaks.
+template<typename T>
+class LockFreeList {
+public:
+    explicit LockFreeList(uint32_t capacity) : pool_(capacity), head_(pool_.nodes()) {}
+
+    LockFreeList(const LockFreeList&) = delete;
+    LockFreeList& operator=(const LockFreeList&) = delete;
+
+    // Returns false if all nodes are in use
+    bool insert(const T& value) {
+        uint32_t index = pool_.acquire();
+        if (index == LockFreeNodePool<T>::npos) return false;
+        pool_[index].value = value;
+        head_.push(index);
+        return true;
+    }
+
+    // Returns false if the list is empty
+    bool pop(T& value) {
+        uint32_t index = head_.pop();
+        if (index == LockFreeNodePool<T>::npos) return false;
+        value = pool_[index].value;
+        pool_.release(index);
+        return true;
+    }
+
+    bool empty() const { return head_.top() == LockFreeNodePool<T>::npos; }
+    uint32_t capacity() const { return pool_.capacity(); }
+
+    // Walks the list head to tail; only valid while no other thread modifies it
+    template<typename F>
+    void for_each(F&& f) const {
+        for (uint32_t index = head_.top(); index != LockFreeNodePool<T>::npos;
+             index = pool_[index].next.load(std::memory_order_relaxed)) {
+            f(pool_[index].value);
+        }
+    }
+
+private:
+    LockFreeNodePool<T> pool_;
+    TaggedIndexStack<T> head_;
+};
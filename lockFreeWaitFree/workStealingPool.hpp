@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "chaseLevDeque.hpp"
+#include "../SPSC_QUEUES/mpmc_q.cpp"
+#include "../SPSC_QUEUES/wait_strategy.cpp"
+
+// Work-stealing thread pool for throughput jobs (book rebuilds, end-of-day
+// statistics, analytics), not for the latency path.
+//
+// Every worker owns a Chase-Lev deque: it pushes and takes its own tasks LIFO
+// for cache locality, and idle workers steal the oldest - usually largest -
+// tasks from a random victim. Tasks from outside the pool enter through a
+// shared MpmcFifo. Idle workers park with ParkingWait, so an unused pool
+// costs no CPU.
+//
+// Tasks are intrusive and owned by the submitter; parallel_for() keeps all of
+// its tasks in one array so splitting work never allocates.
+class WorkStealingPool {
+public:
+    static constexpr size_t npos = SIZE_MAX;
+
+    struct Task {
+        void (*execute)(Task& self, WorkStealingPool& pool);
+    };
+
+    explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency())
+        : injection_(1024), wait_(64) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; ++i) {
+            deques_.push_back(std::make_unique<ChaseLevDeque<Task*>>());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i] { worker_main(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Submitted tasks must have finished; parallel_for() guarantees that for its own
+    ~WorkStealingPool() {
+        stopping_.store(true, std::memory_order_release);
+        wait_.wake_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    size_t size() const { return workers_.size(); }
+
+    // Index of the calling worker, or npos outside this pool
+    size_t current_worker() const { return current_pool_ == this ? current_index_ : npos; }
+
+    // From a worker the task goes on its own deque; from any other thread, on the shared queue.
+    // `task` must stay alive until it has run.
+    void submit(Task& task) {
+        size_t self = current_worker();
+        if (self != npos) {
+            deques_[self]->push(&task);
+        } else {
+            while (!injection_.push(&task)) {
+                run_one(npos);  // Full: help drain instead of waiting
+            }
+        }
+        wait_.notify();
+    }
+
+    // Runs f(i) for every i in [begin, end) in chunks of at most `grain` and
+    // returns once all have run. The caller helps by stealing, so calls may
+    // nest inside tasks. The first exception thrown by f is rethrown here.
+    template<typename F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& f) {
+        if (begin >= end) return;
+        if (grain == 0) grain = 1;
+
+        RangeJob<F> job{f, grain, end - begin};
+        // Halving leaves every chunk above grain / 2, which bounds the task count
+        job.tasks.resize((end - begin) / grain * 2 + 2);
+        RangeTask<F>& root = job.tasks[0];
+        root.execute = &RangeTask<F>::run;
+        root.job = &job;
+        root.begin = begin;
+        root.end = end;
+        submit(root);
+
+        size_t self = current_worker();
+        while (job.remaining.load(std::memory_order_acquire) != 0) {
+            if (!run_one(self)) std::this_thread::yield();
+        }
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+private:
+    template<typename F>
+    struct RangeTask;
+
+    template<typename F>
+    struct RangeJob {
+        RangeJob(F& f, size_t grain, size_t items) : f(f), grain(grain), remaining(items) {}
+
+        F& f;
+        size_t grain;
+        std::vector<RangeTask<F>> tasks;
+        std::atomic<size_t> task_cursor{1};  // tasks[0] is the root
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+    };
+
+    template<typename F>
+    struct RangeTask : Task {
+        RangeJob<F>* job = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+
+        static void run(Task& task, WorkStealingPool& pool) {
+            auto& range = static_cast<RangeTask&>(task);
+            RangeJob<F>& job = *range.job;
+            size_t begin = range.begin, end = range.end;
+
+            // Split off the upper half until the chunk is small enough; thieves take the big halves
+            while (end - begin > job.grain) {
+                size_t middle = begin + (end - begin) / 2;
+                RangeTask& right = job.tasks[job.task_cursor.fetch_add(1, std::memory_order_relaxed)];
+                right.execute = &RangeTask::run;
+                right.job = &job;
+                right.begin = middle;
+                right.end = end;
+                pool.submit(right);
+                end = middle;
+            }
+
+            if (!job.failed.load(std::memory_order_relaxed)) {
+                try {
+                    for (size_t i = begin; i < end; ++i) job.f(i);
+                } catch (...) {
+                    if (!job.failed.exchange(true)) job.error = std::current_exception();
+                }
+            }
+            job.remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+        }
+    };
+
+    // Own deque first, then the shared queue, then a random victim
+    bool run_one(size_t self) {
+        Task* task = nullptr;
+        bool found = self != npos && deques_[self]->take(task);
+        if (!found) found = injection_.pop(task);
+        if (!found) {
+            size_t count = deques_.size();
+            size_t start = next_random() % count;
+            for (size_t k = 0; k < count && !found; ++k) {
+                size_t victim = (start + k) % count;
+                if (victim != self) found = deques_[victim]->steal(task);
+            }
+        }
+        if (!found) return false;
+        task->execute(*task, *this);
+        return true;
+    }
+
+    bool has_work() const {
+        if (!injection_.empty()) return true;
+        for (auto& deque : deques_) {
+            if (!deque->empty()) return true;
+        }
+        return false;
+    }
+
+    void worker_main(size_t self) {
+        current_pool_ = this;
+        current_index_ = self;
+        unsigned idle = 0;
+        while (!stopping_.load(std::memory_order_acquire)) {
+            if (run_one(self)) {
+                idle = 0;
+                continue;
+            }
+            wait_.idle(idle++, [&] { return has_work() || stopping_.load(std::memory_order_relaxed); });
+        }
+    }
+
+    static size_t next_random() {
+        thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<size_t>(state);
+    }
+
+    inline static thread_local const WorkStealingPool* current_pool_ = nullptr;
+    inline static thread_local size_t current_index_ = npos;
+
+    std::vector<std::unique_ptr<ChaseLevDeque<Task*>>> deques_;
+    MpmcFifo<Task*> injection_;
+    ParkingWait wait_;
+    std::atomic<bool> stopping_{false};
+    std::vector<std::thread> workers_;
+};